@@ -0,0 +1,146 @@
+# frozen_string_literal: true
+
+# Benchmarks fetching, conversion, binding and execution against the stub libdbcapi_r built from
+# bench/fake_dbcapi.c, no server is needed. Run with `rake bench`, environment variables:
+#
+#   BENCH=fetch              only runs cases whose name contains the given text
+#   BENCH_ROWS=100000        rows fetched, bound or executed by every case
+#   BENCH_RUNS=5             runs of every case, the fastest one is reported
+#   BENCH_LATENCY_US=200     latency of every fetch in the latency case
+#   BENCH_SAVE=file.json     saves the results
+#   BENCH_BASELINE=file.json compares the results with saved ones
+
+require 'json'
+require 'stringio'
+require 'sqlanywhere2'
+
+module SQLAnywhere2
+  class Benchmark
+    Case = Struct.new(:name, :rows, :cells, :block)
+
+    def initialize(rows:, runs:, latency_us:)
+      @rows = rows
+      @runs = runs
+      @latency_us = latency_us
+      @cases = []
+    end
+
+    def connect(**opts)
+      Connection.new(conn_string: 'ServerName=bench', encoding: 'UTF-8', statement_cache_size: 0, **opts)
+    end
+
+    def define_cases
+      fetch_cases
+      conversion_cases
+      bind_cases
+      latency_cases
+    end
+
+    def run(filter)
+      @cases.select { |c| filter.nil? || c.name.include?(filter) }.to_h do |c|
+        [c.name, measure(c)]
+      end
+    end
+
+    private
+
+    def add(name, cells_per_row = 4, rows: @rows, &block)
+      @cases << Case.new(name, rows, rows * cells_per_row, block)
+    end
+
+    def fetch_cases
+      sql = "FAKE rows=#{@rows} cols=int;bigint;double;varchar(32)"
+      cast = connect
+      plain = connect(cast: false)
+      rowset = connect(fetch_size: 1000)
+
+      add('fetch cast') { cast.prepare(sql).execute }
+      add('fetch no-cast') { plain.prepare(sql).execute }
+      add('fetch fetch_size=1000') { rowset.prepare(sql).execute }
+      add('fetch nulls=0.5') { rowset.prepare("#{sql} nulls=0.5").execute }
+      add('fetch varchar(1024)', 2) { rowset.prepare("FAKE rows=#{@rows} cols=int;varchar(1024)").execute }
+      add('each_row') { rowset.prepare(sql).each_row { |_row| nil } }
+      add('columnar') { rowset.prepare(sql).execute(format: :columnar) }
+      add('copy_out csv') { rowset.prepare(sql).copy_out(StringIO.new) }
+    end
+
+    def conversion_cases
+      sql = "FAKE rows=#{@rows} cols=timestamp;date;time;decimal(18,2)"
+      cast = connect(fetch_size: 1000)
+      plain = connect(fetch_size: 1000, cast: false)
+      float = connect(fetch_size: 1000, decimal_as: :float)
+
+      add('convert cast') { cast.prepare(sql).execute }
+      add('convert no-cast') { plain.prepare(sql).execute }
+      add('convert decimal_as=float', 1) { float.prepare("FAKE rows=#{@rows} cols=decimal(18,2)").execute }
+    end
+
+    def bind_cases
+      connection = connect
+      insert = connection.prepare('FAKE ptypes=int;varchar;double;bigint ? ? ? ?')
+      select = connection.prepare('FAKE rows=1 cols=int')
+      rows = Array.new(@rows) { |i| [i, "name #{i}", i * 1.5, i << 32] }
+
+      add('execute bind', 4) { rows.each { |row| insert.execute(*row) } }
+      add('execute_update bind', 4) { rows.each { |row| insert.execute_update(*row) } }
+      add('execute select', 1) { @rows.times { select.execute } }
+      add('execute_batch', 4) { insert.execute_batch(rows, batch_size: 1000) }
+    end
+
+    def latency_cases
+      rows = @rows / 10
+      sql = "FAKE rows=#{rows} cols=int;varchar(32) row_latency_us=#{@latency_us}"
+      connection = connect(fetch_size: 100)
+
+      add("latency row_latency_us=#{@latency_us}", 2, rows: rows) { connection.prepare(sql).execute }
+    end
+
+    # Best time of all runs, allocations of the last one
+    def measure(bench)
+      bench.block.call
+      best = Float::INFINITY
+      allocated = 0
+
+      @runs.times do
+        GC.start
+        objects = GC.stat(:total_allocated_objects)
+        started = Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond)
+        bench.block.call
+        best = [best, Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond) - started].min
+        allocated = GC.stat(:total_allocated_objects) - objects
+      end
+
+      { 'ms' => best / 1e6, 'ns_per_row' => best.fdiv(bench.rows), 'ns_per_cell' => best.fdiv(bench.cells),
+        'allocs_per_row' => allocated.fdiv(bench.rows) }
+    end
+  end
+end
+
+def bench_change(current, baseline, key)
+  return '' unless baseline && baseline[key]&.positive?
+
+  format('%+.1f%%', (current[key] / baseline[key] - 1) * 100)
+end
+
+def bench_report(results, baseline)
+  puts format('%-34s %10s %10s %10s %11s %12s %12s', 'case', 'ms', 'ns/row', 'ns/cell', 'allocs/row', 'ns/cell +/-',
+              'allocs +/-')
+
+  results.each do |name, result|
+    previous = baseline && baseline[name]
+    puts format('%-34s %10.1f %10.1f %10.1f %11.2f %12s %12s', name, result['ms'], result['ns_per_row'],
+                result['ns_per_cell'], result['allocs_per_row'], bench_change(result, previous, 'ns_per_cell'),
+                bench_change(result, previous, 'allocs_per_row'))
+  end
+end
+
+benchmark = SQLAnywhere2::Benchmark.new(rows: Integer(ENV.fetch('BENCH_ROWS', 100_000)),
+                                        runs: Integer(ENV.fetch('BENCH_RUNS', 5)),
+                                        latency_us: Integer(ENV.fetch('BENCH_LATENCY_US', 200)))
+benchmark.define_cases
+results = benchmark.run(ENV.fetch('BENCH', nil))
+baseline = ENV['BENCH_BASELINE'] && JSON.parse(File.read(ENV['BENCH_BASELINE']))
+
+puts "ruby #{RUBY_VERSION}, sqlanywhere2 #{SQLAnywhere2::VERSION}, #{ENV.fetch('BENCH_ROWS', 100_000)} rows"
+bench_report(results, baseline)
+File.write(ENV['BENCH_SAVE'], JSON.pretty_generate(results)) if ENV['BENCH_SAVE']
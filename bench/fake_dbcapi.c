@@ -0,0 +1,848 @@
+/*
+ * Stub libdbcapi_r implementing the sacapi.h entry points used by the extension, so that it can be
+ * benchmarked without a server. Built against sacapi.h of the installed SDK by `rake bench:fake_dbcapi`.
+ *
+ * Statements starting with FAKE describe a synthetic result set with space separated options:
+ *
+ *   FAKE rows=100000 cols=int;bigint;double;varchar(64);decimal(18,2) nulls=0.1 latency_us=200
+ *
+ *   rows=N             number of rows of every result set
+ *   cols=a;b;...       column types: int, bigint, double, bit, varchar, varchar(N), status, binary,
+ *                      longbinary, timestamp, date, time, decimal, decimal(P,S)
+ *   nulls=R            ratio of NULL values, NULLs are placed deterministically
+ *   results=N          number of result sets
+ *   ptypes=a;b;...     described types of ? parameters: int, bigint, double, binary, varchar
+ *   latency_us=N       latency of every execution
+ *   row_latency_us=N   latency of every fetch
+ *   bad_rowset=N       rowsets after row N report a broken row count
+ *
+ * varchar(N) values are exactly N characters long. Other SELECT statements return a single INT,
+ * statements starting with ERROR fail. Bound rows are appended to the file named by FAKE_BIND_LOG,
+ * a bound string FAIL makes the execution fail.
+ */
+#define _SACAPI_VERSION 4
+#include <sacapi.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#define FAKE_MAX_COLS 64
+#define FAKE_VALUE_SIZE 64
+
+struct a_sqlany_connection {
+  int connected;
+  sacapi_i32 error_code;
+  char error[SACAPI_ERROR_SIZE];
+  volatile int cancelled;
+};
+
+typedef struct {
+  a_sqlany_native_type native_type;
+  a_sqlany_data_type type;
+  unsigned short precision;
+  unsigned short scale;
+  size_t max_size;
+  size_t length;
+  char name[32];
+} fake_column;
+
+struct a_sqlany_stmt {
+  a_sqlany_connection *connection;
+  char *sql;
+  int executed;
+  long rows;
+  long pos;
+  double nulls;
+  int latency_us;
+  int row_latency_us;
+  int results;
+  int result;
+  long bad_rowset;
+  sacapi_i32 affected;
+  long sent;
+  int num_cols;
+  fake_column columns[FAKE_MAX_COLS];
+  char *values[FAKE_MAX_COLS];
+  size_t lengths[FAKE_MAX_COLS];
+  sacapi_bool is_null[FAKE_MAX_COLS];
+  union {
+    long long val64;
+    int val32;
+    double val_double;
+    unsigned char val8;
+  } numbers[FAKE_MAX_COLS];
+  int num_params;
+  a_sqlany_data_type param_types[FAKE_MAX_COLS];
+  a_sqlany_data_value params[FAKE_MAX_COLS];
+  sacapi_u32 batch_size;
+  sacapi_u32 rowset_size;
+  int num_bound;
+  a_sqlany_data_value bound[FAKE_MAX_COLS];
+  sacapi_i32 fetched;
+};
+
+static sacapi_u32 api_version = SQLANY_API_VERSION_4;
+
+static sacapi_bool fake_fail(a_sqlany_connection *connection, sacapi_i32 code, const char *message) {
+  connection->error_code = code;
+  snprintf(connection->error, sizeof(connection->error), "%s", message);
+
+  return 0;
+}
+
+/*
+ * Sleeps in 1ms slices, returns 0 if sqlany_cancel was called meanwhile
+ */
+static int fake_wait(a_sqlany_connection *connection, int us) {
+  for (; us > 0 && !connection->cancelled; us -= 1000) {
+    usleep(us < 1000 ? us : 1000);
+  }
+
+  if (connection->cancelled) {
+    connection->cancelled = 0;
+    return fake_fail(connection, -299, "Statement interrupted by user");
+  }
+
+  return 1;
+}
+
+static void fake_add_column(a_sqlany_stmt *stmt, const char *spec) {
+  fake_column *column = &stmt->columns[stmt->num_cols];
+  int precision = 30;
+  int scale = 6;
+  int length = 0;
+
+  memset(column, 0, sizeof(fake_column));
+  snprintf(column->name, sizeof(column->name), "c%d", stmt->num_cols);
+  column->native_type = DT_INT;
+  column->type = A_VAL32;
+  column->max_size = 4;
+
+  if (!strncmp(spec, "bigint", 6)) {
+    column->native_type = DT_BIGINT;
+    column->type = A_VAL64;
+    column->max_size = 8;
+  } else if (!strncmp(spec, "double", 6)) {
+    column->native_type = DT_DOUBLE;
+    column->type = A_DOUBLE;
+    column->max_size = 8;
+  } else if (!strncmp(spec, "bit", 3)) {
+    column->native_type = DT_BIT;
+    column->type = A_VAL8;
+    column->max_size = 1;
+  } else if (!strncmp(spec, "varchar", 7)) {
+    column->native_type = DT_VARCHAR;
+    column->type = A_STRING;
+    column->max_size = sscanf(spec, "varchar(%d)", &length) == 1 && length > 0 ? (size_t)length : 32;
+    column->length = length > 0 ? (size_t)length : 0;
+  } else if (!strncmp(spec, "status", 6)) {
+    column->native_type = DT_VARCHAR;
+    column->type = A_STRING;
+    column->max_size = 8;
+  } else if (!strncmp(spec, "binary", 6)) {
+    column->native_type = DT_BINARY;
+    column->type = A_BINARY;
+    column->max_size = 16;
+  } else if (!strncmp(spec, "longbinary", 10)) {
+    column->native_type = DT_LONGBINARY;
+    column->type = A_BINARY;
+    column->max_size = 0x7fffffff;
+  } else if (!strncmp(spec, "timestamp", 9)) {
+    column->native_type = DT_TIMESTAMP;
+    column->type = A_STRING;
+    column->max_size = 26;
+  } else if (!strncmp(spec, "date", 4)) {
+    column->native_type = DT_DATE;
+    column->type = A_STRING;
+    column->max_size = 10;
+  } else if (!strncmp(spec, "time", 4)) {
+    column->native_type = DT_TIME;
+    column->type = A_STRING;
+    column->max_size = 15;
+  } else if (!strncmp(spec, "decimal", 7)) {
+    sscanf(spec, "decimal(%d,%d)", &precision, &scale);
+    column->native_type = DT_DECIMAL;
+    column->type = A_STRING;
+    column->precision = (unsigned short)precision;
+    column->scale = (unsigned short)scale;
+    column->max_size = (size_t)precision + 2;
+  }
+
+  stmt->values[stmt->num_cols] = malloc(column->length > FAKE_VALUE_SIZE ? column->length : FAKE_VALUE_SIZE);
+  stmt->num_cols++;
+}
+
+static a_sqlany_data_type fake_param_type(const char *spec) {
+  if (!strcmp(spec, "int")) {
+    return A_VAL32;
+  } else if (!strcmp(spec, "bigint")) {
+    return A_VAL64;
+  } else if (!strcmp(spec, "double")) {
+    return A_DOUBLE;
+  } else if (!strcmp(spec, "binary")) {
+    return A_BINARY;
+  }
+
+  return A_STRING;
+}
+
+static void fake_parse_sql(a_sqlany_stmt *stmt) {
+  char *options;
+  char *option;
+  char *save = NULL;
+  char *item;
+  char *item_save = NULL;
+  const char *c;
+  int i;
+
+  stmt->results = 1;
+
+  for (c = stmt->sql; *c; c++) {
+    stmt->num_params += *c == '?';
+  }
+
+  if (strncmp(stmt->sql, "FAKE", 4) != 0) {
+    if (!strncasecmp(stmt->sql, "SELECT", 6)) {
+      stmt->rows = 1;
+      fake_add_column(stmt, "int");
+    }
+
+    return;
+  }
+
+  options = strdup(stmt->sql + 4);
+
+  for (option = strtok_r(options, " ", &save); option; option = strtok_r(NULL, " ", &save)) {
+    if (!strncmp(option, "rows=", 5)) {
+      stmt->rows = atol(option + 5);
+    } else if (!strncmp(option, "nulls=", 6)) {
+      stmt->nulls = atof(option + 6);
+    } else if (!strncmp(option, "latency_us=", 11)) {
+      stmt->latency_us = atoi(option + 11);
+    } else if (!strncmp(option, "row_latency_us=", 15)) {
+      stmt->row_latency_us = atoi(option + 15);
+    } else if (!strncmp(option, "bad_rowset=", 11)) {
+      stmt->bad_rowset = atol(option + 11);
+    } else if (!strncmp(option, "results=", 8)) {
+      stmt->results = atoi(option + 8);
+    } else if (!strncmp(option, "ptypes=", 7)) {
+      item = strtok_r(option + 7, ";", &item_save);
+
+      for (i = 0; item && i < FAKE_MAX_COLS; item = strtok_r(NULL, ";", &item_save), i++) {
+        stmt->param_types[i] = fake_param_type(item);
+      }
+    } else if (!strncmp(option, "cols=", 5)) {
+      item = strtok_r(option + 5, ";", &item_save);
+
+      for (; item && stmt->num_cols < FAKE_MAX_COLS; item = strtok_r(NULL, ";", &item_save)) {
+        fake_add_column(stmt, item);
+      }
+    }
+  }
+
+  free(options);
+}
+
+/*
+ * Generates values of the current row, they only depend on the row number
+ */
+static void fake_fill_row(a_sqlany_stmt *stmt) {
+  static const char *statuses[] = {"NEW", "DONE", "FAILED"};
+  fake_column *column;
+  char *value;
+  long r = stmt->pos;
+  size_t k;
+  int i;
+
+  for (i = 0; i < stmt->num_cols; i++) {
+    column = &stmt->columns[i];
+    value = stmt->values[i];
+    stmt->is_null[i] = stmt->nulls > 0 && (r * 31 + i * 17) % 1000 < (long)(stmt->nulls * 1000);
+
+    switch (column->native_type) {
+    case DT_INT:
+      stmt->numbers[i].val32 = (int)(r + i);
+      stmt->lengths[i] = 4;
+      break;
+    case DT_BIGINT:
+      stmt->numbers[i].val64 = r * 1000003LL + i;
+      stmt->lengths[i] = 8;
+      break;
+    case DT_DOUBLE:
+      stmt->numbers[i].val_double = r * 1.5;
+      stmt->lengths[i] = 8;
+      break;
+    case DT_BIT:
+      stmt->numbers[i].val8 = r & 1;
+      stmt->lengths[i] = 1;
+      break;
+    case DT_VARCHAR:
+      if (column->length > 0) {
+        stmt->lengths[i] = column->length;
+        k = (size_t)snprintf(value, column->length + 1 < 32 ? column->length + 1 : 32, "row %ld ", r);
+
+        for (k = k < column->length ? k : column->length; k < column->length; k++) {
+          value[k] = (char)('a' + (r + k) % 26);
+        }
+      } else if (column->max_size == 8) {
+        stmt->lengths[i] = (size_t)snprintf(value, FAKE_VALUE_SIZE, "%s", statuses[r % 3]);
+      } else {
+        stmt->lengths[i] = (size_t)snprintf(value, FAKE_VALUE_SIZE, "row %ld value, \"quoted\"", r);
+      }
+      break;
+    case DT_BINARY:
+      memset(value, (int)(r & 0xff), 16);
+      stmt->lengths[i] = 16;
+      break;
+    case DT_LONGBINARY:
+      for (k = 0; k < 40; k++) {
+        value[k] = (char)('a' + (r + k) % 26);
+      }
+      stmt->lengths[i] = 40;
+      break;
+    case DT_TIMESTAMP:
+      stmt->lengths[i] = (size_t)snprintf(
+        value,
+        FAKE_VALUE_SIZE,
+        "20%02ld-%02ld-%02ld %02ld:%02ld:%02ld.%06ld",
+        r % 30, r % 12 + 1, r % 28 + 1, r % 24, r % 60, (r * 7) % 60, (r * 1234) % 1000000
+      );
+      break;
+    case DT_DATE:
+      stmt->lengths[i] = (size_t)snprintf(value, FAKE_VALUE_SIZE, "19%02ld-%02ld-%02ld", r % 100, r % 12 + 1, r % 28 + 1);
+      break;
+    case DT_TIME:
+      stmt->lengths[i] = (size_t)snprintf(value, FAKE_VALUE_SIZE, "%02ld:%02ld:%02ld.%03ld", r % 24, r % 60, r % 60, r % 1000);
+      break;
+    case DT_DECIMAL:
+      if (column->scale == 0) {
+        stmt->lengths[i] = (size_t)snprintf(value, FAKE_VALUE_SIZE, "%s%ld", r % 5 == 4 ? "-" : "", r * 1000003L);
+      } else {
+        stmt->lengths[i] = (size_t)snprintf(
+          value, FAKE_VALUE_SIZE, "%s%ld.%0*ld", r % 5 == 4 ? "-" : "", r, (int)column->scale, r % 100
+        );
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static char *fake_value_buffer(a_sqlany_stmt *stmt, int i) {
+  if (stmt->columns[i].type == A_STRING || stmt->columns[i].type == A_BINARY) {
+    return stmt->values[i];
+  }
+
+  return (char *)&stmt->numbers[i];
+}
+
+/*
+ * Copies the current row into element k of bound column arrays
+ */
+static void fake_copy_bound(a_sqlany_stmt *stmt, sacapi_i32 k) {
+  a_sqlany_data_value *bound;
+  int i;
+
+  for (i = 0; i < stmt->num_bound; i++) {
+    bound = &stmt->bound[i];
+    bound->is_null[k] = stmt->is_null[i];
+    bound->length[k] = stmt->lengths[i];
+    memcpy(
+      bound->buffer + bound->buffer_size * k,
+      fake_value_buffer(stmt, i),
+      stmt->lengths[i] < bound->buffer_size ? stmt->lengths[i] : bound->buffer_size
+    );
+  }
+}
+
+static void fake_log_value(FILE *log, a_sqlany_data_value *value, const char *buffer, size_t length) {
+  size_t k;
+
+  switch (value->type) {
+  case A_VAL64:
+    fprintf(log, "%lld", *(const long long *)buffer);
+    break;
+  case A_UVAL64:
+    fprintf(log, "%llu", *(const unsigned long long *)buffer);
+    break;
+  case A_VAL32:
+    fprintf(log, "%d", *(const int *)buffer);
+    break;
+  case A_DOUBLE:
+    fprintf(log, "%.17g", *(const double *)buffer);
+    break;
+  case A_VAL8:
+  case A_UVAL8:
+    fprintf(log, "%d", *(const unsigned char *)buffer);
+    break;
+  case A_BINARY:
+    fputs("0x", log);
+
+    for (k = 0; k < length; k++) {
+      fprintf(log, "%02x", (unsigned char)buffer[k]);
+    }
+    break;
+  default:
+    fwrite(buffer, 1, length, log);
+    break;
+  }
+}
+
+/*
+ * Appends bound rows to FAKE_BIND_LOG, returns 0 if a bound string is FAIL
+ */
+static int fake_check_params(a_sqlany_stmt *stmt) {
+  const char *path = getenv("FAKE_BIND_LOG");
+  FILE *log = path ? fopen(path, "a") : NULL;
+  sacapi_u32 rows = stmt->batch_size > 1 ? stmt->batch_size : 1;
+  a_sqlany_data_value *value;
+  const char *buffer;
+  size_t length;
+  sacapi_u32 r;
+  int ok = 1;
+  int i;
+
+  for (r = 0; r < rows; r++) {
+    for (i = 0; i < stmt->num_params && i < FAKE_MAX_COLS; i++) {
+      value = &stmt->params[i];
+      buffer = value->buffer ? value->buffer + (rows > 1 ? value->buffer_size * r : 0) : NULL;
+      length = value->length ? value->length[rows > 1 ? r : 0] : 0;
+
+      if (log && i > 0) {
+        fputc('|', log);
+      }
+
+      if (value->is_null && value->is_null[rows > 1 ? r : 0]) {
+        if (log) {
+          fputs("NULL", log);
+        }
+        continue;
+      }
+
+      if (buffer == NULL) {
+        continue;
+      }
+
+      if ((value->type == A_STRING || value->type == A_BINARY) && length == 4 && !memcmp(buffer, "FAIL", 4)) {
+        ok = 0;
+      }
+
+      if (log) {
+        fake_log_value(log, value, buffer, length);
+      }
+    }
+
+    if (log) {
+      fputc('\n', log);
+    }
+  }
+
+  if (log) {
+    fclose(log);
+  }
+
+  return ok;
+}
+
+sacapi_bool sqlany_init(const char *app_name, sacapi_u32 version, sacapi_u32 *version_available) {
+  if (version_available) {
+    *version_available = SQLANY_API_VERSION_4;
+  }
+
+  if (version > SQLANY_API_VERSION_4) {
+    return 0;
+  }
+
+  api_version = version;
+
+  return 1;
+}
+
+void sqlany_fini(void) {
+}
+
+a_sqlany_connection *sqlany_new_connection(void) {
+  return calloc(1, sizeof(a_sqlany_connection));
+}
+
+void sqlany_free_connection(a_sqlany_connection *connection) {
+  free(connection);
+}
+
+sacapi_bool sqlany_connect(a_sqlany_connection *connection, const char *str) {
+  connection->connected = 1;
+
+  return 1;
+}
+
+sacapi_bool sqlany_disconnect(a_sqlany_connection *connection) {
+  connection->connected = 0;
+
+  return 1;
+}
+
+sacapi_bool sqlany_execute_immediate(a_sqlany_connection *connection, const char *sql) {
+  if (!connection->connected) {
+    return fake_fail(connection, -101, "Not connected to a database");
+  }
+
+  if (!strncmp(sql, "ERROR", 5)) {
+    return fake_fail(connection, -131, "Syntax error");
+  }
+
+  return 1;
+}
+
+a_sqlany_stmt *sqlany_prepare(a_sqlany_connection *connection, const char *sql) {
+  a_sqlany_stmt *stmt;
+
+  if (!connection->connected) {
+    fake_fail(connection, -101, "Not connected to a database");
+    return NULL;
+  }
+
+  if (!strncmp(sql, "ERROR", 5)) {
+    fake_fail(connection, -131, "Syntax error");
+    return NULL;
+  }
+
+  stmt = calloc(1, sizeof(a_sqlany_stmt));
+  stmt->connection = connection;
+  stmt->sql = strdup(sql);
+  fake_parse_sql(stmt);
+
+  return stmt;
+}
+
+void sqlany_free_stmt(a_sqlany_stmt *stmt) {
+  int i;
+
+  if (stmt == NULL) {
+    return;
+  }
+
+  for (i = 0; i < stmt->num_cols; i++) {
+    free(stmt->values[i]);
+  }
+
+  free(stmt->sql);
+  free(stmt);
+}
+
+sacapi_i32 sqlany_num_params(a_sqlany_stmt *stmt) {
+  return stmt->num_params;
+}
+
+sacapi_bool sqlany_describe_bind_param(a_sqlany_stmt *stmt, sacapi_u32 index, a_sqlany_bind_param *param) {
+  // Older API versions have no is_address field
+  memset(param, 0, api_version >= SQLANY_API_VERSION_4 ? sizeof(*param) : sizeof(*param) - sizeof(sacapi_bool) * 2);
+  param->direction = DD_INPUT;
+  param->value.type = index < FAKE_MAX_COLS && stmt->param_types[index] ? stmt->param_types[index] : A_STRING;
+
+  return 1;
+}
+
+sacapi_bool sqlany_bind_param(a_sqlany_stmt *stmt, sacapi_u32 index, a_sqlany_bind_param *param) {
+  if (index >= (sacapi_u32)stmt->num_params || index >= FAKE_MAX_COLS) {
+    return fake_fail(stmt->connection, -689, "Input parameter index out of range");
+  }
+
+  stmt->params[index] = param->value;
+
+  return 1;
+}
+
+/*
+ * Affected rows of an execution with streamed params are the bytes sent plus 1000000 per chunk
+ */
+sacapi_bool sqlany_send_param_data(a_sqlany_stmt *stmt, sacapi_u32 index, char *buffer, size_t size) {
+  stmt->sent += (long)size + 1000000;
+
+  return 1;
+}
+
+sacapi_bool sqlany_reset(a_sqlany_stmt *stmt) {
+  stmt->executed = 0;
+  stmt->pos = 0;
+  stmt->result = 0;
+
+  return 1;
+}
+
+sacapi_bool sqlany_get_bind_param_info(a_sqlany_stmt *stmt, sacapi_u32 index, a_sqlany_bind_param_info *info) {
+  memset(info, 0, api_version >= SQLANY_API_VERSION_4 ? sizeof(*info) : offsetof(a_sqlany_bind_param_info, native_type));
+  info->direction = DD_INPUT;
+
+  return 1;
+}
+
+sacapi_bool sqlany_execute(a_sqlany_stmt *stmt) {
+  stmt->connection->cancelled = 0;
+
+  if (stmt->latency_us && !fake_wait(stmt->connection, stmt->latency_us)) {
+    return 0;
+  }
+
+  if (stmt->num_params && !fake_check_params(stmt)) {
+    return fake_fail(stmt->connection, -193, "Primary key for table is not unique");
+  }
+
+  stmt->executed = 1;
+  stmt->pos = 0;
+  stmt->result = 0;
+
+  if (stmt->num_cols > 0) {
+    stmt->affected = (sacapi_i32)stmt->rows;
+  } else if (stmt->sent > 0) {
+    stmt->affected = (sacapi_i32)stmt->sent;
+  } else {
+    stmt->affected = stmt->batch_size > 1 ? (sacapi_i32)stmt->batch_size : 1;
+  }
+
+  stmt->sent = 0;
+
+  return 1;
+}
+
+a_sqlany_stmt *sqlany_execute_direct(a_sqlany_connection *connection, const char *sql) {
+  a_sqlany_stmt *stmt = sqlany_prepare(connection, sql);
+
+  if (stmt && !sqlany_execute(stmt)) {
+    sqlany_free_stmt(stmt);
+    return NULL;
+  }
+
+  return stmt;
+}
+
+sacapi_bool sqlany_fetch_next(a_sqlany_stmt *stmt) {
+  sacapi_i32 k;
+
+  stmt->fetched = 0;
+
+  if (stmt->row_latency_us && stmt->executed && stmt->pos < stmt->rows) {
+    if (!fake_wait(stmt->connection, stmt->row_latency_us)) {
+      return 0;
+    }
+  }
+
+  if (!stmt->executed || stmt->pos >= stmt->rows) {
+    return fake_fail(stmt->connection, 100, "Row not found");
+  }
+
+  if (stmt->rowset_size > 1 && stmt->num_bound > 0) {
+    for (k = 0; k < (sacapi_i32)stmt->rowset_size && stmt->pos < stmt->rows; k++) {
+      fake_fill_row(stmt);
+      fake_copy_bound(stmt, k);
+      stmt->pos++;
+    }
+
+    stmt->fetched = k;
+
+    if (stmt->bad_rowset && stmt->pos > stmt->bad_rowset) {
+      stmt->fetched = (sacapi_i32)stmt->rowset_size + 5;
+    }
+
+    return 1;
+  }
+
+  fake_fill_row(stmt);
+  stmt->pos++;
+  stmt->fetched = 1;
+
+  return 1;
+}
+
+sacapi_bool sqlany_fetch_absolute(a_sqlany_stmt *stmt, sacapi_i32 row_num) {
+  long r = row_num < 0 ? stmt->rows + row_num : row_num - 1;
+
+  if (!stmt->executed || r < 0 || r >= stmt->rows) {
+    return fake_fail(stmt->connection, 100, "Row not found");
+  }
+
+  stmt->pos = r;
+  fake_fill_row(stmt);
+  stmt->pos++;
+
+  return 1;
+}
+
+sacapi_bool sqlany_get_next_result(a_sqlany_stmt *stmt) {
+  if (stmt->result + 1 >= stmt->results) {
+    return 0;
+  }
+
+  stmt->result++;
+  stmt->pos = 0;
+
+  return 1;
+}
+
+sacapi_i32 sqlany_affected_rows(a_sqlany_stmt *stmt) {
+  return stmt->affected;
+}
+
+sacapi_i32 sqlany_num_cols(a_sqlany_stmt *stmt) {
+  return stmt->num_cols;
+}
+
+sacapi_i32 sqlany_num_rows(a_sqlany_stmt *stmt) {
+  return (sacapi_i32)stmt->rows;
+}
+
+sacapi_bool sqlany_get_column(a_sqlany_stmt *stmt, sacapi_u32 index, a_sqlany_data_value *value) {
+  if (index >= (sacapi_u32)stmt->num_cols) {
+    return 0;
+  }
+
+  value->type = stmt->columns[index].type;
+  value->is_null = &stmt->is_null[index];
+  value->length = &stmt->lengths[index];
+  value->buffer_size = stmt->lengths[index];
+  value->buffer = fake_value_buffer(stmt, (int)index);
+
+  return 1;
+}
+
+sacapi_i32 sqlany_get_data(a_sqlany_stmt *stmt, sacapi_u32 index, size_t offset, void *buffer, size_t size) {
+  size_t left;
+
+  if (index >= (sacapi_u32)stmt->num_cols || offset > stmt->lengths[index]) {
+    return -1;
+  }
+
+  left = stmt->lengths[index] - offset;
+  left = left > size ? size : left;
+  memcpy(buffer, fake_value_buffer(stmt, (int)index) + offset, left);
+
+  return (sacapi_i32)left;
+}
+
+sacapi_bool sqlany_get_data_info(a_sqlany_stmt *stmt, sacapi_u32 index, a_sqlany_data_info *info) {
+  if (index >= (sacapi_u32)stmt->num_cols) {
+    return 0;
+  }
+
+  info->type = stmt->columns[index].type;
+  info->is_null = stmt->is_null[index];
+  info->data_size = stmt->lengths[index];
+
+  return 1;
+}
+
+sacapi_bool sqlany_get_column_info(a_sqlany_stmt *stmt, sacapi_u32 index, a_sqlany_column_info *info) {
+  fake_column *column;
+
+  if (index >= (sacapi_u32)stmt->num_cols) {
+    return 0;
+  }
+
+  column = &stmt->columns[index];
+
+  memset(info, 0, api_version >= SQLANY_API_VERSION_4 ? sizeof(*info) : offsetof(a_sqlany_column_info, table_name));
+  info->name = column->name;
+  info->type = column->type;
+  info->native_type = column->native_type;
+  info->precision = column->precision;
+  info->scale = column->scale;
+  info->max_size = column->max_size;
+  info->nullable = 1;
+
+  return 1;
+}
+
+sacapi_bool sqlany_commit(a_sqlany_connection *connection) {
+  return connection->connected;
+}
+
+sacapi_bool sqlany_rollback(a_sqlany_connection *connection) {
+  return connection->connected;
+}
+
+sacapi_bool sqlany_client_version(char *buffer, size_t len) {
+  snprintf(buffer, len, "17.0.0.0");
+
+  return 1;
+}
+
+sacapi_i32 sqlany_error(a_sqlany_connection *connection, char *buffer, size_t size) {
+  if (buffer) {
+    snprintf(buffer, size, "%s", connection->error);
+  }
+
+  return connection->error_code;
+}
+
+size_t sqlany_sqlstate(a_sqlany_connection *connection, char *buffer, size_t size) {
+  snprintf(buffer, size, "%s", connection->error_code ? "42000" : "00000");
+
+  return 6;
+}
+
+void sqlany_clear_error(a_sqlany_connection *connection) {
+  connection->error_code = 0;
+  connection->error[0] = 0;
+}
+
+void sqlany_cancel(a_sqlany_connection *connection) {
+  connection->cancelled = 1;
+}
+
+sacapi_bool sqlany_set_batch_size(a_sqlany_stmt *stmt, sacapi_u32 num_rows) {
+  stmt->batch_size = num_rows;
+
+  return 1;
+}
+
+sacapi_bool sqlany_set_param_bind_type(a_sqlany_stmt *stmt, size_t row_size) {
+  return 1;
+}
+
+sacapi_u32 sqlany_get_batch_size(a_sqlany_stmt *stmt) {
+  return stmt->batch_size > 1 ? stmt->batch_size : 1;
+}
+
+sacapi_bool sqlany_set_rowset_size(a_sqlany_stmt *stmt, sacapi_u32 num_rows) {
+  stmt->rowset_size = num_rows;
+
+  return 1;
+}
+
+sacapi_u32 sqlany_get_rowset_size(a_sqlany_stmt *stmt) {
+  return stmt->rowset_size > 1 ? stmt->rowset_size : 1;
+}
+
+sacapi_bool sqlany_set_column_bind_type(a_sqlany_stmt *stmt, sacapi_u32 row_size) {
+  return 1;
+}
+
+sacapi_bool sqlany_bind_column(a_sqlany_stmt *stmt, sacapi_u32 index, a_sqlany_data_value *value) {
+  if (index >= (sacapi_u32)stmt->num_cols) {
+    return 0;
+  }
+
+  stmt->bound[index] = *value;
+  stmt->num_bound = (int)index + 1 > stmt->num_bound ? (int)index + 1 : stmt->num_bound;
+
+  return 1;
+}
+
+sacapi_bool sqlany_clear_column_bindings(a_sqlany_stmt *stmt) {
+  stmt->num_bound = 0;
+
+  return 1;
+}
+
+sacapi_i32 sqlany_fetched_rows(a_sqlany_stmt *stmt) {
+  return stmt->fetched;
+}
+
+sacapi_bool sqlany_get_rowset_pos(a_sqlany_stmt *stmt, sacapi_u32 *row_num) {
+  *row_num = 0;
+
+  return 1;
+}
@@ -0,0 +1,525 @@
+#include <sqlanywhere2.h>
+#include <ruby/io.h>
+
+extern VALUE mSQLAnywhere2, cSQLAnywhere2Error;
+static VALUE cSQLAnywhere2AsyncResult;
+static ID intern_for_fd;
+
+// Workers are started on demand, further jobs wait in the queue
+#define ASYNC_MAX_WORKERS 256
+
+/*
+ * Handle returned by execute_async, result is built once by value
+ */
+typedef struct {
+  sqlanywhere_async_job *job;
+  sqlanywhere_connection_wrapper *connection_wrapper;
+  VALUE connection;
+  VALUE statement;
+  VALUE io;
+  VALUE stream;
+  VALUE as;
+  VALUE value;
+  int finished;
+} sqlanywhere_async_wrapper;
+
+#define GET_ASYNC(self) \
+  sqlanywhere_async_wrapper *async_wrapper; \
+  Data_Get_Struct(self, sqlanywhere_async_wrapper, async_wrapper);
+
+static void *sqlanywhere_async_run(void *ptr);
+
+// Finished jobs whose statement was freed while running, their binds are freed by rb_sqlanywhere_async_sweep
+static sqlanywhere_async_job *async_abandoned = NULL;
+
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t async_finished = PTHREAD_COND_INITIALIZER;
+static sqlanywhere_async_job *async_head = NULL;
+static sqlanywhere_async_job *async_tail = NULL;
+static int async_workers = 0;
+static int async_idle = 0;
+
+static void *sqlanywhere_async_worker(void *ptr) {
+  sqlanywhere_async_job *job;
+
+  pthread_mutex_lock(&async_mutex);
+
+  for (;;) {
+    while (async_head == NULL) {
+      async_idle++;
+      pthread_cond_wait(&async_queued, &async_mutex);
+      async_idle--;
+    }
+
+    job = async_head;
+    async_head = job->next;
+
+    if (async_head == NULL) {
+      async_tail = NULL;
+    }
+
+    pthread_mutex_unlock(&async_mutex);
+    sqlanywhere_async_run(job);
+    pthread_mutex_lock(&async_mutex);
+  }
+
+  return NULL;
+}
+
+// Workers and queued jobs of the parent process do not exist in forked child
+static void sqlanywhere_async_atfork_child(void) {
+  pthread_mutex_init(&async_mutex, NULL);
+  pthread_cond_init(&async_queued, NULL);
+  pthread_cond_init(&async_finished, NULL);
+  async_head = NULL;
+  async_tail = NULL;
+  async_workers = 0;
+  async_idle = 0;
+}
+
+/*
+ * Returns 0 if job could not be queued, it is then run by the calling thread
+ */
+static int sqlanywhere_async_submit(sqlanywhere_async_job *job) {
+  pthread_t thread;
+
+  pthread_mutex_lock(&async_mutex);
+
+  if (async_idle == 0 && async_workers < ASYNC_MAX_WORKERS) {
+    if (pthread_create(&thread, NULL, sqlanywhere_async_worker, NULL) == 0) {
+      pthread_detach(thread);
+      async_workers++;
+    } else if (async_workers == 0) {
+      pthread_mutex_unlock(&async_mutex);
+      return 0;
+    }
+  }
+
+  job->next = NULL;
+
+  if (async_tail) {
+    async_tail->next = job;
+  } else {
+    async_head = job;
+  }
+
+  async_tail = job;
+
+  pthread_cond_signal(&async_queued);
+  pthread_mutex_unlock(&async_mutex);
+
+  return 1;
+}
+
+#define ASYNC_LOCK() pthread_mutex_lock(&async_mutex)
+#define ASYNC_UNLOCK() pthread_mutex_unlock(&async_mutex)
+#define ASYNC_SIGNAL() pthread_cond_broadcast(&async_finished)
+#define ASYNC_WAIT() pthread_cond_wait(&async_finished, &async_mutex)
+
+#else
+
+static int sqlanywhere_async_submit(sqlanywhere_async_job *job) {
+  return 0;
+}
+
+#define ASYNC_LOCK()
+#define ASYNC_UNLOCK()
+#define ASYNC_SIGNAL()
+#define ASYNC_WAIT()
+
+#endif
+
+/*
+ * Executes job on a worker, errors are copied out since connection error is overwritten by the next request
+ */
+static void *sqlanywhere_async_run(void *ptr) {
+  sqlanywhere_async_job *job = ptr;
+  sacapi_bool result;
+  a_sqlany_stmt *stmt;
+  int free_connection;
+  char signal = 1;
+
+  uint64_t started = sqlanywhere_stats_clock();
+
+  if (job->sql) {
+    job->stmt = sqlany_execute_direct(job->connection, job->sql);
+    result = job->stmt != NULL;
+  } else {
+    result = sqlany_execute(job->stmt);
+  }
+
+  job->execute_ns = sqlanywhere_stats_clock() - started;
+
+  if (!result) {
+    job->error_code = sqlany_error(job->connection, job->error, SACAPI_ERROR_SIZE);
+    sqlany_sqlstate(job->connection, job->sql_state, SACAPI_ERROR_SIZE);
+    sqlany_clear_error(job->connection);
+  }
+
+  ASYNC_LOCK();
+
+  // Statement was freed while the job was running, it must be gone before done lets the connection close
+  while (job->free_stmt && job->stmt) {
+    stmt = job->stmt;
+    job->stmt = NULL;
+    ASYNC_UNLOCK();
+    sqlany_free_stmt(stmt);
+    ASYNC_LOCK();
+  }
+
+  job->result = result;
+  job->done = 1;
+  free_connection = job->free_connection;
+  ASYNC_SIGNAL();
+  ASYNC_UNLOCK();
+
+  if (write(job->fd, &signal, 1) < 0) {
+    // Reader already gone, nobody waits for the signal
+  }
+
+  close(job->fd);
+
+  // Connection was freed while the job was running
+  if (free_connection) {
+    sqlany_disconnect(job->connection);
+    sqlany_free_connection(job->connection);
+  }
+
+  if (job->binds) {
+    // Reference of the worker moves to the abandoned list
+    ASYNC_LOCK();
+    job->next = async_abandoned;
+    async_abandoned = job;
+    ASYNC_UNLOCK();
+  } else {
+    sqlanywhere_async_release(job);
+  }
+
+  return NULL;
+}
+
+static void sqlanywhere_async_cancel(void *ptr) {
+  sqlanywhere_async_job *job = ptr;
+
+  sqlany_cancel(job->connection);
+}
+
+int sqlanywhere_async_done(sqlanywhere_async_job *job) {
+  int done;
+
+  ASYNC_LOCK();
+  done = job->done;
+  ASYNC_UNLOCK();
+
+  return done;
+}
+
+/*
+ * Blocks until worker finishes the job
+ */
+void *sqlanywhere_async_wait(void *ptr) {
+  sqlanywhere_async_job *job = ptr;
+
+  ASYNC_LOCK();
+
+  while (!job->done) {
+    ASYNC_WAIT();
+  }
+
+  ASYNC_UNLOCK();
+
+  return NULL;
+}
+
+void sqlanywhere_async_release(sqlanywhere_async_job *job) {
+  int refcount;
+
+  ASYNC_LOCK();
+  refcount = --job->refcount;
+  ASYNC_UNLOCK();
+
+  if (refcount == 0) {
+    free(job->sql);
+    free(job);
+  }
+}
+
+/*
+ * Cancels job whose owner is being freed without waiting for it, the worker then frees stmt and/or connection
+ * and binds are kept until rb_sqlanywhere_async_sweep finds the job finished
+ * Returns 0 if job is already done and the caller frees them itself
+ * Cancel is sent under the lock, so the worker can't free the connection meanwhile
+ */
+int sqlanywhere_async_abandon(sqlanywhere_async_job *job, int free_stmt, int free_connection, void *binds, sacapi_i32 num_binds) {
+  int running;
+
+  ASYNC_LOCK();
+  running = !job->done;
+
+  if (running) {
+    job->free_stmt |= free_stmt;
+    job->free_connection |= free_connection;
+
+    if (binds) {
+      job->binds = binds;
+      job->num_binds = num_binds;
+    }
+
+    sqlany_cancel(job->connection);
+  }
+
+  ASYNC_UNLOCK();
+
+  return running;
+}
+
+/*
+ * Frees binds of abandoned jobs once their worker is done, xfree needs the GVL
+ */
+void rb_sqlanywhere_async_sweep(void) {
+  sqlanywhere_async_job *job;
+  sqlanywhere_async_job *next;
+
+  ASYNC_LOCK();
+  job = async_abandoned;
+  async_abandoned = NULL;
+  ASYNC_UNLOCK();
+
+  for (; job != NULL; job = next) {
+    next = job->next;
+    sqlanywhere_stmt_free_binds(job->binds, job->num_binds);
+    sqlanywhere_async_release(job);
+  }
+}
+
+/*
+ * Cancels job if it is still running and waits for it without the GVL
+ */
+void rb_sqlanywhere_async_cancel_wait(sqlanywhere_async_job *job) {
+  if (!sqlanywhere_async_done(job)) {
+    sqlany_cancel(job->connection);
+    rb_thread_call_without_gvl(sqlanywhere_async_wait, job, sqlanywhere_async_cancel, job);
+  }
+}
+
+static void rb_sqlanywhere_async_mark(void *ptr) {
+  sqlanywhere_async_wrapper *async_wrapper = ptr;
+  if (!async_wrapper) return;
+
+  rb_gc_mark(async_wrapper->connection);
+  rb_gc_mark(async_wrapper->statement);
+  rb_gc_mark(async_wrapper->io);
+  rb_gc_mark(async_wrapper->as);
+  rb_gc_mark(async_wrapper->value);
+}
+
+static void rb_sqlanywhere_async_free(void *ptr) {
+  sqlanywhere_async_wrapper *async_wrapper = ptr;
+  sqlanywhere_async_job *job = async_wrapper->job;
+
+  rb_sqlanywhere_async_sweep();
+
+  if (job) {
+    // Statement created by execute_direct was never wrapped, a running worker frees it once done
+    if (
+      sqlanywhere_connection_owned(async_wrapper->connection_wrapper) &&
+      !sqlanywhere_async_abandon(job, job->sql != NULL, 0, NULL, 0) &&
+      job->sql &&
+      job->stmt
+    ) {
+      sqlany_free_stmt(job->stmt);
+    }
+
+    sqlanywhere_async_release(job);
+  }
+
+  decr_sqlanywhere_connection(async_wrapper->connection_wrapper);
+  xfree(async_wrapper);
+}
+
+/*
+ * Starts execution of sql, or of prepared statement which already has its parameters bound
+ */
+VALUE rb_sqlanywhere_async_new(VALUE connection, VALUE statement, VALUE sql, VALUE stream, VALUE as) {
+  sqlanywhere_async_wrapper *async_wrapper;
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  sqlanywhere_async_job *job;
+  int fds[2];
+  VALUE self;
+
+  rb_sqlanywhere_async_sweep();
+
+  self = Data_Make_Struct(
+    cSQLAnywhere2AsyncResult,
+    sqlanywhere_async_wrapper,
+    rb_sqlanywhere_async_mark,
+    rb_sqlanywhere_async_free,
+    async_wrapper
+  );
+
+  async_wrapper->connection = connection;
+  async_wrapper->connection_wrapper = DATA_PTR(connection);
+  async_wrapper->connection_wrapper->refcount++;
+  async_wrapper->statement = statement;
+  async_wrapper->io = Qnil;
+  async_wrapper->stream = stream;
+  async_wrapper->as = as;
+  async_wrapper->value = Qnil;
+  async_wrapper->finished = 0;
+
+  if (rb_cloexec_pipe(fds) < 0) {
+    rb_sys_fail("pipe");
+  }
+
+  async_wrapper->io = rb_funcall(rb_cIO, intern_for_fd, 1, INT2NUM(fds[0]));
+
+  job = calloc(1, sizeof(sqlanywhere_async_job));
+
+  if (job == NULL) {
+    close(fds[1]);
+    rb_raise(rb_eNoMemError, "failed to allocate asynchronous job");
+  }
+
+  job->connection = async_wrapper->connection_wrapper->connection;
+  job->fd = fds[1];
+  // Handle, connection and worker
+  job->refcount = 3;
+
+  if (async_wrapper->connection_wrapper->job) {
+    sqlanywhere_async_release(async_wrapper->connection_wrapper->job);
+  }
+
+  async_wrapper->connection_wrapper->job = job;
+
+  if (NIL_P(statement)) {
+    job->sql = strdup(StringValueCStr(sql));
+  } else {
+    stmt_wrapper = DATA_PTR(statement);
+    job->stmt = stmt_wrapper->stmt;
+
+    if (stmt_wrapper->job) {
+      sqlanywhere_async_release(stmt_wrapper->job);
+    }
+
+    stmt_wrapper->job = job;
+    job->refcount++;
+  }
+
+  async_wrapper->job = job;
+
+  if (!sqlanywhere_async_submit(job)) {
+    rb_thread_call_without_gvl(sqlanywhere_async_run, job, sqlanywhere_async_cancel, job);
+  }
+
+  return self;
+}
+
+/* call-seq: async.to_io # => IO
+ *
+ * Returns IO which becomes readable once execution finishes, can be waited on with IO.select or a Fiber scheduler.
+ */
+static VALUE rb_sqlanywhere_async_to_io(VALUE self) {
+  GET_ASYNC(self);
+
+  return async_wrapper->io;
+}
+
+/* call-seq: async.ready? # => true or false
+ *
+ * Returns true once execution finished and value can be read without blocking on the server.
+ */
+static VALUE rb_sqlanywhere_async_ready(VALUE self) {
+  GET_ASYNC(self);
+
+  return sqlanywhere_async_done(async_wrapper->job) ? Qtrue : Qfalse;
+}
+
+/* call-seq: async.cancel # => true or false
+ *
+ * Cancels execution which is still running, value then raises SQLAnywhere2::Error.
+ * Returns false if execution already finished.
+ */
+static VALUE rb_sqlanywhere_async_cancel(VALUE self) {
+  GET_ASYNC(self);
+
+  if (sqlanywhere_async_done(async_wrapper->job)) {
+    return Qfalse;
+  }
+
+  sqlany_cancel(async_wrapper->job->connection);
+
+  return Qtrue;
+}
+
+static VALUE rb_sqlanywhere_async_result(VALUE self) {
+  GET_ASYNC(self);
+  sqlanywhere_async_job *job = async_wrapper->job;
+  sqlanywhere_stats stats = {0};
+  VALUE statement;
+  VALUE result;
+
+  if (!job->result) {
+    rb_raise_sqlanywhere_error_message(async_wrapper->connection, job->error_code, job->error, job->sql_state);
+  }
+
+  // Waiting for the worker released the GVL once
+  stats.execute_ns = job->execute_ns;
+  stats.executions = 1;
+  stats.gvl_releases = 1;
+
+  if (!NIL_P(async_wrapper->statement)) {
+    sqlanywhere_stats_add(&((sqlanywhere_stmt_wrapper *)DATA_PTR(async_wrapper->statement))->run, &stats);
+
+    return rb_sqlanywhere_stmt_executed(async_wrapper->statement, async_wrapper->stream);
+  }
+
+  statement = rb_sqlanywhere_stmt_new(async_wrapper->connection, job->stmt, &stats);
+  job->stmt = NULL;
+
+  rb_sqlanywhere_stmt_set_shape(statement, async_wrapper->as);
+
+  if (RTEST(async_wrapper->stream)) {
+    rb_sqlanywhere_stmt_open_stream(statement);
+    return rb_ary_new_from_args(2, statement, Qnil);
+  }
+
+  result = rb_sqlanywhere_stmt_last_result(statement);
+  rb_sqlanywhere_stmt_finish_run(DATA_PTR(statement));
+
+  return rb_ary_new_from_args(2, statement, result);
+}
+
+/* call-seq: async._value # => result
+ *
+ * Builds result of finished execution the same way as the synchronous call, raises its error.
+ */
+static VALUE rb_sqlanywhere_async_value(VALUE self) {
+  GET_ASYNC(self);
+
+  if (!async_wrapper->finished) {
+    rb_thread_call_without_gvl(sqlanywhere_async_wait, async_wrapper->job, sqlanywhere_async_cancel, async_wrapper->job);
+
+    async_wrapper->value = rb_sqlanywhere_async_result(self);
+    async_wrapper->finished = 1;
+  }
+
+  return async_wrapper->value;
+}
+
+void init_sqlanywhere_async() {
+  cSQLAnywhere2AsyncResult = rb_define_class_under(mSQLAnywhere2, "AsyncResult", rb_cObject);
+  rb_undef_alloc_func(cSQLAnywhere2AsyncResult);
+
+  intern_for_fd = rb_intern("for_fd");
+
+#ifdef HAVE_PTHREAD_H
+  pthread_atfork(NULL, NULL, sqlanywhere_async_atfork_child);
+#endif
+
+  rb_define_method(cSQLAnywhere2AsyncResult, "to_io", rb_sqlanywhere_async_to_io, 0);
+  rb_define_method(cSQLAnywhere2AsyncResult, "ready?", rb_sqlanywhere_async_ready, 0);
+  rb_define_method(cSQLAnywhere2AsyncResult, "cancel", rb_sqlanywhere_async_cancel, 0);
+  rb_define_private_method(cSQLAnywhere2AsyncResult, "_value", rb_sqlanywhere_async_value, 0);
+}
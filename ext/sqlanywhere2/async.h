@@ -0,0 +1,43 @@
+#ifndef SQLANYWHERE_ASYNC_H
+#define SQLANYWHERE_ASYNC_H
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+/*
+ * Execution handed to a native worker, either of a prepared statement or of sql with sqlany_execute_direct
+ * Completion is signalled by writing to fd, job is freed once handle, statement, connection and worker release it
+ * free_stmt and free_connection hand stmt and connection to the worker when their owners are freed first,
+ * binds of a freed statement stay allocated until the worker is done and are freed later with the GVL
+ */
+typedef struct sqlanywhere_async_job {
+  a_sqlany_connection *connection;
+  a_sqlany_stmt *stmt;
+  char *sql;
+  int fd;
+  int refcount;
+  int done;
+  int free_stmt;
+  int free_connection;
+  void *binds;
+  sacapi_i32 num_binds;
+  sacapi_bool result;
+  uint64_t execute_ns;
+  sacapi_i32 error_code;
+  char error[SACAPI_ERROR_SIZE];
+  char sql_state[SACAPI_ERROR_SIZE];
+  struct sqlanywhere_async_job *next;
+} sqlanywhere_async_job;
+
+void init_sqlanywhere_async(void);
+
+int sqlanywhere_async_done(sqlanywhere_async_job *job);
+void *sqlanywhere_async_wait(void *ptr);
+void sqlanywhere_async_release(sqlanywhere_async_job *job);
+int sqlanywhere_async_abandon(sqlanywhere_async_job *job, int free_stmt, int free_connection, void *binds, sacapi_i32 num_binds);
+void rb_sqlanywhere_async_sweep(void);
+void rb_sqlanywhere_async_cancel_wait(sqlanywhere_async_job *job);
+VALUE rb_sqlanywhere_async_new(VALUE connection, VALUE statement, VALUE sql, VALUE stream, VALUE as);
+
+#endif
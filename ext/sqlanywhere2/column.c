@@ -0,0 +1,587 @@
+#include <sqlanywhere2.h>
+
+extern VALUE mSQLAnywhere2;
+static VALUE cSQLAnywhere2Column, cTime, cDate;
+static VALUE opt_time_date;
+static VALUE intern_parse, intern_new, intern_BigDecimal, intern_Rational, intern_localtime, intern_utc, intern_uminus;
+static VALUE intern__parse, intern_now, intern_year, intern_mon, intern_day, intern_plus;
+static VALUE sym_year, sym_mon, sym_mday, sym_hour, sym_min, sym_sec, sym_sec_fraction, sym_offset;
+
+/*
+ * temporal value parsed from its dbcapi string representation
+ */
+struct sqlanywhere_datetime {
+  int year;
+  int mon;
+  int day;
+  int hour;
+  int min;
+  int sec;
+  long nsec;
+};
+
+/*
+ * Parses exactly len digits, returns -1 if a non digit character is found
+ */
+static int sqlanywhere_parse_digits(const char *str, int len) {
+  int result = 0;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    if (str[i] < '0' || str[i] > '9') {
+      return -1;
+    }
+
+    result = result * 10 + (str[i] - '0');
+  }
+
+  return result;
+}
+
+/*
+ * Parses HH:NN:SS with an optional fractional part of up to 9 digits
+ * Returns 0 if str is in any other format
+ */
+static int sqlanywhere_parse_time(const char *str, size_t len, struct sqlanywhere_datetime *dt) {
+  size_t i;
+  long scale = 100000000;
+
+  if (len < 8 || str[2] != ':' || str[5] != ':') {
+    return 0;
+  }
+
+  dt->hour = sqlanywhere_parse_digits(str, 2);
+  dt->min = sqlanywhere_parse_digits(str + 3, 2);
+  dt->sec = sqlanywhere_parse_digits(str + 6, 2);
+  dt->nsec = 0;
+
+  if (dt->hour < 0 || dt->hour > 23 || dt->min < 0 || dt->min > 59 || dt->sec < 0 || dt->sec > 59) {
+    return 0;
+  }
+
+  if (len == 8) {
+    return 1;
+  }
+
+  if (str[8] != '.' || len == 9 || len > 18) {
+    return 0;
+  }
+
+  for (i = 9; i < len; i++, scale /= 10) {
+    if (str[i] < '0' || str[i] > '9') {
+      return 0;
+    }
+
+    dt->nsec += (str[i] - '0') * scale;
+  }
+
+  return 1;
+}
+
+/*
+ * Parses YYYY-MM-DD
+ * Returns 0 if str is in any other format
+ */
+static int sqlanywhere_parse_date(const char *str, size_t len, struct sqlanywhere_datetime *dt) {
+  if (len < 10 || str[4] != '-' || str[7] != '-') {
+    return 0;
+  }
+
+  dt->year = sqlanywhere_parse_digits(str, 4);
+  dt->mon = sqlanywhere_parse_digits(str + 5, 2);
+  dt->day = sqlanywhere_parse_digits(str + 8, 2);
+
+  return dt->year > 0 && dt->mon >= 1 && dt->mon <= 12 && dt->day >= 1 && dt->day <= 31;
+}
+
+/*
+ * Number of days since 1970-01-01 for a proleptic gregorian date
+ */
+static long sqlanywhere_days_from_civil(int year, int mon, int day) {
+  long y = mon <= 2 ? year - 1 : year;
+  long era = (y >= 0 ? y : y - 399) / 400;
+  long yoe = y - era * 400;
+  long doy = (153 * (mon > 2 ? mon - 3 : mon + 9) + 2) / 5 + day - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+  return era * 146097 + doe - 719468;
+}
+
+/*
+ * Builds a Time in the connection timezone
+ * Local UTC offset is cached per connection for the last seen hour, so mktime is only called when hour changes
+ * Returns Qundef if the time can not be represented
+ */
+static VALUE sqlanywhere_datetime_to_time(struct sqlanywhere_datetime *dt, sqlanywhere_connection_wrapper *wrapper) {
+  struct timespec ts;
+  struct tm local_tm;
+  time_t seconds;
+  time_t hour;
+  time_t local_seconds;
+
+  seconds = (time_t)sqlanywhere_days_from_civil(dt->year, dt->mon, dt->day) * 86400 +
+    dt->hour * 3600 + dt->min * 60 + dt->sec;
+  ts.tv_nsec = dt->nsec;
+
+  if (wrapper->utc) {
+    ts.tv_sec = seconds;
+
+    return rb_time_timespec_new(&ts, INT_MAX - 1);
+  }
+
+  hour = seconds / 3600 - (seconds % 3600 < 0 ? 1 : 0);
+
+  if (!wrapper->tz_cached || wrapper->tz_cache_hour != hour) {
+    memset(&local_tm, 0, sizeof(local_tm));
+    local_tm.tm_year = dt->year - 1900;
+    local_tm.tm_mon = dt->mon - 1;
+    local_tm.tm_mday = dt->day;
+    local_tm.tm_hour = dt->hour;
+    local_tm.tm_isdst = -1;
+
+    local_seconds = mktime(&local_tm);
+
+    if (local_seconds == (time_t)-1) {
+      return Qundef;
+    }
+
+    wrapper->tz_cache_hour = hour;
+    wrapper->tz_cache_offset = (long)(hour * 3600 - local_seconds);
+    wrapper->tz_cached = 1;
+  }
+
+  ts.tv_sec = seconds - wrapper->tz_cache_offset;
+
+  return rb_time_timespec_new(&ts, INT_MAX);
+}
+
+/*
+ * Parses TIME and TIMESTAMP values in a custom format as UTC wall clock time, same as the native conversion
+ * date provides missing date fields, Time.parse(str).utc would read the fields as local time instead
+ * Values with an explicit offset keep it
+ */
+static VALUE sqlanywhere_parse_utc_time(VALUE str, VALUE date) {
+  VALUE parts = rb_funcall(cDate, intern__parse, 1, str);
+  VALUE sec, fraction;
+
+  if (RHASH_SIZE(parts) == 0 || !NIL_P(rb_hash_aref(parts, sym_offset))) {
+    // Time.parse raises for values without any date or time
+    return rb_funcall(rb_funcall(cTime, intern_parse, 2, str, date), intern_utc, 0);
+  }
+
+  sec = rb_hash_lookup2(parts, sym_sec, INT2FIX(0));
+  fraction = rb_hash_aref(parts, sym_sec_fraction);
+
+  if (!NIL_P(fraction)) {
+    sec = rb_funcall(sec, intern_plus, 1, fraction);
+  }
+
+  return rb_funcall(
+    cTime,
+    intern_utc,
+    6,
+    rb_hash_lookup2(parts, sym_year, rb_funcall(date, intern_year, 0)),
+    rb_hash_lookup2(parts, sym_mon, rb_funcall(date, intern_mon, 0)),
+    rb_hash_lookup2(parts, sym_mday, rb_funcall(date, intern_day, 0)),
+    rb_hash_lookup2(parts, sym_hour, INT2FIX(0)),
+    rb_hash_lookup2(parts, sym_min, INT2FIX(0)),
+    sec
+  );
+}
+
+/*
+ * Converts DATE, TIME and TIMESTAMP values straight from the dbcapi buffer
+ * Returns Qundef if value is not in the default dbcapi format, for example when
+ * date_format or timestamp_format database options are changed
+ */
+static VALUE sqlanywhere_temporal_to_rb_data(struct sqlanywhere_data_to_rb_data_args *data) {
+  a_sqlany_data_value *value = data->value;
+  const char *str = value->buffer;
+  size_t len = *value->length;
+  struct sqlanywhere_datetime dt;
+
+  if (value->type != A_STRING) {
+    return Qundef;
+  }
+
+  switch(data->info->native_type) {
+  case DT_DATE:
+    if (len != 10 || !sqlanywhere_parse_date(str, len, &dt)) {
+      return Qundef;
+    }
+
+    return rb_funcall(cDate, intern_new, 3, INT2FIX(dt.year), INT2FIX(dt.mon), INT2FIX(dt.day));
+  case DT_TIMESTAMP:
+    if (len < 19 || str[10] != ' ' || !sqlanywhere_parse_date(str, len, &dt) ||
+      !sqlanywhere_parse_time(str + 11, len - 11, &dt)) {
+      return Qundef;
+    }
+
+    return sqlanywhere_datetime_to_time(&dt, data->connection_wrapper);
+  case DT_TIME:
+    if (!sqlanywhere_parse_time(str, len, &dt)) {
+      return Qundef;
+    }
+
+    // Same date as used by Time.parse fallback
+    dt.year = 2000;
+    dt.mon = 1;
+    dt.day = 1;
+
+    return sqlanywhere_datetime_to_time(&dt, data->connection_wrapper);
+  default:
+    return Qundef;
+  }
+}
+
+/*
+ * Parses a plain decimal string into an integer mantissa, dropping the decimal point
+ * Returns 0 if value has more than 18 digits or is in any other format
+ */
+static int sqlanywhere_parse_decimal(const char *str, size_t len, LONG_LONG *mantissa, int *fraction_digits) {
+  LONG_LONG result = 0;
+  int digits = 0;
+  int negative = 0;
+  int point = 0;
+  size_t i = 0;
+
+  *fraction_digits = 0;
+
+  if (len > 0 && (str[0] == '-' || str[0] == '+')) {
+    negative = str[0] == '-';
+    i++;
+  }
+
+  for (; i < len; i++) {
+    if (str[i] == '.' && !point) {
+      point = 1;
+      continue;
+    }
+
+    if (str[i] < '0' || str[i] > '9' || ++digits > 18) {
+      return 0;
+    }
+
+    result = result * 10 + (str[i] - '0');
+    *fraction_digits += point;
+  }
+
+  if (digits == 0) {
+    return 0;
+  }
+
+  *mantissa = negative ? -result : result;
+
+  return 1;
+}
+
+/*
+ * Copies value into a string buffer which is reused for every cell of a fetch
+ * Only used to pass values to parsers which do not keep a reference to the string
+ */
+static VALUE sqlanywhere_decimal_buffer(struct sqlanywhere_data_to_rb_data_args *data) {
+  VALUE buffer = data->decimal_buffer;
+  long len = (long)*data->value->length;
+
+  rb_str_resize(buffer, len);
+  memcpy(RSTRING_PTR(buffer), data->value->buffer, len);
+
+  return buffer;
+}
+
+/*
+ * Converts DECIMAL and NUMERIC values straight from the dbcapi buffer
+ * according to decimal_as connection option
+ */
+static VALUE sqlanywhere_decimal_to_rb_data(struct sqlanywhere_data_to_rb_data_args *data) {
+  static const LONG_LONG powers_of_ten[] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL,
+    10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL, 1000000000000000000LL
+  };
+  a_sqlany_data_value *value = data->value;
+  a_sqlany_column_info *info = data->info;
+  LONG_LONG mantissa = 0;
+  int fraction_digits;
+  int parsed;
+
+  if (value->type != A_STRING) {
+    return Qundef;
+  }
+
+  parsed = sqlanywhere_parse_decimal(value->buffer, *value->length, &mantissa, &fraction_digits);
+
+  switch(data->connection_wrapper->decimal_as) {
+  case DECIMAL_AS_INTEGER_WHEN_EXACT:
+    if (info->scale == 0 && info->precision <= 18 && parsed && fraction_digits == 0) {
+      return LL2NUM(mantissa);
+    }
+
+    break;
+  case DECIMAL_AS_FLOAT:
+    return rb_float_new(rb_cstr_to_dbl(RSTRING_PTR(sqlanywhere_decimal_buffer(data)), 0));
+  case DECIMAL_AS_RATIONAL:
+    if (parsed) {
+      return rb_rational_new(LL2NUM(mantissa), LL2NUM(powers_of_ten[fraction_digits]));
+    }
+
+    return rb_funcall(rb_cObject, intern_Rational, 1, sqlanywhere_decimal_buffer(data));
+  default:
+    break;
+  }
+
+  return rb_funcall(rb_cObject, intern_BigDecimal, 1, sqlanywhere_decimal_buffer(data));
+}
+
+VALUE sqlanywhere_data_to_rb_data(struct sqlanywhere_data_to_rb_data_args *data) {
+  a_sqlany_data_value *value = data->value;
+  a_sqlany_column_info *info = data->info;
+  VALUE ret_data;
+
+  if (*value->is_null) {
+    ret_data = Qnil;
+  } else if (data->cast && (ret_data = sqlanywhere_temporal_to_rb_data(data)) != Qundef) {
+    return ret_data;
+  } else if (data->cast && info->native_type == DT_DECIMAL && (ret_data = sqlanywhere_decimal_to_rb_data(data)) != Qundef) {
+    return ret_data;
+  } else {
+    switch(value->type) {
+    case A_BINARY:
+      ret_data = rb_str_new(value->buffer, *value->length);
+      break;
+    case A_STRING:
+      ret_data = rb_enc_str_new(value->buffer, *value->length, data->encoding);
+      break;
+    case A_DOUBLE:
+      ret_data = rb_float_new(*(double*) value->buffer);
+      break;
+    case A_VAL64:
+      ret_data = LL2NUM(*(LONG_LONG*)value->buffer);
+      break;
+    case A_UVAL64:
+      ret_data = ULL2NUM(*(unsigned LONG_LONG*)value->buffer);
+      break;
+    case A_VAL32:
+      ret_data = INT2NUM(*(int *)value->buffer);
+      break;
+    case A_UVAL32:
+      ret_data = UINT2NUM(*(unsigned int *)value->buffer);
+      break;
+    case A_VAL16:
+      ret_data = INT2NUM(*(short *)value->buffer);
+      break;
+    case A_UVAL16:
+      ret_data = UINT2NUM(*(unsigned short *)value->buffer);
+      break;
+    case A_VAL8:
+    case A_UVAL8:
+      ret_data = CHR2FIX(*(unsigned char *)value->buffer);
+      break;
+    case A_INVALID_TYPE:
+      rb_raise(rb_eTypeError, "Invalid Data Type");
+    default:
+      ret_data = Qnil;
+      break;
+    }
+
+    if (data->cast) {
+      switch(info->native_type) {
+      case DT_DECIMAL:
+        ret_data = rb_funcall(rb_cObject, intern_BigDecimal, 1, ret_data);
+        break;
+      case DT_DATE:
+        ret_data = rb_funcall(cDate, intern_parse, 1, ret_data);
+        break;
+      case DT_TIMESTAMP:
+        if (data->connection_wrapper->utc) {
+          ret_data = sqlanywhere_parse_utc_time(ret_data, rb_funcall(rb_funcall(cTime, intern_now, 0), intern_utc, 0));
+        } else {
+          ret_data = rb_funcall(rb_funcall(cTime, intern_parse, 1, ret_data), intern_localtime, 0);
+        }
+        break;
+      case DT_TIME:
+        if (data->connection_wrapper->utc) {
+          ret_data = sqlanywhere_parse_utc_time(ret_data, opt_time_date);
+        } else {
+          ret_data = rb_funcall(rb_funcall(cTime, intern_parse, 2, ret_data, opt_time_date), intern_localtime, 0);
+        }
+        break;
+      case DT_BIT:
+        ret_data = FIX2INT(ret_data) == 1 ? Qtrue : Qfalse;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  return ret_data;
+}
+
+static VALUE convert_string(struct sqlanywhere_data_to_rb_data_args *data) {
+  if (data->value->type != A_STRING) {
+    return sqlanywhere_data_to_rb_data(data);
+  }
+
+  return rb_enc_str_new(data->value->buffer, *data->value->length, data->encoding);
+}
+
+/*
+ * Returns frozen deduplicated string, equal strings share one object
+ */
+VALUE sqlanywhere_interned_str(const char *ptr, long len, rb_encoding *encoding) {
+#ifdef HAVE_RB_ENC_INTERNED_STR
+  return rb_enc_interned_str(ptr, len, encoding);
+#else
+  return rb_funcall(rb_enc_str_new(ptr, len, encoding), intern_uminus, 0);
+#endif
+}
+
+static VALUE convert_interned_string(struct sqlanywhere_data_to_rb_data_args *data) {
+  if (data->value->type != A_STRING) {
+    return sqlanywhere_data_to_rb_data(data);
+  }
+
+  return sqlanywhere_interned_str(data->value->buffer, *data->value->length, data->encoding);
+}
+
+static VALUE convert_binary(struct sqlanywhere_data_to_rb_data_args *data) {
+  if (data->value->type != A_BINARY) {
+    return sqlanywhere_data_to_rb_data(data);
+  }
+
+  return rb_str_new(data->value->buffer, *data->value->length);
+}
+
+static VALUE convert_double(struct sqlanywhere_data_to_rb_data_args *data) {
+  if (data->value->type != A_DOUBLE) {
+    return sqlanywhere_data_to_rb_data(data);
+  }
+
+  return rb_float_new(*(double*) data->value->buffer);
+}
+
+static VALUE convert_val64(struct sqlanywhere_data_to_rb_data_args *data) {
+  if (data->value->type != A_VAL64) {
+    return sqlanywhere_data_to_rb_data(data);
+  }
+
+  return LL2NUM(*(LONG_LONG*)data->value->buffer);
+}
+
+static VALUE convert_val32(struct sqlanywhere_data_to_rb_data_args *data) {
+  if (data->value->type != A_VAL32) {
+    return sqlanywhere_data_to_rb_data(data);
+  }
+
+  return INT2NUM(*(int *)data->value->buffer);
+}
+
+static VALUE convert_bit(struct sqlanywhere_data_to_rb_data_args *data) {
+  if (data->value->type != A_VAL8 && data->value->type != A_UVAL8) {
+    return sqlanywhere_data_to_rb_data(data);
+  }
+
+  return *(unsigned char *)data->value->buffer == 1 ? Qtrue : Qfalse;
+}
+
+static VALUE convert_temporal(struct sqlanywhere_data_to_rb_data_args *data) {
+  VALUE ret_data = sqlanywhere_temporal_to_rb_data(data);
+
+  return ret_data != Qundef ? ret_data : sqlanywhere_data_to_rb_data(data);
+}
+
+static VALUE convert_decimal(struct sqlanywhere_data_to_rb_data_args *data) {
+  VALUE ret_data = sqlanywhere_decimal_to_rb_data(data);
+
+  return ret_data != Qundef ? ret_data : sqlanywhere_data_to_rb_data(data);
+}
+
+/*
+ * Chooses converter for a column once, so that no type dispatch is done per value
+ * Every converter falls back to sqlanywhere_data_to_rb_data if actual value type differs from described one
+ * With intern set, string columns return frozen deduplicated strings
+ */
+sqlanywhere_column_converter sqlanywhere_column_converter_for(a_sqlany_column_info *info, int cast, int intern) {
+  if (cast) {
+    switch(info->native_type) {
+    case DT_DATE:
+    case DT_TIME:
+    case DT_TIMESTAMP:
+      return convert_temporal;
+    case DT_DECIMAL:
+      return convert_decimal;
+    case DT_BIT:
+      return convert_bit;
+    default:
+      break;
+    }
+  }
+
+  switch(info->type) {
+  case A_STRING:
+    return intern ? convert_interned_string : convert_string;
+  case A_BINARY:
+    return convert_binary;
+  case A_DOUBLE:
+    return convert_double;
+  case A_VAL64:
+    return convert_val64;
+  case A_VAL32:
+    return convert_val32;
+  default:
+    return sqlanywhere_data_to_rb_data;
+  }
+}
+
+/*
+ * Creates a frozen SQLAnywhere2::Column
+ */
+VALUE rb_sqlanywhere_column_new(a_sqlany_column_info *info) {
+  VALUE rb_field = rb_funcall(
+    cSQLAnywhere2Column,
+    intern_new,
+    7,
+    rb_str_new2(info->name),
+    INT2NUM(info->type),
+    INT2NUM(info->native_type),
+    INT2NUM(info->precision),
+    INT2NUM(info->scale),
+    LONG2NUM(info->max_size),
+    info->nullable == 1 ? Qtrue : Qfalse
+  );
+
+  return rb_obj_freeze(rb_field);
+}
+
+void init_sqlanywhere_column() {
+  cDate = rb_const_get(rb_cObject, rb_intern("Date"));
+  cTime = rb_const_get(rb_cObject, rb_intern("Time"));
+  cSQLAnywhere2Column = rb_const_get(mSQLAnywhere2, rb_intern("Column"));
+
+  intern_new = rb_intern("new");
+  intern_parse = rb_intern("parse");
+  intern_BigDecimal = rb_intern("BigDecimal");
+  intern_Rational = rb_intern("Rational");
+  intern_localtime = rb_intern("localtime");
+  intern_utc = rb_intern("utc");
+  intern_uminus = rb_intern("-@");
+  intern__parse = rb_intern("_parse");
+  intern_now = rb_intern("now");
+  intern_year = rb_intern("year");
+  intern_mon = rb_intern("mon");
+  intern_day = rb_intern("day");
+  intern_plus = rb_intern("+");
+
+  sym_year = ID2SYM(rb_intern("year"));
+  sym_mon = ID2SYM(rb_intern("mon"));
+  sym_mday = ID2SYM(rb_intern("mday"));
+  sym_hour = ID2SYM(rb_intern("hour"));
+  sym_min = ID2SYM(rb_intern("min"));
+  sym_sec = ID2SYM(rb_intern("sec"));
+  sym_sec_fraction = ID2SYM(rb_intern("sec_fraction"));
+  sym_offset = ID2SYM(rb_intern("offset"));
+
+  opt_time_date = rb_funcall(cDate, intern_new, 2, INT2NUM(2000), INT2NUM(1));
+  rb_gc_register_address(&opt_time_date);
+}
@@ -0,0 +1,33 @@
+#ifndef SQLANYWHERE_COLUMN_H
+#define SQLANYWHERE_COLUMN_H
+
+/*
+ * used to pass all arguments to sqlanywhere_data_to_rb_data and column converters
+ */
+struct sqlanywhere_data_to_rb_data_args {
+  int cast;
+  rb_encoding *encoding;
+  sqlanywhere_connection_wrapper *connection_wrapper;
+  VALUE decimal_buffer;
+  a_sqlany_data_value *value;
+  a_sqlany_column_info *info;
+};
+
+typedef VALUE (*sqlanywhere_column_converter)(struct sqlanywhere_data_to_rb_data_args *data);
+
+/*
+ * Column description with a converter chosen once for its type
+ */
+typedef struct {
+  a_sqlany_column_info info;
+  sqlanywhere_column_converter convert;
+} sqlanywhere_column_plan;
+
+void init_sqlanywhere_column(void);
+
+VALUE sqlanywhere_data_to_rb_data(struct sqlanywhere_data_to_rb_data_args *data);
+sqlanywhere_column_converter sqlanywhere_column_converter_for(a_sqlany_column_info *info, int cast, int intern);
+VALUE rb_sqlanywhere_column_new(a_sqlany_column_info *info);
+VALUE sqlanywhere_interned_str(const char *ptr, long len, rb_encoding *encoding);
+
+#endif
@@ -0,0 +1,164 @@
+#include <sqlanywhere2.h>
+
+extern VALUE mSQLAnywhere2, cSQLAnywhere2Error;
+static VALUE cSQLAnywhere2ColumnarResult, cSQLAnywhere2Vector;
+static VALUE intern_new;
+static VALUE sym_int8, sym_uint8, sym_int16, sym_uint16, sym_int32, sym_uint32, sym_int64, sym_uint64;
+static VALUE sym_double, sym_string, sym_binary;
+
+/*
+ * Returns size of a packed value, 0 for types stored with offsets
+ */
+static size_t sqlanywhere_columnar_width(a_sqlany_data_type type) {
+  switch(type) {
+  case A_DOUBLE:
+  case A_VAL64:
+  case A_UVAL64:
+    return 8;
+  case A_VAL32:
+  case A_UVAL32:
+    return 4;
+  case A_VAL16:
+  case A_UVAL16:
+    return 2;
+  case A_VAL8:
+  case A_UVAL8:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static VALUE sqlanywhere_columnar_type_sym(a_sqlany_data_type type) {
+  switch(type) {
+  case A_DOUBLE:
+    return sym_double;
+  case A_VAL64:
+    return sym_int64;
+  case A_UVAL64:
+    return sym_uint64;
+  case A_VAL32:
+    return sym_int32;
+  case A_UVAL32:
+    return sym_uint32;
+  case A_VAL16:
+    return sym_int16;
+  case A_UVAL16:
+    return sym_uint16;
+  case A_VAL8:
+    return sym_int8;
+  case A_UVAL8:
+    return sym_uint8;
+  case A_BINARY:
+    return sym_binary;
+  default:
+    return sym_string;
+  }
+}
+
+void sqlanywhere_columnar_init(sqlanywhere_columnar_column *column, a_sqlany_column_info *info) {
+  uint64_t offset = 0;
+
+  column->type = info->type;
+  column->width = sqlanywhere_columnar_width(info->type);
+  column->data = rb_str_buf_new(0);
+  column->nulls = rb_str_buf_new(0);
+  column->offsets = Qnil;
+
+  if (column->width == 0) {
+    column->offsets = rb_str_buf_new(0);
+    rb_str_cat(column->offsets, (const char *)&offset, sizeof(offset));
+  }
+}
+
+/*
+ * Appends value of row to the column, rows must be appended in order starting from 0
+ * NULL values are stored as zeroes or as empty strings
+ */
+void sqlanywhere_columnar_append(sqlanywhere_columnar_column *column, long row, a_sqlany_data_value *value) {
+  static const char zeroes[8] = {0};
+  uint64_t offset;
+
+  if ((row & 7) == 0) {
+    rb_str_cat(column->nulls, zeroes, 1);
+  }
+
+  if (*value->is_null) {
+    RSTRING_PTR(column->nulls)[row >> 3] |= (char)(1 << (row & 7));
+  }
+
+  if (column->width > 0) {
+    if (!*value->is_null && value->type != column->type) {
+      rb_raise(cSQLAnywhere2Error, "Value type of a packed column changed while fetching");
+    }
+
+    rb_str_cat(column->data, *value->is_null ? zeroes : value->buffer, (long)column->width);
+    return;
+  }
+
+  if (!*value->is_null) {
+    rb_str_cat(column->data, value->buffer, (long)*value->length);
+  }
+
+  offset = (uint64_t)RSTRING_LEN(column->data);
+  rb_str_cat(column->offsets, (const char *)&offset, sizeof(offset));
+}
+
+/*
+ * Wraps collected columns into SQLAnywhere2::ColumnarResult, text column data gets the connection encoding
+ */
+VALUE rb_sqlanywhere_columnar_result_new(VALUE column_list, sqlanywhere_columnar_column *columns, long rows, rb_encoding *encoding, int truncated) {
+  long num_cols = RARRAY_LEN(column_list);
+  VALUE vectors = rb_ary_new2(num_cols);
+  VALUE vector;
+  long i;
+
+  for (i = 0; i < num_cols; i++) {
+    if (columns[i].type == A_STRING) {
+      rb_enc_associate(columns[i].data, encoding);
+    }
+
+    vector = rb_funcall(
+      cSQLAnywhere2Vector,
+      intern_new,
+      6,
+      RARRAY_AREF(column_list, i),
+      sqlanywhere_columnar_type_sym(columns[i].type),
+      rb_obj_freeze(columns[i].data),
+      rb_obj_freeze(columns[i].nulls),
+      NIL_P(columns[i].offsets) ? Qnil : rb_obj_freeze(columns[i].offsets),
+      LONG2NUM(rows)
+    );
+
+    rb_ary_store(vectors, i, vector);
+  }
+
+  return rb_funcall(
+    cSQLAnywhere2ColumnarResult,
+    intern_new,
+    4,
+    column_list,
+    rb_obj_freeze(vectors),
+    LONG2NUM(rows),
+    truncated ? Qtrue : Qfalse
+  );
+}
+
+void init_sqlanywhere_columnar() {
+  cSQLAnywhere2ColumnarResult = rb_const_get(mSQLAnywhere2, rb_intern("ColumnarResult"));
+  cSQLAnywhere2Vector = rb_const_get(cSQLAnywhere2ColumnarResult, rb_intern("Vector"));
+
+  intern_new = rb_intern("new");
+
+  sym_int8 = ID2SYM(rb_intern("int8"));
+  sym_uint8 = ID2SYM(rb_intern("uint8"));
+  sym_int16 = ID2SYM(rb_intern("int16"));
+  sym_uint16 = ID2SYM(rb_intern("uint16"));
+  sym_int32 = ID2SYM(rb_intern("int32"));
+  sym_uint32 = ID2SYM(rb_intern("uint32"));
+  sym_int64 = ID2SYM(rb_intern("int64"));
+  sym_uint64 = ID2SYM(rb_intern("uint64"));
+  sym_double = ID2SYM(rb_intern("double"));
+  sym_string = ID2SYM(rb_intern("string"));
+  sym_binary = ID2SYM(rb_intern("binary"));
+}
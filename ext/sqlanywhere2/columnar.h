@@ -0,0 +1,24 @@
+#ifndef SQLANYWHERE_COLUMNAR_H
+#define SQLANYWHERE_COLUMNAR_H
+
+/*
+ * Values of a single result column appended to binary strings instead of ruby objects
+ * Fixed width values are packed in native byte order, strings are concatenated into data
+ * and their end offsets are stored as 64 bit integers after a leading 0
+ * Bit n of nulls is set when value of row n is NULL
+ */
+typedef struct {
+  a_sqlany_data_type type;
+  size_t width;
+  VALUE data;
+  VALUE nulls;
+  VALUE offsets;
+} sqlanywhere_columnar_column;
+
+void init_sqlanywhere_columnar(void);
+
+void sqlanywhere_columnar_init(sqlanywhere_columnar_column *column, a_sqlany_column_info *info);
+void sqlanywhere_columnar_append(sqlanywhere_columnar_column *column, long row, a_sqlany_data_value *value);
+VALUE rb_sqlanywhere_columnar_result_new(VALUE column_list, sqlanywhere_columnar_column *columns, long rows, rb_encoding *encoding, int truncated);
+
+#endif
@@ -1,8 +1,11 @@
 #include <sqlanywhere2.h>
 
 static VALUE cSQLAnywhere2Connection;
-extern VALUE mSQLAnywhere2, cSQLAnywhere2Error;
+sacapi_u32 sqlanywhere_api_version = 0;
+extern VALUE mSQLAnywhere2, cSQLAnywhere2Error, cSQLAnywhere2TimeoutError;
 static ID intern_new;
+static VALUE sym_utc, sym_integer_when_exact, sym_float, sym_rational;
+static VALUE sym_raise, sym_truncate;
 
 /*
  * used to pass all arguments to sqlany_connect while inside
@@ -32,6 +35,16 @@ struct nogvl_execute_direct_args {
   const char *sql;
 };
 
+/*
+ * used to pass all arguments to sqlany_prepare while inside
+ * rb_thread_call_without_gvl
+ */
+struct nogvl_prepare_args {
+  a_sqlany_connection *connection;
+  a_sqlany_stmt *stmt;
+  const char *sql;
+};
+
 static void *nogvl_commit(void *connection) {
   sacapi_bool result;
 
@@ -86,25 +99,90 @@ static void nogvl_execute_direct_ubf(void *ptr) {
   sqlany_cancel(args->connection);
 }
 
+static void *nogvl_prepare(void *ptr) {
+  struct nogvl_prepare_args *args = ptr;
+
+  args->stmt = sqlany_prepare(args->connection, args->sql);
+
+  return (void*)(args->stmt != NULL ? Qtrue : Qfalse);
+}
+
+static void nogvl_prepare_ubf(void *ptr) {
+  struct nogvl_prepare_args *args = ptr;
+
+  sqlany_cancel(args->connection);
+}
+
+/*
+ * Connections inherited across fork share their socket with the parent process
+ * and must never be used or disconnected by the child
+ */
+int sqlanywhere_connection_owned(sqlanywhere_connection_wrapper *wrapper) {
+  return wrapper->pid == getpid();
+}
+
+/*
+ * Raises while an asynchronous execution runs, dbcapi connections can't be used by two requests at once
+ */
+void rb_sqlanywhere_connection_check_idle(sqlanywhere_connection_wrapper *wrapper) {
+  if (wrapper->job && !sqlanywhere_async_done(wrapper->job)) {
+    rb_raise(cSQLAnywhere2Error, "Connection is still executing asynchronously");
+  }
+}
+
+/*
+ * Raises once the deadline armed by with_timeout passed, the watchdog cancels only the request running at that moment
+ */
+void rb_sqlanywhere_connection_check_deadline(sqlanywhere_connection_wrapper *wrapper) {
+  if (sqlanywhere_deadline_fired(&wrapper->deadline)) {
+    rb_raise(cSQLAnywhere2TimeoutError, "Timeout expired");
+  }
+}
+
 static void *nogvl_close(void *ptr) {
   sqlanywhere_connection_wrapper *wrapper = ptr;
 
   if (!wrapper->closed) {
-    sqlany_disconnect(wrapper->connection);
+    if (sqlanywhere_connection_owned(wrapper)) {
+      sqlany_disconnect(wrapper->connection);
+    }
+
     wrapper->closed = 1;
   }
 
   return NULL;
 }
 
+static void *nogvl_ping(void *ptr) {
+  a_sqlany_connection *connection = ptr;
+  a_sqlany_stmt *stmt = sqlany_execute_direct(connection, "SELECT 1");
+
+  if (stmt == NULL) {
+    sqlany_clear_error(connection);
+    return (void *)Qfalse;
+  }
+
+  sqlany_free_stmt(stmt);
+
+  return (void *)Qtrue;
+}
+
+static void nogvl_ping_ubf(void *connection) {
+  sqlany_cancel(connection);
+}
+
 /* call-seq: connection.close # => nil
  *
  * Explicitly closing this will free up server resources immediately rather
- * than waiting for the garbage collector.
+ * than waiting for the garbage collector. Running asynchronous execution is cancelled first.
  */
 static VALUE rb_sqlanywhere_connection_close(VALUE self) {
   GET_CONNECTION(self);
 
+  if (wrapper->job && sqlanywhere_connection_owned(wrapper)) {
+    rb_sqlanywhere_async_cancel_wait(wrapper->job);
+  }
+
   if (wrapper->connection) {
     rb_thread_call_without_gvl(nogvl_close, wrapper, RUBY_UBF_IO, 0);
   }
@@ -112,6 +190,97 @@ static VALUE rb_sqlanywhere_connection_close(VALUE self) {
   return Qnil;
 }
 
+/* call-seq: connection.closed? # => true or false
+ *
+ * Returns true if connection was closed or was created in another process before fork.
+ */
+static VALUE rb_sqlanywhere_connection_closed(VALUE self) {
+  GET_CONNECTION(self);
+
+  return wrapper->closed || !sqlanywhere_connection_owned(wrapper) ? Qtrue : Qfalse;
+}
+
+/* call-seq: connection.ping # => true or false
+ *
+ * Checks that the server still responds by running a trivial query.
+ */
+static VALUE rb_sqlanywhere_connection_ping(VALUE self) {
+  GET_CONNECTION(self);
+
+  if (wrapper->closed || !sqlanywhere_connection_owned(wrapper)) {
+    return Qfalse;
+  }
+
+  rb_sqlanywhere_connection_check_idle(wrapper);
+
+  return (VALUE) rb_thread_call_without_gvl(nogvl_ping, wrapper->connection, nogvl_ping_ubf, wrapper->connection);
+}
+
+/* call-seq: connection.close_statements # => nil
+ *
+ * Closes all statements prepared or executed on this connection which are still open.
+ */
+static VALUE rb_sqlanywhere_connection_close_statements(VALUE self) {
+  GET_CONNECTION(self);
+
+  rb_sqlanywhere_connection_check_idle(wrapper);
+  sqlanywhere_stmt_close_all(wrapper);
+
+  return Qnil;
+}
+
+/* call-seq: connection._execute_async(sql, stream, as) # => SQLAnywhere2::AsyncResult
+ *
+ * Executes sql on a native worker thread, AsyncResult#value returns the same as execute_direct.
+ */
+static VALUE rb_sqlanywhere_connection_execute_async(VALUE self, VALUE sql, VALUE stream, VALUE as) {
+  GET_CONNECTION(self);
+
+  Check_Type(sql, T_STRING);
+
+  if (wrapper->closed) {
+    rb_raise(cSQLAnywhere2Error, "Connection is closed");
+  }
+
+  rb_sqlanywhere_connection_check_idle(wrapper);
+  rb_sqlanywhere_connection_check_deadline(wrapper);
+
+  return rb_sqlanywhere_async_new(self, Qnil, sql, stream, as);
+}
+
+/* call-seq: connection._arm_timeout(seconds) # => true or false
+ *
+ * Cancels running request once +seconds+ pass, returns false if a deadline is already armed.
+ */
+VALUE rb_sqlanywhere_connection_arm_timeout(VALUE self, VALUE seconds) {
+  GET_CONNECTION(self);
+  double timeout = NUM2DBL(seconds);
+  int armed;
+
+  if (timeout <= 0) {
+    rb_raise(rb_eArgError, "timeout must be positive");
+  }
+
+  wrapper->deadline.connection = wrapper->connection;
+  armed = sqlanywhere_deadline_arm(&wrapper->deadline, timeout);
+
+  if (armed < 0) {
+    rb_raise(cSQLAnywhere2Error, "Timeouts are not supported on this platform");
+  }
+
+  return armed ? Qtrue : Qfalse;
+}
+
+/* call-seq: connection._disarm_timeout # => true or false
+ *
+ * Returns true if deadline passed and running request was cancelled.
+ */
+VALUE rb_sqlanywhere_connection_disarm_timeout(VALUE self) {
+  GET_CONNECTION(self);
+
+  return sqlanywhere_deadline_disarm(&wrapper->deadline) ? Qtrue : Qfalse;
+}
+
 rb_encoding * rb_sqlanywhere_encoding(VALUE self) {
   VALUE encoding = rb_iv_get(self, "@encoding");
   const char *c_encoding = StringValueCStr(encoding);
@@ -124,9 +293,6 @@ void rb_raise_sqlanywhere_error(VALUE self) {
   char error_buffer[SACAPI_ERROR_SIZE];
   char state_buffer[SACAPI_ERROR_SIZE];
   sacapi_i32 result;
-  VALUE rb_error_msg;
-  VALUE rb_sql_state;
-  VALUE e;
 
   result = sqlany_error(wrapper->connection, error_buffer, SACAPI_ERROR_SIZE);
 
@@ -135,13 +301,33 @@ void rb_raise_sqlanywhere_error(VALUE self) {
   // Clear currently stored error
   sqlany_clear_error(wrapper->connection);
 
+  rb_raise_sqlanywhere_error_message(self, result, error_buffer, state_buffer);
+}
+
+/*
+ * Raises error which was read from the connection earlier, e.g. by a worker thread
+ */
+void rb_raise_sqlanywhere_error_message(VALUE self, sacapi_i32 result, const char *error_buffer, const char *state_buffer) {
+  GET_CONNECTION(self);
+  VALUE rb_error_msg;
+  VALUE rb_sql_state;
+  VALUE e;
+
   rb_error_msg = rb_str_new2(error_buffer);
   rb_sql_state = rb_str_new2(state_buffer);
 
   rb_enc_associate(rb_error_msg, rb_sqlanywhere_encoding(self));
   rb_enc_associate(rb_sql_state, rb_sqlanywhere_encoding(self));
 
-  e = rb_funcall(cSQLAnywhere2Error, intern_new, 3, rb_error_msg, INT2NUM(result), rb_sql_state);
+  // Request cancelled by the watchdog fails with the usual interrupted error
+  e = rb_funcall(
+    sqlanywhere_deadline_fired(&wrapper->deadline) ? cSQLAnywhere2TimeoutError : cSQLAnywhere2Error,
+    intern_new,
+    3,
+    rb_error_msg,
+    INT2NUM(result),
+    rb_sql_state
+  );
   rb_exc_raise(e);
 }
 
@@ -154,8 +340,24 @@ void decr_sqlanywhere_connection(sqlanywhere_connection_wrapper *wrapper) {
   wrapper->refcount--;
 
   if (wrapper->refcount == 0) {
+    sqlanywhere_deadline_disarm(&wrapper->deadline);
+
+    if (wrapper->job) {
+      // A running worker disconnects once done, garbage collection never waits for the server
+      if (sqlanywhere_connection_owned(wrapper) && !wrapper->closed && sqlanywhere_async_abandon(wrapper->job, 0, 1, NULL, 0)) {
+        wrapper->closed = 1;
+        wrapper->connection = NULL;
+      }
+
+      sqlanywhere_async_release(wrapper->job);
+    }
+
     nogvl_close(wrapper);
-    sqlany_free_connection(wrapper->connection);
+
+    if (sqlanywhere_connection_owned(wrapper) && wrapper->connection) {
+      sqlany_free_connection(wrapper->connection);
+    }
+
     xfree(wrapper);
   }
 }
@@ -172,6 +374,17 @@ static VALUE allocate(VALUE klass) {
   );
   wrapper->closed = 1; /* will be set false after calling sqlany_connect */
   wrapper->refcount = 1;
+  wrapper->utc = 0;
+  wrapper->tz_cached = 0;
+  wrapper->decimal_as = DECIMAL_AS_BIGDECIMAL;
+  wrapper->fetch_size = 1;
+  wrapper->lob_chunk_size = 65536;
+  memset(&wrapper->limits, 0, sizeof(sqlanywhere_result_limits));
+  wrapper->pid = getpid();
+  wrapper->statements = NULL;
+  wrapper->job = NULL;
+  memset(&wrapper->deadline, 0, sizeof(sqlanywhere_deadline));
+  memset(&wrapper->stats, 0, sizeof(sqlanywhere_stats));
 
   return obj;
 }
@@ -181,11 +394,22 @@ static VALUE rb_sqlanywhere_connection_execute_immediate(VALUE self, VALUE sql)
   GET_CONNECTION(self);
 
   Check_Type(sql, T_STRING);
+  rb_sqlanywhere_connection_check_idle(wrapper);
+  rb_sqlanywhere_connection_check_deadline(wrapper);
 
   args.connection = wrapper->connection;
   args.sql = StringValueCStr(sql);
 
-  if ((VALUE) rb_thread_call_without_gvl(nogvl_execute_immediate, &args, nogvl_execute_immediate_ubf, &args) == Qfalse) {
+  wrapper->stats.executions++;
+
+  if ((VALUE) rb_sqlanywhere_stats_without_gvl(
+    &wrapper->stats,
+    &wrapper->stats.execute_ns,
+    nogvl_execute_immediate,
+    &args,
+    nogvl_execute_immediate_ubf,
+    &args
+  ) == Qfalse) {
     rb_raise_sqlanywhere_error(self);
   }
 
@@ -197,7 +421,11 @@ static VALUE rb_initialize_lib(VALUE self) {
    * Due to specifics in libdbcapi_r each separate process needs to call this to work properly
    * This is especially needed when forking an existing process
    */
-  if (sqlany_init("RUBY", _SACAPI_VERSION, NULL) == 0) {
+  if (sqlany_init("RUBY", _SACAPI_VERSION, NULL) != 0) {
+    sqlanywhere_api_version = _SACAPI_VERSION;
+  } else if (_SACAPI_VERSION > SQLANY_API_VERSION_2 && sqlany_init("RUBY", SQLANY_API_VERSION_2, NULL) != 0) {
+    sqlanywhere_api_version = SQLANY_API_VERSION_2;
+  } else {
     rb_raise(rb_eRuntimeError, "Could not initialize SQLAnywhere client library");
   }
 
@@ -212,6 +440,53 @@ static VALUE rb_initialize_connection(VALUE self) {
   return self;
 }
 
+static enum sqlanywhere_decimal_as decimal_as_from_sym(VALUE decimal_as) {
+  if (decimal_as == sym_integer_when_exact) {
+    return DECIMAL_AS_INTEGER_WHEN_EXACT;
+  } else if (decimal_as == sym_float) {
+    return DECIMAL_AS_FLOAT;
+  } else if (decimal_as == sym_rational) {
+    return DECIMAL_AS_RATIONAL;
+  }
+
+  return DECIMAL_AS_BIGDECIMAL;
+}
+
+static size_t result_limit_from_num(VALUE value, const char *name) {
+  if (NIL_P(value)) {
+    return 0;
+  }
+
+  if (!RB_INTEGER_TYPE_P(value) || NUM2LL(value) <= 0) {
+    rb_raise(cSQLAnywhere2Error, "%s: option must be a positive Integer", name);
+  }
+
+  return NUM2SIZET(value);
+}
+
+/*
+ * Applies max_rows:, max_bytes: and on_limit: option values, Qundef keeps the current value and nil removes a limit
+ */
+void rb_sqlanywhere_set_result_limits(sqlanywhere_result_limits *limits, VALUE max_rows, VALUE max_bytes, VALUE on_limit) {
+  if (max_rows != Qundef) {
+    limits->max_rows = result_limit_from_num(max_rows, "max_rows");
+  }
+
+  if (max_bytes != Qundef) {
+    limits->max_bytes = result_limit_from_num(max_bytes, "max_bytes");
+  }
+
+  if (on_limit != Qundef) {
+    if (NIL_P(on_limit) || on_limit == sym_raise) {
+      limits->truncate = 0;
+    } else if (on_limit == sym_truncate) {
+      limits->truncate = 1;
+    } else {
+      rb_raise(cSQLAnywhere2Error, "on_limit: option must be :raise or :truncate");
+    }
+  }
+}
+
 static VALUE rb_sqlanywhere_connect(VALUE self, VALUE opts) {
   struct nogvl_connect_args args;
   VALUE rv;
@@ -227,45 +502,101 @@ static VALUE rb_sqlanywhere_connect(VALUE self, VALUE opts) {
   }
 
   wrapper->closed = 0;
+  wrapper->pid = getpid();
+  wrapper->cast = rb_iv_get(self, "@cast") == Qtrue;
+  wrapper->utc = rb_iv_get(self, "@database_timezone") == sym_utc;
+  wrapper->tz_cached = 0;
+  wrapper->decimal_as = decimal_as_from_sym(rb_iv_get(self, "@decimal_as"));
+  wrapper->fetch_size = NUM2UINT(rb_iv_get(self, "@fetch_size"));
+  wrapper->lob_chunk_size = NUM2SIZET(rb_iv_get(self, "@lob_chunk_size"));
+  rb_sqlanywhere_set_result_limits(
+    &wrapper->limits,
+    rb_iv_get(self, "@max_rows"),
+    rb_iv_get(self, "@max_bytes"),
+    rb_iv_get(self, "@on_limit")
+  );
+
   return self;
 }
 
 static VALUE rb_sqlanywhere_connection_prepare_statement(VALUE self, VALUE sql) {
+  struct nogvl_prepare_args args;
+  sqlanywhere_stats stats = {0};
   GET_CONNECTION(self);
 
   Check_Type(sql, T_STRING);
+  rb_sqlanywhere_connection_check_idle(wrapper);
+  rb_sqlanywhere_connection_check_deadline(wrapper);
 
-  a_sqlany_stmt *stmt = sqlany_prepare(wrapper->connection, StringValueCStr(sql));
+  args.connection = wrapper->connection;
+  args.sql = StringValueCStr(sql);
 
-  if (stmt == NULL) {
+  if ((VALUE) rb_sqlanywhere_stats_without_gvl(
+    &stats,
+    &stats.prepare_ns,
+    nogvl_prepare,
+    &args,
+    nogvl_prepare_ubf,
+    &args
+  ) == Qfalse) {
     rb_raise_sqlanywhere_error(self);
   }
 
-  return rb_sqlanywhere_stmt_new(self, stmt);
+  return rb_sqlanywhere_stmt_new(self, args.stmt, &stats);
 }
 
-static VALUE rb_sqlanywhere_connection_execute_direct(VALUE self, VALUE sql) {
+static VALUE rb_sqlanywhere_connection_execute_direct(VALUE self, VALUE sql, VALUE stream, VALUE as) {
   struct nogvl_execute_direct_args args;
+  sqlanywhere_stats stats = {0};
   GET_CONNECTION(self);
 
   Check_Type(sql, T_STRING);
+  rb_sqlanywhere_connection_check_idle(wrapper);
+  rb_sqlanywhere_connection_check_deadline(wrapper);
 
   args.connection = wrapper->connection;
   args.sql = StringValueCStr(sql);
-
-  if ((VALUE) rb_thread_call_without_gvl(nogvl_execute_direct, &args, nogvl_execute_direct_ubf, &args) == Qfalse) {
+  stats.executions = 1;
+
+  if ((VALUE) rb_sqlanywhere_stats_without_gvl(
+    &stats,
+    &stats.execute_ns,
+    nogvl_execute_direct,
+    &args,
+    nogvl_execute_direct_ubf,
+    &args
+  ) == Qfalse) {
     rb_raise_sqlanywhere_error(self);
   }
 
-  VALUE statement = rb_sqlanywhere_stmt_new(self, args.stmt);
+  VALUE statement = rb_sqlanywhere_stmt_new(self, args.stmt, &stats);
   VALUE result = rb_ary_new();
 
+  rb_sqlanywhere_stmt_set_shape(statement, as);
+
   rb_ary_push(result, statement);
-  rb_ary_push(result, rb_sqlanywhere_stmt_last_result(statement));
+
+  if (RTEST(stream)) {
+    rb_sqlanywhere_stmt_open_stream(statement);
+    rb_ary_push(result, Qnil);
+  } else {
+    rb_ary_push(result, rb_sqlanywhere_stmt_last_result(statement));
+    rb_sqlanywhere_stmt_finish_run(DATA_PTR(statement));
+  }
 
   return result;
 }
 
+/* call-seq: connection.stats # => Hash
+ *
+ * Returns performance counters of all finished executions on the connection, see Statement#stats.
+ */
+static VALUE rb_sqlanywhere_connection_stats(VALUE self) {
+  GET_CONNECTION(self);
+
+  return rb_sqlanywhere_stats_hash(&wrapper->stats);
+}
+
 /* call-seq:
  *    connection.commit
  *
@@ -274,6 +605,8 @@ static VALUE rb_sqlanywhere_connection_execute_direct(VALUE self, VALUE sql) {
 static VALUE rb_sqlanywhere_commit(VALUE self) {
   GET_CONNECTION(self);
 
+  rb_sqlanywhere_connection_check_idle(wrapper);
+
   return (VALUE) rb_thread_call_without_gvl(nogvl_commit, wrapper->connection, RUBY_UBF_IO, 0);
 }
 
@@ -285,6 +618,8 @@ static VALUE rb_sqlanywhere_commit(VALUE self) {
 static VALUE rb_sqlanywhere_commit_bang(VALUE self) {
   GET_CONNECTION(self);
 
+  rb_sqlanywhere_connection_check_idle(wrapper);
+
   if ((VALUE) rb_thread_call_without_gvl(nogvl_commit, wrapper->connection, RUBY_UBF_IO, 0) == Qfalse) {
     rb_raise_sqlanywhere_error(self);
   }
@@ -300,6 +635,8 @@ static VALUE rb_sqlanywhere_commit_bang(VALUE self) {
 static VALUE rb_sqlanywhere_rollback(VALUE self) {
   GET_CONNECTION(self);
 
+  rb_sqlanywhere_connection_check_idle(wrapper);
+
   return (VALUE) rb_thread_call_without_gvl(nogvl_rollback, wrapper->connection, RUBY_UBF_IO, 0);
 }
 
@@ -311,6 +648,8 @@ static VALUE rb_sqlanywhere_rollback(VALUE self) {
 static VALUE rb_sqlanywhere_rollback_bang(VALUE self) {
   GET_CONNECTION(self);
 
+  rb_sqlanywhere_connection_check_idle(wrapper);
+
   if ((VALUE) rb_thread_call_without_gvl(nogvl_rollback, wrapper->connection, RUBY_UBF_IO, 0) == Qfalse) {
     rb_raise_sqlanywhere_error(self);
   }
@@ -323,16 +662,30 @@ void init_sqlanywhere_connection() {
 
   rb_define_alloc_func(cSQLAnywhere2Connection, allocate);
   rb_define_method(cSQLAnywhere2Connection, "close", rb_sqlanywhere_connection_close, 0);
+  rb_define_method(cSQLAnywhere2Connection, "closed?", rb_sqlanywhere_connection_closed, 0);
+  rb_define_method(cSQLAnywhere2Connection, "ping", rb_sqlanywhere_connection_ping, 0);
+  rb_define_method(cSQLAnywhere2Connection, "close_statements", rb_sqlanywhere_connection_close_statements, 0);
+  rb_define_method(cSQLAnywhere2Connection, "stats", rb_sqlanywhere_connection_stats, 0);
   rb_define_method(cSQLAnywhere2Connection, "commit", rb_sqlanywhere_commit, 0);
   rb_define_method(cSQLAnywhere2Connection, "commit!", rb_sqlanywhere_commit_bang, 0);
   rb_define_method(cSQLAnywhere2Connection, "rollback", rb_sqlanywhere_rollback, 0);
   rb_define_method(cSQLAnywhere2Connection, "rollback!", rb_sqlanywhere_rollback_bang, 0);
   rb_define_private_method(cSQLAnywhere2Connection, "_prepare", rb_sqlanywhere_connection_prepare_statement, 1);
   rb_define_private_method(cSQLAnywhere2Connection, "_execute_immediate", rb_sqlanywhere_connection_execute_immediate, 1);
-  rb_define_private_method(cSQLAnywhere2Connection, "_execute_direct", rb_sqlanywhere_connection_execute_direct, 1);
+  rb_define_private_method(cSQLAnywhere2Connection, "_execute_direct", rb_sqlanywhere_connection_execute_direct, 3);
+  rb_define_private_method(cSQLAnywhere2Connection, "_execute_async", rb_sqlanywhere_connection_execute_async, 3);
+  rb_define_private_method(cSQLAnywhere2Connection, "_arm_timeout", rb_sqlanywhere_connection_arm_timeout, 1);
+  rb_define_private_method(cSQLAnywhere2Connection, "_disarm_timeout", rb_sqlanywhere_connection_disarm_timeout, 0);
   rb_define_private_method(cSQLAnywhere2Connection, "connect", rb_sqlanywhere_connect, 1);
   rb_define_private_method(cSQLAnywhere2Connection, "initialize_connection", rb_initialize_connection, 0);
   rb_define_private_method(cSQLAnywhere2Connection, "initialize_lib", rb_initialize_lib, 0);
 
   intern_new = rb_intern("new");
+
+  sym_utc = ID2SYM(rb_intern("utc"));
+  sym_integer_when_exact = ID2SYM(rb_intern("integer_when_exact"));
+  sym_float = ID2SYM(rb_intern("float"));
+  sym_rational = ID2SYM(rb_intern("rational"));
+  sym_raise = ID2SYM(rb_intern("raise"));
+  sym_truncate = ID2SYM(rb_intern("truncate"));
 }
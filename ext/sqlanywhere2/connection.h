@@ -1,10 +1,45 @@
 #ifndef SQLANYWHERE_CONNECTION_H
 #define SQLANYWHERE_CONNECTION_H
 
+enum sqlanywhere_decimal_as {
+  DECIMAL_AS_BIGDECIMAL,
+  DECIMAL_AS_INTEGER_WHEN_EXACT,
+  DECIMAL_AS_FLOAT,
+  DECIMAL_AS_RATIONAL
+};
+
+struct sqlanywhere_stmt_wrapper;
+struct sqlanywhere_async_job;
+
+/*
+ * Limits of results collected into memory, 0 means unlimited
+ * Results over a limit raise SQLAnywhere2::ResultLimitError, or are cut at the limit when truncate is set
+ */
+typedef struct {
+  size_t max_rows;
+  size_t max_bytes;
+  int truncate;
+} sqlanywhere_result_limits;
+
 typedef struct {
   long server_version;
   int refcount;
   int closed;
+  int cast;
+  int utc;
+  enum sqlanywhere_decimal_as decimal_as;
+  sacapi_u32 fetch_size;
+  size_t lob_chunk_size;
+  sqlanywhere_result_limits limits;
+  int tz_cached;
+  time_t tz_cache_hour;
+  long tz_cache_offset;
+  rb_pid_t pid;
+  struct sqlanywhere_stmt_wrapper *statements;
+  // Last asynchronous execution, nothing else may use the connection until it is done
+  struct sqlanywhere_async_job *job;
+  sqlanywhere_deadline deadline;
+  sqlanywhere_stats stats;
   a_sqlany_connection *connection;
 } sqlanywhere_connection_wrapper;
 
@@ -13,9 +48,22 @@ typedef struct {
   sqlanywhere_connection_wrapper *wrapper; \
   Data_Get_Struct(self, sqlanywhere_connection_wrapper, wrapper);
 
+/*
+ * API version libdbcapi was initialized with
+ * Can be lower than _SACAPI_VERSION when client library is older than the SDK headers
+ */
+extern sacapi_u32 sqlanywhere_api_version;
+
 void init_sqlanywhere_connection(void);
 void decr_sqlanywhere_connection(sqlanywhere_connection_wrapper *wrapper);
+int sqlanywhere_connection_owned(sqlanywhere_connection_wrapper *wrapper);
+void rb_sqlanywhere_connection_check_idle(sqlanywhere_connection_wrapper *wrapper);
+void rb_sqlanywhere_connection_check_deadline(sqlanywhere_connection_wrapper *wrapper);
 void rb_raise_sqlanywhere_error(VALUE self);
+void rb_raise_sqlanywhere_error_message(VALUE self, sacapi_i32 result, const char *error_buffer, const char *state_buffer);
 rb_encoding * rb_sqlanywhere_encoding(VALUE self);
+VALUE rb_sqlanywhere_connection_arm_timeout(VALUE self, VALUE seconds);
+VALUE rb_sqlanywhere_connection_disarm_timeout(VALUE self);
+void rb_sqlanywhere_set_result_limits(sqlanywhere_result_limits *limits, VALUE max_rows, VALUE max_bytes, VALUE on_limit);
 
 #endif
@@ -0,0 +1,665 @@
+#include <errno.h>
+#include <sqlanywhere2.h>
+
+static const char hex_digits[] = "0123456789abcdef";
+
+enum sqlanywhere_copy_state {
+  COPY_FIELD_START,
+  COPY_UNQUOTED,
+  COPY_QUOTED,
+  COPY_QUOTE,
+  COPY_ESCAPED
+};
+
+static int sqlanywhere_copy_needs_quotes(sqlanywhere_copy_format *format, const char *ptr, size_t len) {
+  size_t i;
+
+  // Empty string is quoted so it can be told apart from NULL
+  if (len == 0) {
+    return format->null_len == 0;
+  }
+
+  for (i = 0; i < len; i++) {
+    if (ptr[i] == format->col_sep || ptr[i] == '"' || ptr[i] == '\n' || ptr[i] == '\r') {
+      return 1;
+    }
+  }
+
+  return (long)len == format->null_len && memcmp(ptr, format->null, len) == 0;
+}
+
+static void sqlanywhere_copy_append_csv(VALUE buffer, sqlanywhere_copy_format *format, const char *ptr, size_t len) {
+  const char *quote;
+  const char *end = ptr + len;
+
+  if (!sqlanywhere_copy_needs_quotes(format, ptr, len)) {
+    rb_str_cat(buffer, ptr, (long)len);
+    return;
+  }
+
+  rb_str_cat(buffer, "\"", 1);
+
+  while ((quote = memchr(ptr, '"', (size_t)(end - ptr))) != NULL) {
+    rb_str_cat(buffer, ptr, (long)(quote - ptr + 1));
+    rb_str_cat(buffer, "\"", 1);
+    ptr = quote + 1;
+  }
+
+  rb_str_cat(buffer, ptr, (long)(end - ptr));
+  rb_str_cat(buffer, "\"", 1);
+}
+
+static void sqlanywhere_copy_append_tsv(VALUE buffer, const char *ptr, size_t len) {
+  const char *start = ptr;
+  const char *end = ptr + len;
+  const char *escape;
+
+  for (; ptr < end; ptr++) {
+    switch(*ptr) {
+    case '\t':
+      escape = "\\t";
+      break;
+    case '\n':
+      escape = "\\n";
+      break;
+    case '\r':
+      escape = "\\r";
+      break;
+    case '\\':
+      escape = "\\\\";
+      break;
+    default:
+      continue;
+    }
+
+    rb_str_cat(buffer, start, (long)(ptr - start));
+    rb_str_cat(buffer, escape, 2);
+    start = ptr + 1;
+  }
+
+  rb_str_cat(buffer, start, (long)(end - start));
+}
+
+/*
+ * Appends text quoted or escaped for the format, used for values and column names
+ */
+void sqlanywhere_copy_append_text(VALUE buffer, sqlanywhere_copy_format *format, const char *ptr, size_t len) {
+  if (format->tsv) {
+    sqlanywhere_copy_append_tsv(buffer, ptr, len);
+  } else {
+    sqlanywhere_copy_append_csv(buffer, format, ptr, len);
+  }
+}
+
+static void sqlanywhere_copy_append_hex(VALUE buffer, const unsigned char *ptr, size_t len) {
+  long offset = RSTRING_LEN(buffer);
+  char *out;
+  size_t i;
+
+  rb_str_resize(buffer, offset + (long)len * 2);
+  out = RSTRING_PTR(buffer) + offset;
+
+  for (i = 0; i < len; i++) {
+    out[i * 2] = hex_digits[ptr[i] >> 4];
+    out[i * 2 + 1] = hex_digits[ptr[i] & 15];
+  }
+}
+
+/*
+ * Shortest of %.15g and %.17g which reads back as the same double
+ */
+static int sqlanywhere_copy_format_double(char *out, size_t size, double value) {
+  int len = snprintf(out, size, "%.15g", value);
+
+  if (strtod(out, NULL) != value) {
+    len = snprintf(out, size, "%.17g", value);
+  }
+
+  return len;
+}
+
+/*
+ * Appends value formatted from its dbcapi buffer without creating ruby objects
+ * Numbers are written as decimal text, binary values as hex digits and other values as returned by the server
+ */
+void sqlanywhere_copy_append_value(VALUE buffer, sqlanywhere_copy_format *format, a_sqlany_data_value *value) {
+  char number[32];
+  int len;
+  union {
+    LONG_LONG val64;
+    unsigned LONG_LONG uval64;
+    int val32;
+    unsigned int uval32;
+    short val16;
+    unsigned short uval16;
+    signed char val8;
+    unsigned char uval8;
+    double val_double;
+  } fixed;
+
+  if (*value->is_null) {
+    rb_str_cat(buffer, format->null, format->null_len);
+    return;
+  }
+
+  switch(value->type) {
+  case A_STRING:
+    sqlanywhere_copy_append_text(buffer, format, value->buffer, *value->length);
+    return;
+  case A_BINARY:
+    sqlanywhere_copy_append_hex(buffer, (const unsigned char *)value->buffer, *value->length);
+    return;
+  default:
+    break;
+  }
+
+  memcpy(&fixed, value->buffer, *value->length < sizeof(fixed) ? *value->length : sizeof(fixed));
+
+  switch(value->type) {
+  case A_DOUBLE:
+    len = sqlanywhere_copy_format_double(number, sizeof(number), fixed.val_double);
+    break;
+  case A_VAL64:
+    len = snprintf(number, sizeof(number), "%lld", (long long)fixed.val64);
+    break;
+  case A_UVAL64:
+    len = snprintf(number, sizeof(number), "%llu", (unsigned long long)fixed.uval64);
+    break;
+  case A_VAL32:
+    len = snprintf(number, sizeof(number), "%d", fixed.val32);
+    break;
+  case A_UVAL32:
+    len = snprintf(number, sizeof(number), "%u", fixed.uval32);
+    break;
+  case A_VAL16:
+    len = snprintf(number, sizeof(number), "%d", (int)fixed.val16);
+    break;
+  case A_UVAL16:
+    len = snprintf(number, sizeof(number), "%u", (unsigned int)fixed.uval16);
+    break;
+  case A_VAL8:
+    len = snprintf(number, sizeof(number), "%d", (int)fixed.val8);
+    break;
+  case A_UVAL8:
+    len = snprintf(number, sizeof(number), "%u", (unsigned int)fixed.uval8);
+    break;
+  default:
+    sqlanywhere_copy_append_text(buffer, format, value->buffer, *value->length);
+    return;
+  }
+
+  rb_str_cat(buffer, number, len);
+}
+
+/*
+ * Parameters are bound as 64 bit numbers, doubles, binary or strings, dbcapi converts them to the column type
+ */
+static a_sqlany_data_type sqlanywhere_copy_param_type(a_sqlany_data_type type) {
+  switch(type) {
+  case A_VAL64:
+  case A_VAL32:
+  case A_VAL16:
+  case A_VAL8:
+    return A_VAL64;
+  case A_UVAL64:
+  case A_UVAL32:
+  case A_UVAL16:
+  case A_UVAL8:
+    return A_UVAL64;
+  case A_DOUBLE:
+    return A_DOUBLE;
+  case A_BINARY:
+    return A_BINARY;
+  default:
+    return A_STRING;
+  }
+}
+
+static int sqlanywhere_copy_packed(a_sqlany_data_type type) {
+  return type == A_STRING || type == A_BINARY;
+}
+
+/*
+ * Strings are at least 1 byte wide, numbers are 64 bit
+ */
+static void sqlanywhere_copy_reset_widths(sqlanywhere_copy_batch *batch) {
+  sacapi_i32 i;
+
+  for (i = 0; i < batch->num_params; i++) {
+    batch->widths[i] = sqlanywhere_copy_packed(batch->types[i]) ? 1 : sizeof(sqlanywhere_copy_number);
+  }
+}
+
+/*
+ * Widens parameters for the row starting at first_cell
+ * Returns 0 without changing widths if packed arrays would exceed SQLANYWHERE_COPY_BATCH_BYTES,
+ * first row of a batch always fits so oversized rows are executed on their own
+ */
+static int sqlanywhere_copy_fit_row(sqlanywhere_copy_batch *batch, size_t first_cell) {
+  size_t row_width = 0;
+  size_t length;
+  sacapi_i32 i;
+
+  for (i = 0; i < batch->num_params; i++) {
+    length = sqlanywhere_copy_packed(batch->types[i]) ? batch->lengths[first_cell + i] : 0;
+    row_width += length > batch->widths[i] ? length : batch->widths[i];
+  }
+
+  if (batch->rows > 0 && row_width > SQLANYWHERE_COPY_BATCH_BYTES / (size_t)(batch->rows + 1)) {
+    return 0;
+  }
+
+  for (i = 0; i < batch->num_params; i++) {
+    length = sqlanywhere_copy_packed(batch->types[i]) ? batch->lengths[first_cell + i] : 0;
+
+    if (length > batch->widths[i]) {
+      batch->widths[i] = length;
+    }
+  }
+
+  return 1;
+}
+
+/*
+ * Allocates a batch of batch_size rows for parameters described in binds
+ * Parser has to be zeroed before, so it can be freed even if allocation fails
+ */
+void sqlanywhere_copy_parser_init(sqlanywhere_copy_parser *parser, sqlanywhere_bind_param *binds, sacapi_i32 num_params, long batch_size) {
+  sqlanywhere_copy_batch *batch = &parser->batch;
+  long cells = (long)num_params * batch_size;
+  sacapi_i32 i;
+
+  batch->num_params = num_params;
+  batch->batch_size = batch_size;
+  batch->types = ALLOC_N(a_sqlany_data_type, num_params);
+  batch->widths = ALLOC_N(size_t, num_params);
+  batch->offsets = ALLOC_N(size_t, cells);
+  batch->lengths = ALLOC_N(size_t, cells);
+  batch->nulls = ALLOC_N(sacapi_bool, cells);
+  batch->numbers = ALLOC_N(sqlanywhere_copy_number, cells);
+
+  for (i = 0; i < num_params; i++) {
+    batch->types[i] = sqlanywhere_copy_param_type(binds[i].type);
+  }
+
+  sqlanywhere_copy_reset_widths(batch);
+  parser->state = COPY_FIELD_START;
+  parser->line = 1;
+  parser->row_line = 1;
+}
+
+static void sqlanywhere_copy_field_bytes(sqlanywhere_copy_parser *parser, const char *ptr, size_t len) {
+  sqlanywhere_copy_batch *batch = &parser->batch;
+  size_t capacity;
+
+  // Extra fields only make the row invalid, their values are not kept
+  if (parser->field >= batch->num_params) {
+    return;
+  }
+
+  if (batch->data_size + len > batch->data_capacity) {
+    capacity = batch->data_capacity > 0 ? batch->data_capacity : 4096;
+
+    while (capacity < batch->data_size + len) {
+      capacity *= 2;
+    }
+
+    REALLOC_N(batch->data, char, capacity);
+    batch->data_capacity = capacity;
+  }
+
+  memcpy(batch->data + batch->data_size, ptr, len);
+  batch->data_size += len;
+}
+
+static size_t sqlanywhere_copy_unescape(char *ptr, size_t len) {
+  size_t out = 0;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    if (ptr[i] != '\\' || i + 1 == len) {
+      ptr[out++] = ptr[i];
+      continue;
+    }
+
+    switch(ptr[++i]) {
+    case 't':
+      ptr[out++] = '\t';
+      break;
+    case 'n':
+      ptr[out++] = '\n';
+      break;
+    case 'r':
+      ptr[out++] = '\r';
+      break;
+    default:
+      ptr[out++] = ptr[i];
+      break;
+    }
+  }
+
+  return out;
+}
+
+/*
+ * Stores the current field as a cell, unquoted fields equal to the NULL representation are NULL
+ */
+static void sqlanywhere_copy_end_field(sqlanywhere_copy_parser *parser, int eol) {
+  sqlanywhere_copy_batch *batch = &parser->batch;
+  sqlanywhere_copy_format *format = &parser->format;
+  size_t cell;
+  size_t length;
+  char *ptr;
+
+  if (parser->field < batch->num_params) {
+    cell = (size_t)batch->rows * batch->num_params + parser->field;
+    length = batch->data_size - parser->field_start;
+    ptr = batch->data + parser->field_start;
+
+    // CRLF line ending
+    if (eol && !parser->quoted && length > 0 && ptr[length - 1] == '\r') {
+      length--;
+    }
+
+    batch->nulls[cell] = !parser->quoted &&
+      (long)length == format->null_len &&
+      (length == 0 || memcmp(ptr, format->null, length) == 0);
+
+    if (batch->nulls[cell]) {
+      length = 0;
+    } else if (format->tsv) {
+      length = sqlanywhere_copy_unescape(ptr, length);
+    }
+
+    batch->offsets[cell] = parser->field_start;
+    batch->lengths[cell] = length;
+    batch->data_size = parser->field_start + length;
+  }
+
+  parser->field++;
+  parser->quoted = 0;
+  parser->field_start = batch->data_size;
+  parser->state = COPY_FIELD_START;
+}
+
+static int sqlanywhere_copy_hex_digit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+
+  return -1;
+}
+
+static int sqlanywhere_copy_decode_hex(sqlanywhere_copy_batch *batch, size_t cell) {
+  char *ptr = batch->data + batch->offsets[cell];
+  size_t length = batch->lengths[cell];
+  int high;
+  int low;
+  size_t i;
+
+  if (length >= 2 && ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X')) {
+    ptr += 2;
+    length -= 2;
+    batch->offsets[cell] += 2;
+  }
+
+  if (length % 2 != 0) {
+    return 0;
+  }
+
+  for (i = 0; i < length / 2; i++) {
+    high = sqlanywhere_copy_hex_digit(ptr[i * 2]);
+    low = sqlanywhere_copy_hex_digit(ptr[i * 2 + 1]);
+
+    if (high < 0 || low < 0) {
+      return 0;
+    }
+
+    ptr[i] = (char)(high << 4 | low);
+  }
+
+  batch->lengths[cell] = length / 2;
+
+  return 1;
+}
+
+/*
+ * Converts a cell to the type of its parameter, returns 0 if text is not a valid value
+ */
+static int sqlanywhere_copy_convert(sqlanywhere_copy_batch *batch, size_t cell, a_sqlany_data_type type) {
+  char number[64];
+  char *end;
+  size_t length = batch->lengths[cell];
+
+  if (batch->nulls[cell] || type == A_STRING) {
+    return 1;
+  }
+
+  if (type == A_BINARY) {
+    return sqlanywhere_copy_decode_hex(batch, cell);
+  }
+
+  if (length == 0 || length >= sizeof(number)) {
+    return 0;
+  }
+
+  memcpy(number, batch->data + batch->offsets[cell], length);
+  number[length] = 0;
+  errno = 0;
+
+  switch(type) {
+  case A_VAL64:
+    batch->numbers[cell].val64 = strtoll(number, &end, 10);
+    break;
+  case A_UVAL64:
+    if (number[0] == '-') {
+      return 0;
+    }
+
+    batch->numbers[cell].uval64 = strtoull(number, &end, 10);
+    break;
+  default:
+    batch->numbers[cell].val_double = strtod(number, &end);
+    break;
+  }
+
+  return errno == 0 && end == number + length;
+}
+
+/*
+ * Adds the current record to the batch, invalid records are dropped and counted
+ * Blank lines and the header record are skipped
+ */
+static void sqlanywhere_copy_end_row(sqlanywhere_copy_parser *parser) {
+  sqlanywhere_copy_batch *batch = &parser->batch;
+  size_t first_cell = (size_t)batch->rows * batch->num_params;
+  int valid = 0;
+  sacapi_i32 i;
+
+  if (parser->row_bytes > 0 && !parser->headers) {
+    valid = !parser->row_error && parser->field == batch->num_params;
+
+    for (i = 0; valid && i < batch->num_params; i++) {
+      valid = sqlanywhere_copy_convert(batch, first_cell + i, batch->types[i]);
+    }
+
+    if (!valid) {
+      parser->skipped++;
+      parser->first_bad_line = parser->first_bad_line > 0 ? parser->first_bad_line : parser->row_line;
+    }
+  } else if (parser->row_bytes > 0) {
+    parser->headers = 0;
+  }
+
+  if (valid && sqlanywhere_copy_fit_row(batch, first_cell)) {
+    batch->rows++;
+  } else if (valid) {
+    batch->pending = 1;
+    batch->pending_start = parser->row_start;
+  } else {
+    batch->data_size = parser->row_start;
+  }
+
+  parser->field = 0;
+  parser->quoted = 0;
+  parser->row_error = 0;
+  parser->row_bytes = 0;
+  parser->row_start = batch->data_size;
+  parser->field_start = batch->data_size;
+  parser->state = COPY_FIELD_START;
+}
+
+static void sqlanywhere_copy_end_line(sqlanywhere_copy_parser *parser) {
+  sqlanywhere_copy_end_field(parser, 1);
+  sqlanywhere_copy_end_row(parser);
+
+  parser->line++;
+  parser->row_line = parser->line;
+}
+
+/*
+ * Parses input until it is consumed or the batch is full, returns number of bytes consumed
+ * Records can span calls, state is kept in the parser
+ */
+size_t sqlanywhere_copy_parse(sqlanywhere_copy_parser *parser, const char *ptr, size_t len) {
+  sqlanywhere_copy_batch *batch = &parser->batch;
+  char sep = parser->format.col_sep;
+  int tsv = parser->format.tsv;
+  size_t pos = 0;
+  size_t run;
+  char c;
+
+  while (pos < len && batch->rows < batch->batch_size && !batch->pending) {
+    // Plain bytes of a field are copied in one run
+    if (parser->state == COPY_UNQUOTED || parser->state == COPY_QUOTED) {
+      for (run = pos; run < len; run++) {
+        c = ptr[run];
+
+        if (parser->state == COPY_QUOTED ? c == '"' || c == '\n' : c == sep || c == '\n' || (tsv && c == '\\')) {
+          break;
+        }
+      }
+
+      if (run > pos) {
+        sqlanywhere_copy_field_bytes(parser, ptr + pos, run - pos);
+        parser->row_bytes += run - pos;
+        pos = run;
+        continue;
+      }
+    }
+
+    c = ptr[pos++];
+
+    if (c == '\n' && parser->state != COPY_QUOTED && parser->state != COPY_ESCAPED) {
+      sqlanywhere_copy_end_line(parser);
+      continue;
+    }
+
+    // Carriage return alone on a line still makes it blank
+    if (c != '\r' || parser->row_bytes > 0 || parser->field > 0) {
+      parser->row_bytes++;
+    }
+
+    switch(parser->state) {
+    case COPY_FIELD_START:
+    case COPY_UNQUOTED:
+      if (c == sep) {
+        sqlanywhere_copy_end_field(parser, 0);
+      } else if (c == '"' && !tsv && parser->state == COPY_FIELD_START) {
+        parser->quoted = 1;
+        parser->state = COPY_QUOTED;
+      } else {
+        sqlanywhere_copy_field_bytes(parser, &c, 1);
+        parser->state = tsv && c == '\\' ? COPY_ESCAPED : COPY_UNQUOTED;
+      }
+      break;
+    case COPY_QUOTED:
+      if (c == '"') {
+        parser->state = COPY_QUOTE;
+      } else {
+        sqlanywhere_copy_field_bytes(parser, &c, 1);
+        parser->line += c == '\n';
+      }
+      break;
+    case COPY_QUOTE:
+      if (c == '"') {
+        sqlanywhere_copy_field_bytes(parser, &c, 1);
+        parser->state = COPY_QUOTED;
+      } else if (c == sep) {
+        sqlanywhere_copy_end_field(parser, 0);
+      } else if (c != '\r') {
+        // Text after closing quote
+        parser->row_error = 1;
+      }
+      break;
+    case COPY_ESCAPED:
+      sqlanywhere_copy_field_bytes(parser, &c, 1);
+      parser->line += c == '\n';
+      parser->state = COPY_UNQUOTED;
+      break;
+    }
+  }
+
+  return pos;
+}
+
+/*
+ * Finishes the last record when input doesn't end with a newline
+ */
+void sqlanywhere_copy_parse_end(sqlanywhere_copy_parser *parser) {
+  // Unterminated quoted field
+  if (parser->state == COPY_QUOTED) {
+    parser->row_error = 1;
+  }
+
+  if (parser->row_bytes > 0 || parser->field > 0) {
+    sqlanywhere_copy_end_field(parser, 1);
+    sqlanywhere_copy_end_row(parser);
+  }
+}
+
+/*
+ * Empties the batch after it was executed, parser must be between records
+ * Pending row is moved to the start of the batch
+ */
+void sqlanywhere_copy_batch_clear(sqlanywhere_copy_parser *parser) {
+  sqlanywhere_copy_batch *batch = &parser->batch;
+  size_t first_cell = (size_t)batch->rows * batch->num_params;
+  size_t cell;
+  sacapi_i32 i;
+
+  sqlanywhere_copy_reset_widths(batch);
+
+  if (batch->pending) {
+    for (i = 0; i < batch->num_params; i++) {
+      cell = first_cell + i;
+      batch->offsets[i] = batch->offsets[cell] - batch->pending_start;
+      batch->lengths[i] = batch->lengths[cell];
+      batch->nulls[i] = batch->nulls[cell];
+      batch->numbers[i] = batch->numbers[cell];
+    }
+
+    batch->data_size -= batch->pending_start;
+    memmove(batch->data, batch->data + batch->pending_start, batch->data_size);
+    batch->rows = 0;
+    batch->pending = 0;
+    sqlanywhere_copy_fit_row(batch, 0);
+    batch->rows = 1;
+  } else {
+    batch->rows = 0;
+    batch->data_size = 0;
+  }
+
+  parser->row_start = batch->data_size;
+  parser->field_start = batch->data_size;
+}
+
+void sqlanywhere_copy_parser_free(sqlanywhere_copy_parser *parser) {
+  xfree(parser->batch.types);
+  xfree(parser->batch.widths);
+  xfree(parser->batch.offsets);
+  xfree(parser->batch.lengths);
+  xfree(parser->batch.nulls);
+  xfree(parser->batch.numbers);
+  xfree(parser->batch.data);
+}
@@ -0,0 +1,83 @@
+#ifndef SQLANYWHERE_COPY_H
+#define SQLANYWHERE_COPY_H
+
+// Output is written to the IO once the buffer holds this many bytes
+#define SQLANYWHERE_COPY_FLUSH_BYTES (1024 * 1024)
+
+// copy_in batch is executed early once its packed parameter arrays would grow past this many bytes
+#define SQLANYWHERE_COPY_BATCH_BYTES (16 * SQLANYWHERE_COPY_FLUSH_BYTES)
+
+/*
+ * Text format of copy_out and copy_in
+ * CSV quotes values containing separators or quotes, TSV escapes tabs, newlines and backslashes
+ */
+typedef struct {
+  int tsv;
+  char col_sep;
+  const char *null;
+  long null_len;
+} sqlanywhere_copy_format;
+
+/*
+ * Value of a numeric field converted once its row is complete
+ */
+typedef union {
+  LONG_LONG val64;
+  unsigned LONG_LONG uval64;
+  double val_double;
+} sqlanywhere_copy_number;
+
+/*
+ * Rows parsed by copy_in which are not executed yet, field i of row r is cell r * num_params + i
+ * Field text is kept in data, binary fields are hex decoded in place
+ * widths are the packed widths of parameters, rows * sum of widths stays within SQLANYWHERE_COPY_BATCH_BYTES
+ * Row which would not fit is left pending after the last row and starts the next batch
+ */
+typedef struct {
+  sacapi_i32 num_params;
+  a_sqlany_data_type *types;
+  size_t *widths;
+  long rows;
+  long batch_size;
+  int pending;
+  size_t pending_start;
+  size_t *offsets;
+  size_t *lengths;
+  sacapi_bool *nulls;
+  sqlanywhere_copy_number *numbers;
+  char *data;
+  size_t data_size;
+  size_t data_capacity;
+} sqlanywhere_copy_batch;
+
+/*
+ * CSV/TSV parser state of copy_in, input can be split at any byte
+ * Rows with a wrong number of fields or values not matching parameter types are skipped
+ */
+typedef struct {
+  sqlanywhere_copy_format format;
+  sqlanywhere_copy_batch batch;
+  int state;
+  int quoted;
+  int row_error;
+  int headers;
+  size_t row_bytes;
+  sacapi_i32 field;
+  size_t field_start;
+  size_t row_start;
+  long line;
+  long row_line;
+  long skipped;
+  long first_bad_line;
+} sqlanywhere_copy_parser;
+
+void sqlanywhere_copy_append_text(VALUE buffer, sqlanywhere_copy_format *format, const char *ptr, size_t len);
+void sqlanywhere_copy_append_value(VALUE buffer, sqlanywhere_copy_format *format, a_sqlany_data_value *value);
+
+void sqlanywhere_copy_parser_init(sqlanywhere_copy_parser *parser, sqlanywhere_bind_param *binds, sacapi_i32 num_params, long batch_size);
+size_t sqlanywhere_copy_parse(sqlanywhere_copy_parser *parser, const char *ptr, size_t len);
+void sqlanywhere_copy_parse_end(sqlanywhere_copy_parser *parser);
+void sqlanywhere_copy_batch_clear(sqlanywhere_copy_parser *parser);
+void sqlanywhere_copy_parser_free(sqlanywhere_copy_parser *parser);
+
+#endif
@@ -0,0 +1,127 @@
+#include <sqlanywhere2.h>
+
+extern VALUE mSQLAnywhere2, cSQLAnywhere2Error;
+static VALUE cSQLAnywhere2Cursor;
+
+#define GET_CURSOR(self) \
+  sqlanywhere_cursor_wrapper *cursor_wrapper; \
+  Data_Get_Struct(self, sqlanywhere_cursor_wrapper, cursor_wrapper);
+
+static void rb_sqlanywhere_cursor_mark(void *ptr) {
+  sqlanywhere_cursor_wrapper *cursor_wrapper = ptr;
+  if (!cursor_wrapper) return;
+
+  rb_gc_mark(cursor_wrapper->statement);
+}
+
+static int rb_sqlanywhere_cursor_open(sqlanywhere_cursor_wrapper *cursor_wrapper) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = cursor_wrapper->stmt_wrapper;
+
+  return !cursor_wrapper->closed &&
+    !stmt_wrapper->closed &&
+    stmt_wrapper->streaming &&
+    stmt_wrapper->row_generation == cursor_wrapper->row_generation;
+}
+
+static void rb_sqlanywhere_cursor_check(sqlanywhere_cursor_wrapper *cursor_wrapper) {
+  if (!rb_sqlanywhere_cursor_open(cursor_wrapper)) {
+    rb_raise(cSQLAnywhere2Error, "Cursor is closed");
+  }
+}
+
+VALUE rb_sqlanywhere_cursor_new(VALUE statement, sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sqlanywhere_cursor_wrapper *cursor_wrapper;
+  VALUE cursor = Data_Make_Struct(
+    cSQLAnywhere2Cursor,
+    sqlanywhere_cursor_wrapper,
+    rb_sqlanywhere_cursor_mark,
+    -1,
+    cursor_wrapper
+  );
+
+  cursor_wrapper->statement = statement;
+  cursor_wrapper->stmt_wrapper = stmt_wrapper;
+  cursor_wrapper->row_generation = stmt_wrapper->row_generation;
+  cursor_wrapper->closed = 0;
+
+  return cursor;
+}
+
+/*
+ * Reads +count+ rows starting at row +offset+, counted from 0, with the statement's row shape
+ */
+static VALUE rb_sqlanywhere_cursor_fetch(VALUE self, VALUE offset, VALUE count) {
+  GET_CURSOR(self);
+
+  rb_sqlanywhere_cursor_check(cursor_wrapper);
+
+  if (!RB_INTEGER_TYPE_P(offset) || NUM2LL(offset) < 0 || NUM2LL(offset) >= INT32_MAX) {
+    rb_raise(rb_eArgError, "offset: must be a non-negative Integer");
+  }
+
+  if (!RB_INTEGER_TYPE_P(count) || NUM2LL(count) <= 0) {
+    rb_raise(rb_eArgError, "count: must be a positive Integer");
+  }
+
+  return rb_sqlanywhere_stmt_fetch_page(cursor_wrapper->statement, NUM2LONG(offset), NUM2LONG(count));
+}
+
+/* call-seq: cursor.rows_estimate # => Integer
+ *
+ * Returns number of rows reported by sqlany_num_rows, which is only an estimate unless the server counted them,
+ * see the ROW_COUNTS database option.
+ */
+static VALUE rb_sqlanywhere_cursor_rows_estimate(VALUE self) {
+  sacapi_i32 num_rows;
+  GET_CURSOR(self);
+
+  rb_sqlanywhere_cursor_check(cursor_wrapper);
+  num_rows = sqlany_num_rows(cursor_wrapper->stmt_wrapper->stmt);
+
+  return LL2NUM(num_rows < 0 ? -(LONG_LONG)num_rows : (LONG_LONG)num_rows);
+}
+
+/* call-seq: cursor.statement # => SQLAnywhere2::Statement
+ */
+static VALUE rb_sqlanywhere_cursor_statement(VALUE self) {
+  GET_CURSOR(self);
+
+  return cursor_wrapper->statement;
+}
+
+/* call-seq: cursor.close # => nil
+ *
+ * Closes the cursor, the statement can then be executed again.
+ */
+static VALUE rb_sqlanywhere_cursor_close(VALUE self) {
+  GET_CURSOR(self);
+
+  if (rb_sqlanywhere_cursor_open(cursor_wrapper)) {
+    rb_sqlanywhere_stmt_close_stream(cursor_wrapper->stmt_wrapper);
+  }
+
+  cursor_wrapper->closed = 1;
+
+  return Qnil;
+}
+
+/* call-seq: cursor.closed? # => true or false
+ *
+ * Cursor is closed by close, by executing its statement again or by closing the statement.
+ */
+static VALUE rb_sqlanywhere_cursor_closed(VALUE self) {
+  GET_CURSOR(self);
+
+  return rb_sqlanywhere_cursor_open(cursor_wrapper) ? Qfalse : Qtrue;
+}
+
+void init_sqlanywhere_cursor() {
+  cSQLAnywhere2Cursor = rb_define_class_under(mSQLAnywhere2, "Cursor", rb_cObject);
+  rb_undef_alloc_func(cSQLAnywhere2Cursor);
+
+  rb_define_method(cSQLAnywhere2Cursor, "rows_estimate", rb_sqlanywhere_cursor_rows_estimate, 0);
+  rb_define_method(cSQLAnywhere2Cursor, "statement", rb_sqlanywhere_cursor_statement, 0);
+  rb_define_method(cSQLAnywhere2Cursor, "close", rb_sqlanywhere_cursor_close, 0);
+  rb_define_method(cSQLAnywhere2Cursor, "closed?", rb_sqlanywhere_cursor_closed, 0);
+  rb_define_private_method(cSQLAnywhere2Cursor, "_fetch", rb_sqlanywhere_cursor_fetch, 2);
+}
@@ -0,0 +1,19 @@
+#ifndef SQLANYWHERE_CURSOR_H
+#define SQLANYWHERE_CURSOR_H
+
+/*
+ * Scrollable cursor of an open_cursor execution, pages are read from it with sqlany_fetch_absolute
+ * Cursor is only valid while the statement keeps it open, row_generation changes once it is closed
+ */
+typedef struct {
+  VALUE statement;
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  unsigned long row_generation;
+  int closed;
+} sqlanywhere_cursor_wrapper;
+
+void init_sqlanywhere_cursor(void);
+
+VALUE rb_sqlanywhere_cursor_new(VALUE statement, sqlanywhere_stmt_wrapper *stmt_wrapper);
+
+#endif
@@ -36,4 +36,15 @@ end
 
 dir_config(extension_name, sdk_path, lib_path)
 
+# sacapi.h defines API version macros itself, so they have to be checked before including it
+$defs.push('-DHAVE_SQLANY_API_VERSION_4') if have_macro('SQLANY_API_VERSION_4', 'sacapi.h')
+
+have_func('rb_enc_interned_str', 'ruby/encoding.h')
+have_func('rb_hash_new_capa', 'ruby.h')
+
+# Used to prefetch rows and to cancel queries past their deadline on native threads
+have_header('pthread.h')
+# Lets the watchdog sleep on the monotonic clock, so deadlines don't move with wall clock changes
+have_func('pthread_condattr_setclock', 'pthread.h')
+
 create_makefile("#{extension_name}/#{extension_name}")
@@ -0,0 +1,243 @@
+#include <sqlanywhere2.h>
+
+extern VALUE mSQLAnywhere2, cSQLAnywhere2Error;
+static VALUE cSQLAnywhere2LobReader;
+
+#define GET_LOB(self) \
+  sqlanywhere_lob_wrapper *lob_wrapper; \
+  Data_Get_Struct(self, sqlanywhere_lob_wrapper, lob_wrapper);
+
+/*
+ * used to pass all arguments to sqlany_get_data while inside
+ * rb_thread_call_without_gvl
+ */
+struct nogvl_get_data_args {
+  a_sqlany_connection *connection;
+  a_sqlany_stmt *stmt;
+  sacapi_u32 index;
+  size_t offset;
+  char *buffer;
+  size_t size;
+  sacapi_i32 result;
+};
+
+static void *nogvl_get_data(void *ptr) {
+  struct nogvl_get_data_args *args = ptr;
+
+  args->result = sqlany_get_data(args->stmt, args->index, args->offset, args->buffer, args->size);
+
+  return NULL;
+}
+
+static void nogvl_get_data_ubf(void *ptr) {
+  struct nogvl_get_data_args *args = ptr;
+
+  sqlany_cancel(args->connection);
+}
+
+static void rb_sqlanywhere_lob_mark(void *ptr) {
+  sqlanywhere_lob_wrapper *lob_wrapper = ptr;
+  if (!lob_wrapper) return;
+
+  rb_gc_mark(lob_wrapper->statement);
+}
+
+static void rb_sqlanywhere_lob_check(sqlanywhere_lob_wrapper *lob_wrapper) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = lob_wrapper->stmt_wrapper;
+
+  if (stmt_wrapper->closed || stmt_wrapper->row_generation != lob_wrapper->row_generation) {
+    rb_raise(cSQLAnywhere2Error, "LOB can only be read while its row is current");
+  }
+
+  rb_sqlanywhere_connection_check_idle(stmt_wrapper->connection_wrapper);
+  rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+}
+
+/*
+ * Reads up to length bytes at the current offset into str, value is copied from dbcapi without the GVL
+ */
+static VALUE rb_sqlanywhere_lob_read_into(sqlanywhere_lob_wrapper *lob_wrapper, size_t length, VALUE str) {
+  struct nogvl_get_data_args args;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = lob_wrapper->stmt_wrapper;
+
+  rb_sqlanywhere_lob_check(lob_wrapper);
+
+  if (length > lob_wrapper->size - lob_wrapper->offset) {
+    length = lob_wrapper->size - lob_wrapper->offset;
+  }
+
+  rb_str_resize(str, (long)length);
+
+  if (length == 0) {
+    return str;
+  }
+
+  args.connection = stmt_wrapper->connection_wrapper->connection;
+  args.stmt = stmt_wrapper->stmt;
+  args.index = lob_wrapper->index;
+  args.offset = lob_wrapper->offset;
+  args.buffer = RSTRING_PTR(str);
+  args.size = length;
+
+  rb_str_locktmp(str);
+  rb_sqlanywhere_stats_without_gvl(
+    &stmt_wrapper->run,
+    &stmt_wrapper->run.fetch_ns,
+    nogvl_get_data,
+    &args,
+    nogvl_get_data_ubf,
+    &args
+  );
+  rb_str_unlocktmp(str);
+
+  if (args.result < 0) {
+    rb_raise_sqlanywhere_error(stmt_wrapper->connection);
+  }
+
+  stmt_wrapper->run.fetched_bytes += (size_t)args.result;
+
+  lob_wrapper->offset += (size_t)args.result;
+  rb_str_set_len(str, args.result);
+
+  return str;
+}
+
+VALUE rb_sqlanywhere_lob_new(VALUE statement, sqlanywhere_stmt_wrapper *stmt_wrapper, sacapi_u32 index, size_t size, int binary) {
+  sqlanywhere_lob_wrapper *lob_wrapper;
+  VALUE lob = Data_Make_Struct(
+    cSQLAnywhere2LobReader,
+    sqlanywhere_lob_wrapper,
+    rb_sqlanywhere_lob_mark,
+    -1,
+    lob_wrapper
+  );
+
+  lob_wrapper->statement = statement;
+  lob_wrapper->stmt_wrapper = stmt_wrapper;
+  lob_wrapper->row_generation = stmt_wrapper->row_generation;
+  lob_wrapper->index = index;
+  lob_wrapper->size = size;
+  lob_wrapper->offset = 0;
+  lob_wrapper->encoding = binary ? rb_ascii8bit_encoding() : stmt_wrapper->encoding;
+
+  return lob;
+}
+
+int sqlanywhere_is_lob(a_sqlany_column_info *info) {
+  switch(info->native_type) {
+  case DT_LONGBINARY:
+  case DT_LONGVARCHAR:
+  case DT_LONGNVARCHAR:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* call-seq: lob.read(length = nil, outbuf = nil) # => String or nil
+ *
+ * Reads +length+ bytes as a binary String, or the rest of the value when +length+ is nil.
+ * Returns nil at the end of value when +length+ is given, same as IO#read.
+ */
+static VALUE rb_sqlanywhere_lob_read(int argc, VALUE *argv, VALUE self) {
+  VALUE length;
+  VALUE outbuf;
+  VALUE str;
+  size_t size;
+  GET_LOB(self);
+
+  rb_scan_args(argc, argv, "02", &length, &outbuf);
+
+  size = NIL_P(length) ? lob_wrapper->size - lob_wrapper->offset : NUM2SIZET(length);
+
+  if (!NIL_P(length) && size > 0 && lob_wrapper->offset >= lob_wrapper->size) {
+    if (!NIL_P(outbuf)) {
+      rb_str_resize(outbuf, 0);
+    }
+
+    return Qnil;
+  }
+
+  str = NIL_P(outbuf) ? rb_str_buf_new((long)size) : StringValue(outbuf);
+  rb_sqlanywhere_lob_read_into(lob_wrapper, size, str);
+
+  rb_enc_associate(str, NIL_P(length) ? lob_wrapper->encoding : rb_ascii8bit_encoding());
+
+  return str;
+}
+
+/* call-seq: lob.each_chunk(chunk_size = connection.lob_chunk_size) { |chunk| ... } # => nil
+ *
+ * Yields the rest of the value in chunks of at most +chunk_size+ bytes.
+ */
+static VALUE rb_sqlanywhere_lob_each_chunk(int argc, VALUE *argv, VALUE self) {
+  VALUE chunk_size;
+  size_t size;
+  GET_LOB(self);
+
+  RETURN_ENUMERATOR(self, argc, argv);
+
+  rb_scan_args(argc, argv, "01", &chunk_size);
+
+  size = NIL_P(chunk_size) ? lob_wrapper->stmt_wrapper->connection_wrapper->lob_chunk_size : NUM2SIZET(chunk_size);
+
+  if (size == 0) {
+    rb_raise(rb_eArgError, "chunk_size must be positive");
+  }
+
+  while (lob_wrapper->offset < lob_wrapper->size) {
+    rb_yield(rb_sqlanywhere_lob_read_into(lob_wrapper, size, rb_str_buf_new((long)size)));
+  }
+
+  return Qnil;
+}
+
+/* call-seq: lob.size # => Integer
+ *
+ * Returns length of the value in bytes.
+ */
+static VALUE rb_sqlanywhere_lob_size(VALUE self) {
+  GET_LOB(self);
+
+  return SIZET2NUM(lob_wrapper->size);
+}
+
+/* call-seq: lob.pos # => Integer
+ *
+ * Returns offset of the next read in bytes.
+ */
+static VALUE rb_sqlanywhere_lob_pos(VALUE self) {
+  GET_LOB(self);
+
+  return SIZET2NUM(lob_wrapper->offset);
+}
+
+/* call-seq: lob.eof? # => true or false
+ */
+static VALUE rb_sqlanywhere_lob_eof(VALUE self) {
+  GET_LOB(self);
+
+  return lob_wrapper->offset >= lob_wrapper->size ? Qtrue : Qfalse;
+}
+
+/* call-seq: lob.rewind # => 0
+ */
+static VALUE rb_sqlanywhere_lob_rewind(VALUE self) {
+  GET_LOB(self);
+
+  lob_wrapper->offset = 0;
+
+  return INT2FIX(0);
+}
+
+void init_sqlanywhere_lob() {
+  cSQLAnywhere2LobReader = rb_define_class_under(mSQLAnywhere2, "LobReader", rb_cObject);
+  rb_undef_alloc_func(cSQLAnywhere2LobReader);
+
+  rb_define_method(cSQLAnywhere2LobReader, "read", rb_sqlanywhere_lob_read, -1);
+  rb_define_method(cSQLAnywhere2LobReader, "each_chunk", rb_sqlanywhere_lob_each_chunk, -1);
+  rb_define_method(cSQLAnywhere2LobReader, "size", rb_sqlanywhere_lob_size, 0);
+  rb_define_method(cSQLAnywhere2LobReader, "pos", rb_sqlanywhere_lob_pos, 0);
+  rb_define_method(cSQLAnywhere2LobReader, "eof?", rb_sqlanywhere_lob_eof, 0);
+  rb_define_method(cSQLAnywhere2LobReader, "rewind", rb_sqlanywhere_lob_rewind, 0);
+}
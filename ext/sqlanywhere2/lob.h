@@ -0,0 +1,23 @@
+#ifndef SQLANYWHERE_LOB_H
+#define SQLANYWHERE_LOB_H
+
+/*
+ * Reader for a LONG BINARY/LONG VARCHAR value of the current row, reads it with sqlany_get_data
+ * Reader is only valid until statement fetches the next row
+ */
+typedef struct {
+  VALUE statement;
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  unsigned long row_generation;
+  sacapi_u32 index;
+  size_t size;
+  size_t offset;
+  rb_encoding *encoding;
+} sqlanywhere_lob_wrapper;
+
+void init_sqlanywhere_lob(void);
+
+int sqlanywhere_is_lob(a_sqlany_column_info *info);
+VALUE rb_sqlanywhere_lob_new(VALUE statement, sqlanywhere_stmt_wrapper *stmt_wrapper, sacapi_u32 index, size_t size, int binary);
+
+#endif
@@ -1,11 +1,19 @@
 #include <sqlanywhere2.h>
 
-VALUE mSQLAnywhere2, cSQLAnywhere2Error;
+VALUE mSQLAnywhere2, cSQLAnywhere2Error, cSQLAnywhere2TimeoutError, cSQLAnywhere2ResultLimitError;
 
 void Init_sqlanywhere2() {
   mSQLAnywhere2 = rb_define_module("SQLAnywhere2");
   cSQLAnywhere2Error = rb_const_get(mSQLAnywhere2, rb_intern("Error"));
+  cSQLAnywhere2TimeoutError = rb_const_get(mSQLAnywhere2, rb_intern("TimeoutError"));
+  cSQLAnywhere2ResultLimitError = rb_const_get(mSQLAnywhere2, rb_intern("ResultLimitError"));
 
+  init_sqlanywhere_stats();
   init_sqlanywhere_connection();
+  init_sqlanywhere_column();
+  init_sqlanywhere_columnar();
   init_sqlanywhere_statement();
+  init_sqlanywhere_lob();
+  init_sqlanywhere_cursor();
+  init_sqlanywhere_async();
 }
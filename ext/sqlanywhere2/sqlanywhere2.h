@@ -1,15 +1,25 @@
 void Init_sqlanywhere(void);
 
-#if defined(SQLANY_API_VERSION_4)
+#if defined(HAVE_SQLANY_API_VERSION_4)
   #define _SACAPI_VERSION SQLANY_API_VERSION_4
 #else
   #define _SACAPI_VERSION SQLANY_API_VERSION_2
 #endif
 
+#include <time.h>
 #include <ruby.h>
 #include <ruby/encoding.h>
 #include <ruby/thread.h>
 
 #include <sacapi.h>
+#include <stats.h>
+#include <watchdog.h>
 #include <connection.h>
+#include <column.h>
+#include <staging.h>
+#include <columnar.h>
+#include <async.h>
 #include <statement.h>
+#include <copy.h>
+#include <lob.h>
+#include <cursor.h>
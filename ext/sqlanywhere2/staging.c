@@ -0,0 +1,340 @@
+#include <sqlanywhere2.h>
+
+// Rows fetched per chunk, a chunk is also finished early once it holds more than STAGING_CHUNK_BYTES
+#define STAGING_CHUNK_ROWS 256
+#define STAGING_CHUNK_BYTES (1024 * 1024)
+#define STAGING_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+static size_t sqlanywhere_staging_value_size(a_sqlany_data_value *value) {
+  switch(value->type) {
+  case A_STRING:
+  case A_BINARY:
+    return *value->length;
+  case A_DOUBLE:
+  case A_VAL64:
+  case A_UVAL64:
+    return 8;
+  case A_VAL32:
+  case A_UVAL32:
+    return 4;
+  case A_VAL16:
+  case A_UVAL16:
+    return 2;
+  case A_VAL8:
+  case A_UVAL8:
+    return 1;
+  default:
+    return value->buffer_size;
+  }
+}
+
+static int sqlanywhere_staging_reserve_cells(sqlanywhere_staging_chunk *chunk, size_t cells) {
+  void *types, *nulls, *lengths, *offsets;
+
+  if (chunk->cells >= cells) {
+    return 1;
+  }
+
+  if ((types = realloc(chunk->types, cells * sizeof(a_sqlany_data_type))) != NULL) chunk->types = types;
+  if ((nulls = realloc(chunk->nulls, cells * sizeof(sacapi_bool))) != NULL) chunk->nulls = nulls;
+  if ((lengths = realloc(chunk->lengths, cells * sizeof(size_t))) != NULL) chunk->lengths = lengths;
+  if ((offsets = realloc(chunk->offsets, cells * sizeof(size_t))) != NULL) chunk->offsets = offsets;
+
+  if (types == NULL || nulls == NULL || lengths == NULL || offsets == NULL) {
+    return 0;
+  }
+
+  chunk->cells = cells;
+
+  return 1;
+}
+
+static int sqlanywhere_staging_reserve_data(sqlanywhere_staging_chunk *chunk, size_t size) {
+  size_t capacity = chunk->data_capacity > 0 ? chunk->data_capacity : 4096;
+  char *data;
+
+  if (chunk->data_capacity >= size) {
+    return 1;
+  }
+
+  while (capacity < size) {
+    capacity *= 2;
+  }
+
+  if ((data = realloc(chunk->data, capacity)) == NULL) {
+    return 0;
+  }
+
+  chunk->data = data;
+  chunk->data_capacity = capacity;
+
+  return 1;
+}
+
+static void sqlanywhere_staging_fill_chunk(sqlanywhere_staging *staging, sqlanywhere_staging_chunk *chunk) {
+  a_sqlany_data_value value;
+  sacapi_bool fetched;
+  size_t cell;
+  size_t size;
+  size_t offset;
+  long max_rows;
+  sacapi_i32 i;
+
+  max_rows = staging->chunk_rows > 0 && staging->chunk_rows < STAGING_CHUNK_ROWS ? staging->chunk_rows : STAGING_CHUNK_ROWS;
+  chunk->rows = 0;
+  chunk->index = 0;
+  chunk->done = 0;
+  chunk->error = 0;
+  chunk->data_size = 0;
+
+  if (!sqlanywhere_staging_reserve_cells(chunk, (size_t)staging->num_cols * STAGING_CHUNK_ROWS)) {
+    chunk->error = SQLANYWHERE_STAGING_NO_MEMORY;
+    return;
+  }
+
+  while (chunk->rows < max_rows && chunk->data_size < STAGING_CHUNK_BYTES) {
+    if (staging->reposition > 0) {
+      fetched = sqlany_fetch_absolute(staging->stmt, staging->reposition);
+      staging->reposition = 0;
+    } else {
+      fetched = sqlany_fetch_next(staging->stmt);
+    }
+
+    if (!fetched) {
+      chunk->done = 1;
+      return;
+    }
+
+    for (i = 0; i < staging->num_cols; i++) {
+      cell = (size_t)chunk->rows * staging->num_cols + i;
+
+      if (!sqlany_get_column(staging->stmt, i, &value)) {
+        chunk->error = SQLANYWHERE_STAGING_SQL_ERROR;
+        return;
+      }
+
+      chunk->types[cell] = value.type;
+      chunk->nulls[cell] = *value.is_null;
+      chunk->lengths[cell] = 0;
+      chunk->offsets[cell] = 0;
+
+      if (*value.is_null) {
+        continue;
+      }
+
+      size = sqlanywhere_staging_value_size(&value);
+      offset = STAGING_ALIGN(chunk->data_size);
+
+      if (!sqlanywhere_staging_reserve_data(chunk, offset + size)) {
+        chunk->error = SQLANYWHERE_STAGING_NO_MEMORY;
+        return;
+      }
+
+      memcpy(chunk->data + offset, value.buffer, size);
+      chunk->lengths[cell] = size;
+      chunk->offsets[cell] = offset;
+      chunk->data_size = offset + size;
+    }
+
+    chunk->rows++;
+  }
+}
+
+/*
+ * Fetches next chunk of rows into the current chunk, must be called without the GVL
+ */
+void *sqlanywhere_staging_fill(void *ptr) {
+  sqlanywhere_staging *staging = ptr;
+
+  sqlanywhere_staging_fill_chunk(staging, &staging->chunks[staging->current]);
+
+  return NULL;
+}
+
+#ifdef HAVE_PTHREAD_H
+// Prefetch workers are shared by all statements and started on demand, once all are busy chunks are fetched in place
+#define STAGING_MAX_WORKERS 16
+
+static pthread_mutex_t staging_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t staging_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t staging_fetched = PTHREAD_COND_INITIALIZER;
+static sqlanywhere_staging *staging_head = NULL;
+static sqlanywhere_staging *staging_tail = NULL;
+static int staging_workers = 0;
+// Workers neither running nor reserved for a queued prefetch, every queued prefetch has a worker
+static int staging_available = 0;
+static int staging_atfork = 0;
+
+static void *sqlanywhere_staging_worker(void *ptr) {
+  sqlanywhere_staging *staging;
+
+  pthread_mutex_lock(&staging_mutex);
+
+  for (;;) {
+    while (staging_head == NULL) {
+      pthread_cond_wait(&staging_queued, &staging_mutex);
+    }
+
+    staging = staging_head;
+    staging_head = staging->next;
+
+    if (staging_head == NULL) {
+      staging_tail = NULL;
+    }
+
+    pthread_mutex_unlock(&staging_mutex);
+    sqlanywhere_staging_fill_chunk(staging, &staging->chunks[1 - staging->current]);
+    pthread_mutex_lock(&staging_mutex);
+
+    staging->requested = 0;
+    staging_available++;
+    pthread_cond_broadcast(&staging_fetched);
+  }
+
+  return NULL;
+}
+
+// Workers and queued prefetches of the parent process do not exist in forked child
+static void sqlanywhere_staging_atfork_child(void) {
+  pthread_mutex_init(&staging_mutex, NULL);
+  pthread_cond_init(&staging_queued, NULL);
+  pthread_cond_init(&staging_fetched, NULL);
+  staging_head = NULL;
+  staging_tail = NULL;
+  staging_workers = 0;
+  staging_available = 0;
+}
+
+/*
+ * Reserves a worker, starting one when none is available
+ * Returns 0 when all STAGING_MAX_WORKERS are busy or no thread could be started, must be called with staging_mutex
+ */
+static int sqlanywhere_staging_reserve(void) {
+  pthread_t thread;
+
+  if (!staging_atfork) {
+    pthread_atfork(NULL, NULL, sqlanywhere_staging_atfork_child);
+    staging_atfork = 1;
+  }
+
+  if (staging_available == 0) {
+    if (staging_workers >= STAGING_MAX_WORKERS ||
+      pthread_create(&thread, NULL, sqlanywhere_staging_worker, NULL) != 0) {
+      return 0;
+    }
+
+    pthread_detach(thread);
+    staging_workers++;
+    staging_available++;
+  }
+
+  staging_available--;
+
+  return 1;
+}
+#endif
+
+/*
+ * Hands fetching of the next chunk to a prefetch worker
+ * Returns 0 if prefetching is not available, next chunk then has to be filled with sqlanywhere_staging_fill
+ */
+int sqlanywhere_staging_prefetch(sqlanywhere_staging *staging) {
+#ifdef HAVE_PTHREAD_H
+  if (staging->prefetching) {
+    return 1;
+  }
+
+  pthread_mutex_lock(&staging_mutex);
+
+  if (!sqlanywhere_staging_reserve()) {
+    pthread_mutex_unlock(&staging_mutex);
+    return 0;
+  }
+
+  staging->pid = getpid();
+  staging->requested = 1;
+  staging->prefetching = 1;
+  staging->next = NULL;
+
+  if (staging_tail) {
+    staging_tail->next = staging;
+  } else {
+    staging_head = staging;
+  }
+
+  staging_tail = staging;
+
+  pthread_cond_signal(&staging_queued);
+  pthread_mutex_unlock(&staging_mutex);
+
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/*
+ * Waits for the prefetched chunk and makes it current, must be called without the GVL
+ */
+void *sqlanywhere_staging_wait(void *ptr) {
+  sqlanywhere_staging *staging = ptr;
+
+#ifdef HAVE_PTHREAD_H
+  // Chunk prefetched for the parent process never arrives after fork
+  if (staging->prefetching && staging->pid != getpid()) {
+    staging->prefetching = 0;
+  }
+
+  if (staging->prefetching) {
+    pthread_mutex_lock(&staging_mutex);
+
+    while (staging->requested) {
+      pthread_cond_wait(&staging_fetched, &staging_mutex);
+    }
+
+    pthread_mutex_unlock(&staging_mutex);
+    staging->prefetching = 0;
+    staging->current = 1 - staging->current;
+  }
+#endif
+
+  return NULL;
+}
+
+/*
+ * Unblocking function for fill and wait, fetch in progress fails and marks the chunk with SQL error
+ */
+void sqlanywhere_staging_cancel(void *ptr) {
+  sqlanywhere_staging *staging = ptr;
+
+  sqlany_cancel(staging->connection);
+}
+
+/*
+ * Points value at column col of the current row of the chunk
+ */
+void sqlanywhere_staging_value(sqlanywhere_staging_chunk *chunk, sacapi_i32 num_cols, sacapi_i32 col, a_sqlany_data_value *value) {
+  size_t cell = (size_t)chunk->index * num_cols + col;
+
+  value->buffer = chunk->data + chunk->offsets[cell];
+  value->buffer_size = chunk->lengths[cell];
+  value->length = &chunk->lengths[cell];
+  value->is_null = &chunk->nulls[cell];
+  value->type = chunk->types[cell];
+}
+
+void sqlanywhere_staging_free(sqlanywhere_staging *staging) {
+  int i;
+
+  sqlanywhere_staging_wait(staging);
+
+  for (i = 0; i < 2; i++) {
+    free(staging->chunks[i].types);
+    free(staging->chunks[i].nulls);
+    free(staging->chunks[i].lengths);
+    free(staging->chunks[i].offsets);
+    free(staging->chunks[i].data);
+  }
+
+  memset(staging, 0, sizeof(sqlanywhere_staging));
+}
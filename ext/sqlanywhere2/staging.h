@@ -0,0 +1,59 @@
+#ifndef SQLANYWHERE_STAGING_H
+#define SQLANYWHERE_STAGING_H
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#define SQLANYWHERE_STAGING_SQL_ERROR 1
+#define SQLANYWHERE_STAGING_NO_MEMORY 2
+
+/*
+ * Rows copied out of libdbcapi without the GVL
+ * Cell arrays are indexed by row * num_cols + col, values are stored in data at offsets
+ */
+typedef struct {
+  long rows;
+  long index;
+  int done;
+  int error;
+  size_t cells;
+  a_sqlany_data_type *types;
+  sacapi_bool *nulls;
+  size_t *lengths;
+  size_t *offsets;
+  char *data;
+  size_t data_size;
+  size_t data_capacity;
+} sqlanywhere_staging_chunk;
+
+/*
+ * Two chunks per statement, one is converted by ruby while the other one is prefetched
+ * Memory is allocated with malloc since it is filled without the GVL
+ * chunk_rows lowers the number of rows per chunk when set, so no rows past a cursor page are fetched
+ * Next chunk is prefetched by a worker shared by all statements, requested is cleared once it is filled
+ */
+typedef struct sqlanywhere_staging {
+  sqlanywhere_staging_chunk chunks[2];
+  int current;
+  int prefetching;
+  a_sqlany_connection *connection;
+  a_sqlany_stmt *stmt;
+  sacapi_i32 num_cols;
+  sacapi_i32 reposition;
+  long chunk_rows;
+#ifdef HAVE_PTHREAD_H
+  pid_t pid;
+  int requested;
+  struct sqlanywhere_staging *next;
+#endif
+} sqlanywhere_staging;
+
+void *sqlanywhere_staging_fill(void *ptr);
+void *sqlanywhere_staging_wait(void *ptr);
+void sqlanywhere_staging_cancel(void *ptr);
+int sqlanywhere_staging_prefetch(sqlanywhere_staging *staging);
+void sqlanywhere_staging_value(sqlanywhere_staging_chunk *chunk, sacapi_i32 num_cols, sacapi_i32 col, a_sqlany_data_value *value);
+void sqlanywhere_staging_free(sqlanywhere_staging *staging);
+
+#endif
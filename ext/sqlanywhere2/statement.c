@@ -1,16 +1,36 @@
 #include <sqlanywhere2.h>
 
 #define ROW_NOT_FOUND_ERROR 100
-
-extern VALUE mSQLAnywhere2, cSQLAnywhere2Error;
-static VALUE cSQLAnywhere2Statement, cSQLAnywhere2Result, cSQLAnywhere2Column, cBigDecimal, cTime, cDate;
-static VALUE intern_parse, intern_new, intern_BigDecimal, intern_localtime, intern_utc, sym_local;
+// Columns wider than this are never fetched in rowsets, e.g. LONG VARCHAR/LONG BINARY
+#define ROWSET_MAX_COLUMN_WIDTH 32768
+// Row arrays are presized for at most this many rows when sqlany_num_rows is only an estimate
+#define ROWS_ESTIMATE_CAPA 65536
+
+extern VALUE mSQLAnywhere2, cSQLAnywhere2Error, cSQLAnywhere2TimeoutError, cSQLAnywhere2ResultLimitError;
+static VALUE cSQLAnywhere2Statement, cSQLAnywhere2Result, cDate, cDateTime, cBigDecimal;
+static VALUE intern_new, intern_read, intern_write, intern_external_encoding, intern_commit_bang;
+static VALUE intern_to_time, intern_to_s, intern_year, intern_mon, intern_mday;
+// Argument of BigDecimal#to_s selecting plain notation
+static VALUE str_plain_format;
+static VALUE intern_call, intern_stats_hook, intern_timeout, intern_last_result;
+static VALUE sym_stream, sym_batch_size, sym_as, sym_lob, sym_format, sym_timeout;
+static VALUE sym_max_rows, sym_max_bytes, sym_on_limit;
+static VALUE sym_rows, sym_columnar, sym_csv, sym_tsv, sym_headers, sym_null, sym_commit;
+static VALUE sym_batches, sym_skipped, sym_first_bad_line;
+static VALUE sym_array, sym_hash, sym_symbol_hash, sym_struct, sym_string;
+// Struct classes by frozen member list, shared by statements returning the same columns
+static VALUE row_structs;
+#define ROW_STRUCTS_MAX 1024
 
 #define GET_STATEMENT(self) \
   sqlanywhere_stmt_wrapper *stmt_wrapper; \
   Data_Get_Struct(self, sqlanywhere_stmt_wrapper, stmt_wrapper); \
   if (!stmt_wrapper->stmt) { rb_raise(cSQLAnywhere2Error, "Invalid statement handle"); } \
-  if (stmt_wrapper->closed) { rb_raise(cSQLAnywhere2Error, "Statement handle already closed"); }
+  if (stmt_wrapper->closed) { rb_raise(cSQLAnywhere2Error, "Statement handle already closed"); } \
+  if (stmt_wrapper->job && !sqlanywhere_async_done(stmt_wrapper->job)) { \
+    rb_raise(cSQLAnywhere2Error, "Statement is still executing asynchronously"); \
+  } \
+  rb_sqlanywhere_connection_check_idle(stmt_wrapper->connection_wrapper);
 
 
 /*
@@ -23,15 +43,73 @@ struct nogvl_stmt_execute_args {
 };
 
 /*
- * used to pass all arguments to sqlanywhere_data_to_rb_data
+ * used to pass all arguments to sqlany_execute, sqlany_affected_rows and sqlany_reset
+ * of execute_update while inside rb_thread_call_without_gvl
  */
-struct sqlanywhere_data_to_rb_data_args {
-  int cast;
-  rb_encoding *encoding;
-  VALUE database_timezone;
-  VALUE opt_time_date;
-  a_sqlany_data_value *value;
-  a_sqlany_column_info *info;
+struct nogvl_stmt_update_args {
+  struct nogvl_stmt_execute_args execute;
+  sacapi_i32 affected;
+  int reset;
+};
+
+/*
+ * used to pass all arguments to execute_update while inside rb_ensure
+ */
+struct sqlanywhere_update_args {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  long argc;
+  const VALUE *argv;
+  int reset;
+  int armed;
+  int fired;
+};
+
+/*
+ * used to pass all arguments to sqlany_send_param_data while inside
+ * rb_thread_call_without_gvl
+ */
+struct nogvl_send_param_data_args {
+  struct nogvl_stmt_execute_args execute;
+  sacapi_u32 index;
+  char *buffer;
+  size_t size;
+};
+
+/*
+ * used to pass all arguments to the row fetching loop
+ * num_cols and columns describe the currently open result set
+ */
+struct sqlanywhere_fetch_args {
+  VALUE self;
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  sacapi_i32 num_cols;
+  sqlanywhere_column_plan *columns;
+  struct sqlanywhere_data_to_rb_data_args data;
+  long rows_fetched;
+  size_t bytes_fetched;
+  int limited;
+  int rowset_active;
+  int rowset_short;
+  sacapi_u32 rowset_fetched;
+  sacapi_u32 rowset_index;
+  sacapi_i32 reposition;
+  long chunk_rows;
+  sqlanywhere_staging_chunk *chunk;
+  int prefetch;
+  int lob_stream;
+  enum sqlanywhere_row_shape shape;
+  VALUE keys;
+  VALUE row_struct;
+  uint64_t started;
+  uint64_t fetch_ns;
+};
+
+/*
+ * used to pass all arguments to cursor page fetching while inside rb_ensure
+ */
+struct sqlanywhere_page_args {
+  struct sqlanywhere_fetch_args *fetch;
+  long count;
 };
 
 /*
@@ -39,560 +117,3444 @@ struct sqlanywhere_data_to_rb_data_args {
  */
 struct rb_data_to_sqlanywhere_data_args {
   rb_encoding *encoding;
+  sqlanywhere_connection_wrapper *connection_wrapper;
   VALUE arg;
-  a_sqlany_data_value *value;
+  sqlanywhere_bind_param *bind;
 };
 
-// Free all allocated bind_params
-#define FREE_BINDS                              \
-  for (i = 0; i < alloc_count; i++) {           \
-    xfree(bind_params[i].value.is_null);        \
-    xfree(bind_params[i].value.length);         \
-    if (bind_params[i].value.buffer != NULL) {  \
-      xfree(bind_params[i].value.buffer);       \
-    }                                           \
-  }                                             \
-
-static void rb_data_to_sqlanywhere_data(struct rb_data_to_sqlanywhere_data_args data) {
-  a_sqlany_data_value *value = data.value;
-  VALUE arg = data.arg;
-  size_t length;
-  rb_encoding *arg_encoding;
+/*
+ * Column-wise array of values for a single bind parameter of a batch
+ * width is the widest value of the current batch, row_width the one of the row being fitted
+ */
+struct sqlanywhere_batch_param {
+  a_sqlany_bind_param param;
+  char *buffer;
+  size_t capacity;
+  size_t width;
+  size_t row_width;
+  size_t *lengths;
+  sacapi_bool *nulls;
+};
+
+/*
+ * used to pass all arguments to copy_out while inside rb_ensure
+ */
+struct sqlanywhere_copy_out_args {
+  struct sqlanywhere_fetch_args *fetch;
+  sqlanywhere_copy_format format;
+  VALUE io;
+  VALUE buffer;
+};
+
+/*
+ * used to pass all arguments to columnar fetching while inside rb_ensure
+ */
+struct sqlanywhere_columnar_args {
+  struct sqlanywhere_fetch_args *fetch;
+  sqlanywhere_columnar_column *columns;
+};
+
+/*
+ * used to pass all arguments to copy_in while inside rb_ensure
+ */
+struct sqlanywhere_copy_in_args {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  sqlanywhere_copy_parser parser;
+  struct sqlanywhere_batch_param *params;
+  VALUE io;
+  int commit;
+  long rows;
+  long batches;
+};
 
-  value->is_null = xmalloc(sizeof(int));
-  value->length = xmalloc(sizeof(size_t));
+/*
+ * used to pass all arguments to batch execution while inside rb_ensure
+ */
+struct sqlanywhere_batch_args {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  VALUE rows;
+  long batch_size;
+  struct sqlanywhere_batch_param *params;
+  sqlanywhere_bind_param scratch;
+};
 
-  *((int*)value->is_null) = 0;
+/*
+ * Copies string into bind buffer, growing it only when value doesn't fit
+ */
+static void sqlanywhere_bind_string(sqlanywhere_bind_param *bind, const char *ptr, size_t length) {
+  if (bind->capacity < length || bind->buffer == NULL) {
+    bind->capacity = length > bind->capacity * 2 ? length : bind->capacity * 2;
+    bind->capacity = bind->capacity < 16 ? 16 : bind->capacity;
+    REALLOC_N(bind->buffer, char, bind->capacity);
+  }
 
-  switch(TYPE(arg)) {
-    case T_STRING:
-      arg_encoding = rb_enc_get(arg);
-      length = RSTRING_LEN(arg);
+  memcpy(bind->buffer, ptr, length);
+  bind->length = length;
+  bind->param.value.buffer = bind->buffer;
+}
 
-      value->buffer = xmalloc(length);
-      memcpy(value->buffer, RSTRING_PTR(arg), length);
-      *value->length = length;
+/*
+ * Writes value as exactly width decimal digits
+ */
+static char *sqlanywhere_put_digits(char *out, long value, int width) {
+  int i;
 
-      value->type = A_STRING;
-      // If encoding is ASCII_8BIT then this is a binary string
-      if (arg_encoding == rb_ascii8bit_encoding()) {
-        value->type = A_BINARY;
-      }
+  for (i = width - 1; i >= 0; i--) {
+    out[i] = (char)('0' + value % 10);
+    value /= 10;
+  }
 
-      break;
-  case T_FIXNUM:
-    if (sizeof(void*) == 4) {
-      value->buffer = xmalloc(sizeof(int));
-      *((int*)value->buffer) = FIX2INT(arg);
-      value->type = A_VAL32;
-    } else {
-      value->buffer = xmalloc(sizeof(long));
-      *((long*)value->buffer) = FIX2LONG(arg);
-      value->type = A_VAL64;
-    }
+  return out + width;
+}
+
+/*
+ * Formats YYYY-MM-DD, the format DATE values are read in
+ */
+static char *sqlanywhere_put_date(char *out, int year, int mon, int day) {
+  if (year < 1 || year > 9999) {
+    rb_raise(rb_eRangeError, "year %d is out of range for SQLAnywhere dates", year);
+  }
+
+  out = sqlanywhere_put_digits(out, year, 4);
+  *out++ = '-';
+  out = sqlanywhere_put_digits(out, mon, 2);
+  *out++ = '-';
+
+  return sqlanywhere_put_digits(out, day, 2);
+}
+
+static void sqlanywhere_bind_fixed(sqlanywhere_bind_param *bind, a_sqlany_data_type type, size_t length) {
+  bind->length = length;
+  bind->param.value.buffer = (char *)&bind->fixed;
+  bind->param.value.type = type;
+}
+
+static void bind_string(struct rb_data_to_sqlanywhere_data_args *data) {
+  VALUE arg = data->arg;
+
+  sqlanywhere_bind_string(data->bind, RSTRING_PTR(arg), RSTRING_LEN(arg));
+
+  data->bind->param.value.type = A_STRING;
+  // If encoding is ASCII_8BIT then this is a binary string
+  if (rb_enc_get(arg) == rb_ascii8bit_encoding()) {
+    data->bind->param.value.type = A_BINARY;
+  }
+}
+
+static void bind_integer(struct rb_data_to_sqlanywhere_data_args *data) {
+  sqlanywhere_bind_param *bind = data->bind;
+  VALUE str;
 
-    break;
   // Since some BIGNUMs don't fit into LONG_LONG always send as STRING type
-  case T_BIGNUM:
-    arg = rb_big2str(arg, 10);
-    length = RSTRING_LEN(arg);
+  if (!FIXNUM_P(data->arg)) {
+    str = rb_big2str(data->arg, 10);
+    sqlanywhere_bind_string(bind, RSTRING_PTR(str), RSTRING_LEN(str));
+    bind->param.value.type = A_STRING;
+    RB_GC_GUARD(str);
+    return;
+  }
+
+  if (sizeof(void*) == 4) {
+    bind->fixed.val32 = FIX2INT(data->arg);
+    sqlanywhere_bind_fixed(bind, A_VAL32, sizeof(int));
+  } else {
+    bind->fixed.val64 = FIX2LONG(data->arg);
+    sqlanywhere_bind_fixed(bind, A_VAL64, sizeof(LONG_LONG));
+  }
+}
 
-    value->buffer = xmalloc(length);
-    memcpy(value->buffer, RSTRING_PTR(arg), length);
-    value->type = A_STRING;
-    *value->length = length;
+static void bind_float(struct rb_data_to_sqlanywhere_data_args *data) {
+  data->bind->fixed.val_double = NUM2DBL(data->arg);
+  sqlanywhere_bind_fixed(data->bind, A_DOUBLE, sizeof(double));
+}
 
-    break;
+static void bind_nil(struct rb_data_to_sqlanywhere_data_args *data) {
+  data->bind->param.value.buffer = NULL;
+  data->bind->param.value.type = A_VAL32;
+  data->bind->length = 0;
+  data->bind->is_null = 1;
+}
+
+static void bind_boolean(struct rb_data_to_sqlanywhere_data_args *data) {
+  data->bind->fixed.val8 = data->arg == Qtrue;
+  sqlanywhere_bind_fixed(data->bind, A_VAL8, 1);
+}
+
+/*
+ * Symbols are sent as their frozen name, no string is allocated
+ */
+static void bind_symbol(struct rb_data_to_sqlanywhere_data_args *data) {
+  VALUE name = rb_sym2str(data->arg);
+
+  sqlanywhere_bind_string(data->bind, RSTRING_PTR(name), RSTRING_LEN(name));
+  data->bind->param.value.type = A_STRING;
+}
+
+/*
+ * Formats Time as YYYY-MM-DD HH:NN:SS.SSSSSS in database_timezone, the format TIMESTAMP values are read in
+ */
+static void bind_time(struct rb_data_to_sqlanywhere_data_args *data) {
+  struct timespec ts = rb_time_timespec(data->arg);
+  time_t seconds = ts.tv_sec;
+  struct tm tm;
+  char buffer[32];
+  char *out = buffer;
+
+  if ((data->connection_wrapper->utc ? gmtime_r(&seconds, &tm) : localtime_r(&seconds, &tm)) == NULL) {
+    rb_raise(rb_eRangeError, "time is out of range for SQLAnywhere timestamps");
+  }
+
+  out = sqlanywhere_put_date(out, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+  *out++ = ' ';
+  out = sqlanywhere_put_digits(out, tm.tm_hour, 2);
+  *out++ = ':';
+  out = sqlanywhere_put_digits(out, tm.tm_min, 2);
+  *out++ = ':';
+  // Leap seconds are not supported by SQLAnywhere
+  out = sqlanywhere_put_digits(out, tm.tm_sec > 59 ? 59 : tm.tm_sec, 2);
+  *out++ = '.';
+  out = sqlanywhere_put_digits(out, ts.tv_nsec / 1000, 6);
+
+  sqlanywhere_bind_string(data->bind, buffer, (size_t)(out - buffer));
+  data->bind->param.value.type = A_STRING;
+}
+
+/*
+ * DateTime keeps its own offset, it is sent as the same instant as Time
+ */
+static void bind_datetime(struct rb_data_to_sqlanywhere_data_args *data) {
+  VALUE datetime = data->arg;
+
+  data->arg = rb_funcall(datetime, intern_to_time, 0);
+  bind_time(data);
+  data->arg = datetime;
+}
+
+/*
+ * Civil fields are used instead of the julian day, so dates before the calendar reform keep their year
+ */
+static void bind_date(struct rb_data_to_sqlanywhere_data_args *data) {
+  char buffer[16];
+  char *out;
+
+  out = sqlanywhere_put_date(
+    buffer,
+    NUM2INT(rb_funcall(data->arg, intern_year, 0)),
+    NUM2INT(rb_funcall(data->arg, intern_mon, 0)),
+    NUM2INT(rb_funcall(data->arg, intern_mday, 0))
+  );
+
+  sqlanywhere_bind_string(data->bind, buffer, (size_t)(out - buffer));
+  data->bind->param.value.type = A_STRING;
+}
+
+/*
+ * BigDecimal is sent as its digits in plain notation, so no precision is lost
+ */
+static void bind_bigdecimal(struct rb_data_to_sqlanywhere_data_args *data) {
+  VALUE digits = rb_funcall(data->arg, intern_to_s, 1, str_plain_format);
+
+  sqlanywhere_bind_string(data->bind, RSTRING_PTR(digits), RSTRING_LEN(digits));
+  data->bind->param.value.type = A_STRING;
+  RB_GC_GUARD(digits);
+}
+
+/*
+ * Binds an IO without a buffer, data is sent in chunks after binding
+ * IO with a text external encoding is sent as a string, otherwise as binary
+ */
+static void bind_stream(struct rb_data_to_sqlanywhere_data_args *data) {
+  sqlanywhere_bind_param *bind = data->bind;
+  VALUE encoding = Qnil;
+
+  if (rb_respond_to(data->arg, intern_external_encoding)) {
+    encoding = rb_funcall(data->arg, intern_external_encoding, 0);
+  }
+
+  bind->param.value.type = A_BINARY;
+
+  if (!NIL_P(encoding) && rb_to_encoding(encoding) != rb_ascii8bit_encoding()) {
+    bind->param.value.type = A_STRING;
+  }
+
+  bind->param.value.buffer = NULL;
+  bind->length = 0;
+  bind->streamed = 1;
+}
+
+/*
+ * Chooses encoder for the class of arg, all instances of a class are encoded the same way
+ */
+static sqlanywhere_bind_encoder sqlanywhere_bind_encoder_for(VALUE arg) {
+  switch(TYPE(arg)) {
+  case T_STRING:
+    return bind_string;
+  case T_FIXNUM:
+  case T_BIGNUM:
+    return bind_integer;
   case T_FLOAT:
-    value->buffer = xmalloc(sizeof(double));
-    *((double*)value->buffer) = (double) NUM2DBL(arg);
-    value->type = A_DOUBLE;
-    break;
+    return bind_float;
   case T_NIL:
-    value->buffer = NULL;
-    value->type = A_VAL32;
-    *((int*)value->is_null) = 1;
-    break;
+    return bind_nil;
+  case T_TRUE:
+  case T_FALSE:
+    return bind_boolean;
+  case T_SYMBOL:
+    return bind_symbol;
   default:
-    rb_raise(rb_eTypeError, "Cannot convert type. Must be STRING, FIXNUM, BIGNUM, FLOAT, or NIL");
     break;
   }
+
+  if (rb_obj_is_kind_of(arg, rb_cTime)) {
+    return bind_time;
+  }
+
+  // DateTime is a subclass of Date
+  if (rb_obj_is_kind_of(arg, cDateTime)) {
+    return bind_datetime;
+  }
+
+  if (rb_obj_is_kind_of(arg, cDate)) {
+    return bind_date;
+  }
+
+  if (rb_obj_is_kind_of(arg, cBigDecimal)) {
+    return bind_bigdecimal;
+  }
+
+  if (rb_respond_to(arg, intern_read)) {
+    return bind_stream;
+  }
+
+  rb_raise(
+    rb_eTypeError,
+    "Cannot convert type. Must be STRING, INTEGER, FLOAT, NIL, TRUE, FALSE, SYMBOL, TIME, DATE, DATETIME, BIGDECIMAL or IO"
+  );
+
+  return NULL;
 }
 
-static VALUE sqlanywhere_data_to_rb_data(struct sqlanywhere_data_to_rb_data_args data) {
-  a_sqlany_data_value *value = data.value;
-  a_sqlany_column_info *info = data.info;
-  VALUE ret_data;
+/*
+ * Encodes arg into bind buffers, the type switch is skipped while arg has the class of the previously bound value
+ */
+static void rb_data_to_sqlanywhere_data(struct rb_data_to_sqlanywhere_data_args *data) {
+  sqlanywhere_bind_param *bind = data->bind;
+  VALUE klass = rb_class_of(data->arg);
 
-  if (*value->is_null) {
-    ret_data = Qnil;
-  } else {
-    switch(value->type) {
-    case A_BINARY:
-      ret_data = rb_str_new(value->buffer, *value->length);
-      break;
-    case A_STRING:
-      ret_data = rb_str_new(value->buffer, *value->length);
-      rb_enc_associate(ret_data, data.encoding);
-      break;
-    case A_DOUBLE:
-      ret_data = rb_float_new(*(double*) value->buffer);
-      break;
-    case A_VAL64:
-      ret_data = LL2NUM(*(LONG_LONG*)value->buffer);
-      break;
-    case A_UVAL64:
-      ret_data = ULL2NUM(*(unsigned LONG_LONG*)value->buffer);
-      break;
-    case A_VAL32:
-      ret_data = INT2NUM(*(int *)value->buffer);
-      break;
-    case A_UVAL32:
-      ret_data = UINT2NUM(*(unsigned int *)value->buffer);
-      break;
-    case A_VAL16:
-      ret_data = INT2NUM(*(short *)value->buffer);
-      break;
-    case A_UVAL16:
-      ret_data = UINT2NUM(*(unsigned short *)value->buffer);
-      break;
-    case A_VAL8:
-    case A_UVAL8:
-      ret_data = CHR2FIX(*(unsigned char *)value->buffer);
-      break;
-    case A_INVALID_TYPE:
-      rb_raise(rb_eTypeError, "Invalid Data Type");
-    default:
-      ret_data = Qnil;
-      break;
+  if (bind->encode == NULL || bind->klass != klass) {
+    bind->encode = sqlanywhere_bind_encoder_for(data->arg);
+    bind->klass = klass;
+  }
+
+  bind->is_null = 0;
+  bind->streamed = 0;
+
+  bind->encode(data);
+
+  bind->param.value.buffer_size = bind->length;
+}
+
+static void *nogvl_stmt_execute(void *ptr) {
+  struct nogvl_stmt_execute_args *args = ptr;
+  sacapi_bool result;
+
+  result = sqlany_execute(args->stmt);
+
+  return (void*)(result != 0 ? Qtrue : Qfalse);
+}
+
+/*
+ * Statement is reset right after execution, its result set is never described or fetched
+ * Failed statement is left for the caller to reset once the error is read
+ */
+static void *nogvl_stmt_execute_update(void *ptr) {
+  struct nogvl_stmt_update_args *args = ptr;
+
+  if (!sqlany_execute(args->execute.stmt)) {
+    return (void*)Qfalse;
+  }
+
+  args->affected = sqlany_affected_rows(args->execute.stmt);
+
+  if (args->affected < 0) {
+    return (void*)Qfalse;
+  }
+
+  args->reset = 1;
+
+  return (void*)(sqlany_reset(args->execute.stmt) ? Qtrue : Qfalse);
+}
+
+static void nogvl_stmt_execute_ubf(void *ptr) {
+  struct nogvl_stmt_execute_args *args = ptr;
+
+  sqlany_cancel(args->connection);
+}
+
+static void nogvl_stmt_cancel(void *ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
+
+  sqlany_cancel(stmt_wrapper->connection_wrapper->connection);
+}
+
+static void *nogvl_stmt_send_param_data(void *ptr) {
+  struct nogvl_send_param_data_args *args = ptr;
+  sacapi_bool result;
+
+  result = sqlany_send_param_data(args->execute.stmt, args->index, args->buffer, args->size);
+
+  return (void*)(result != 0 ? Qtrue : Qfalse);
+}
+
+static void *nogvl_stmt_close(void *ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
+
+  if (!stmt_wrapper->closed) {
+    stmt_wrapper->closed = 1;
+
+    if (sqlanywhere_connection_owned(stmt_wrapper->connection_wrapper)) {
+      sqlany_free_stmt(stmt_wrapper->stmt);
     }
+  }
 
-    if (data.cast) {
-      switch(info->native_type) {
-      case DT_DECIMAL:
-        ret_data = rb_funcall(rb_cObject, intern_BigDecimal, 1, ret_data);
-        break;
-      case DT_DATE:
-        ret_data = rb_funcall(cDate, intern_parse, 1, ret_data);
-        break;
-      case DT_TIMESTAMP:
-        ret_data = rb_funcall(cTime, intern_parse, 1, ret_data);
+  return NULL;
+}
+
+static void *nogvl_stmt_next_result(void *ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
+  sacapi_bool result = 0;
+
+  if (!stmt_wrapper->closed) {
+    result = sqlany_get_next_result(stmt_wrapper->stmt);
+  }
+
+  return (void*)(result != 0 ? Qtrue : Qfalse);
+}
+
+static void *nogvl_stmt_fetch_next(void *ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
+  sacapi_bool result = 0;
+
+  if (!stmt_wrapper->closed) {
+    result = sqlany_fetch_next(stmt_wrapper->stmt);
+  }
+
+  return (void*)(result != 0 ? Qtrue : Qfalse);
+}
+
+static void rb_sqlanywhere_stmt_free_rowset(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sacapi_i32 i;
+
+  for (i = 0; i < stmt_wrapper->rowset_cols; i++) {
+    xfree(stmt_wrapper->rowset[i].buffer);
+    xfree(stmt_wrapper->rowset[i].lengths);
+    xfree(stmt_wrapper->rowset[i].nulls);
+  }
+
+  xfree(stmt_wrapper->rowset);
+  stmt_wrapper->rowset = NULL;
+  stmt_wrapper->rowset_cols = 0;
+  stmt_wrapper->rowset_size = 0;
+}
+
+static void rb_sqlanywhere_stmt_mark(void * ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
+  sacapi_i32 i;
+
+  if (!stmt_wrapper) return;
+
+  rb_gc_mark(stmt_wrapper->connection);
+  rb_gc_mark(stmt_wrapper->column_list);
+  rb_gc_mark(stmt_wrapper->decimal_buffer);
+  rb_gc_mark(stmt_wrapper->column_keys);
+  rb_gc_mark(stmt_wrapper->column_symbols);
+  rb_gc_mark(stmt_wrapper->row_struct);
+
+  for (i = 0; i < stmt_wrapper->num_params; i++) {
+    rb_gc_mark(stmt_wrapper->binds[i].klass);
+  }
+}
+
+void sqlanywhere_stmt_free_binds(sqlanywhere_bind_param *binds, sacapi_i32 num_params) {
+  sacapi_i32 i;
+
+  if (binds) {
+    for (i = 0; i < num_params; i++) {
+      xfree(binds[i].buffer);
+    }
+
+    xfree(binds);
+  }
+}
+
+static void rb_sqlanywhere_stmt_free(void *ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
+
+  rb_sqlanywhere_async_sweep();
+
+  // Running asynchronous execution is cancelled, its worker then frees the statement and binds
+  if (stmt_wrapper->job) {
+    if (
+      sqlanywhere_connection_owned(stmt_wrapper->connection_wrapper) &&
+      !stmt_wrapper->closed &&
+      sqlanywhere_async_abandon(stmt_wrapper->job, 1, 0, stmt_wrapper->binds, stmt_wrapper->num_params)
+    ) {
+      stmt_wrapper->closed = 1;
+      stmt_wrapper->binds = NULL;
+    }
+
+    sqlanywhere_async_release(stmt_wrapper->job);
+  }
+
+  nogvl_stmt_close(stmt_wrapper);
+  xfree(stmt_wrapper->columns);
+
+  // Unlinks from connection's statement list
+  if (stmt_wrapper->prev) {
+    stmt_wrapper->prev->next = stmt_wrapper->next;
+  } else {
+    stmt_wrapper->connection_wrapper->statements = stmt_wrapper->next;
+  }
+
+  if (stmt_wrapper->next) {
+    stmt_wrapper->next->prev = stmt_wrapper->prev;
+  }
+
+  sqlanywhere_stmt_free_binds(stmt_wrapper->binds, stmt_wrapper->num_params);
+  rb_sqlanywhere_stmt_free_rowset(stmt_wrapper);
+  sqlanywhere_staging_free(&stmt_wrapper->staging);
+  decr_sqlanywhere_connection(stmt_wrapper->connection_wrapper);
+  xfree(stmt_wrapper);
+}
+
+/*
+ * Closes every open statement of a connection, statements stay linked until they are garbage collected
+ */
+void sqlanywhere_stmt_close_all(sqlanywhere_connection_wrapper *connection_wrapper) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+
+  for (stmt_wrapper = connection_wrapper->statements; stmt_wrapper != NULL; stmt_wrapper = stmt_wrapper->next) {
+    if (stmt_wrapper->job) {
+      rb_sqlanywhere_async_cancel_wait(stmt_wrapper->job);
+    }
+
+    if (!stmt_wrapper->closed) {
+      rb_thread_call_without_gvl(nogvl_stmt_close, stmt_wrapper, RUBY_UBF_IO, 0);
+    }
+  }
+}
+
+static void rb_raise_sqlanywhere_stmt_error(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  rb_raise_sqlanywhere_error(stmt_wrapper->connection);
+}
+
+/*
+ * stats are counters of preparing the statement, or of executing it when it was executed directly
+ */
+VALUE rb_sqlanywhere_stmt_new(VALUE connection, a_sqlany_stmt *stmt, const sqlanywhere_stats *stats) {
+  GET_CONNECTION(connection);
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  VALUE rb_stmt;
+
+  rb_stmt = Data_Make_Struct(
+    cSQLAnywhere2Statement,
+    sqlanywhere_stmt_wrapper,
+    rb_sqlanywhere_stmt_mark,
+    rb_sqlanywhere_stmt_free,
+    stmt_wrapper
+  );
+
+  stmt_wrapper->self = rb_stmt;
+  stmt_wrapper->connection = connection;
+  stmt_wrapper->connection_wrapper = DATA_PTR(connection);
+  stmt_wrapper->connection_wrapper->refcount++;
+  stmt_wrapper->closed = 0;
+  stmt_wrapper->fetched = 0;
+  stmt_wrapper->streaming = 0;
+  stmt_wrapper->encoding = rb_sqlanywhere_encoding(connection);
+  stmt_wrapper->num_cols = 0;
+  stmt_wrapper->columns = NULL;
+  stmt_wrapper->column_list = Qnil;
+  stmt_wrapper->decimal_buffer = Qnil;
+  stmt_wrapper->column_keys = Qnil;
+  stmt_wrapper->column_symbols = Qnil;
+  stmt_wrapper->row_struct = Qnil;
+  stmt_wrapper->shape = ROW_AS_ARRAY;
+  stmt_wrapper->columnar = 0;
+  stmt_wrapper->limits = stmt_wrapper->connection_wrapper->limits;
+  stmt_wrapper->lob_stream = 0;
+  stmt_wrapper->result_sets = 0;
+  stmt_wrapper->result_index = 0;
+  stmt_wrapper->row_generation = 0;
+  stmt_wrapper->num_params = -1;
+  stmt_wrapper->binds = NULL;
+  stmt_wrapper->fetch_size = stmt_wrapper->connection_wrapper->fetch_size;
+  stmt_wrapper->rowset_size = 0;
+  stmt_wrapper->rowset_cols = 0;
+  stmt_wrapper->rowset = NULL;
+  stmt_wrapper->rowset_bound = 0;
+  memset(&stmt_wrapper->staging, 0, sizeof(sqlanywhere_staging));
+  stmt_wrapper->job = NULL;
+  stmt_wrapper->stmt = stmt;
+  memset(&stmt_wrapper->stats, 0, sizeof(sqlanywhere_stats));
+  stmt_wrapper->run = *stats;
+
+  stmt_wrapper->prev = NULL;
+  stmt_wrapper->next = stmt_wrapper->connection_wrapper->statements;
+
+  if (stmt_wrapper->next) {
+    stmt_wrapper->next->prev = stmt_wrapper;
+  }
+
+  stmt_wrapper->connection_wrapper->statements = stmt_wrapper;
+
+  // Preparation is counted right away, executions once their result is read
+  if (stats->executions == 0) {
+    rb_sqlanywhere_stmt_finish_run(stmt_wrapper);
+  }
+
+  return rb_stmt;
+}
+
+static VALUE rb_sqlanywhere_stmt_call_stats_hook(VALUE ptr) {
+  VALUE *args = (VALUE *)ptr;
+
+  return rb_funcall(args[0], intern_call, 2, args[1], args[2]);
+}
+
+/*
+ * Adds counters of the current execution to statement and connection stats and passes them to stats_hook
+ * Errors raised by the hook are reported as warnings, so that they never break the execution
+ */
+void rb_sqlanywhere_stmt_finish_run(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sqlanywhere_stats run = stmt_wrapper->run;
+  VALUE args[3];
+  int state = 0;
+
+  memset(&stmt_wrapper->run, 0, sizeof(sqlanywhere_stats));
+  sqlanywhere_stats_add(&stmt_wrapper->stats, &run);
+  sqlanywhere_stats_add(&stmt_wrapper->connection_wrapper->stats, &run);
+
+  if (run.executions == 0) {
+    return;
+  }
+
+  args[0] = rb_ivar_get(stmt_wrapper->connection, intern_stats_hook);
+
+  if (NIL_P(args[0])) {
+    return;
+  }
+
+  args[1] = stmt_wrapper->self;
+  args[2] = rb_sqlanywhere_stats_hash(&run);
+
+  rb_protect(rb_sqlanywhere_stmt_call_stats_hook, (VALUE)args, &state);
+
+  if (state) {
+    rb_warn("stats_hook raised %"PRIsVALUE, rb_errinfo());
+    rb_set_errinfo(Qnil);
+  }
+}
+
+/*
+ * Checks intern_strings and intern_max_size connection options for a string column
+ */
+static int rb_sqlanywhere_stmt_intern_column(VALUE intern_strings, VALUE intern_max_size, a_sqlany_column_info *info) {
+  size_t name_len;
+  VALUE name;
+  long i;
+
+  if (!RTEST(intern_strings)) {
+    return 0;
+  }
+
+  if (!NIL_P(intern_max_size) && info->max_size > NUM2SIZET(intern_max_size)) {
+    return 0;
+  }
+
+  if (!RB_TYPE_P(intern_strings, T_ARRAY)) {
+    return 1;
+  }
+
+  name_len = strlen(info->name);
+
+  for (i = 0; i < RARRAY_LEN(intern_strings); i++) {
+    name = RARRAY_AREF(intern_strings, i);
+
+    if ((size_t)RSTRING_LEN(name) == name_len && memcmp(RSTRING_PTR(name), info->name, name_len) == 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * Checks that every column of the current result set is described the same as in the cached plan
+ */
+static int rb_sqlanywhere_stmt_plan_matches(sqlanywhere_stmt_wrapper *stmt_wrapper, sacapi_i32 num_cols) {
+  a_sqlany_column_info info;
+  a_sqlany_column_info *cached;
+  VALUE key;
+  sacapi_i32 i;
+
+  if (stmt_wrapper->column_list == Qnil || stmt_wrapper->num_cols != num_cols) {
+    return 0;
+  }
+
+  for (i = 0; i < num_cols; i++) {
+    if (sqlany_get_column_info(stmt_wrapper->stmt, i, &info) == 0) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+
+    cached = &stmt_wrapper->columns[i].info;
+    key = RARRAY_AREF(stmt_wrapper->column_keys, i);
+
+    if (
+      info.native_type != cached->native_type ||
+      info.type != cached->type ||
+      info.max_size != cached->max_size ||
+      info.precision != cached->precision ||
+      info.scale != cached->scale ||
+      info.nullable != cached->nullable ||
+      strlen(info.name) != (size_t)RSTRING_LEN(key) ||
+      memcmp(info.name, RSTRING_PTR(key), RSTRING_LEN(key)) != 0
+    ) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/*
+ * Builds column metadata, Column list and converters for the current result set
+ * Plan is reused by following executions while every column is described the same,
+ * converters fall back to generic conversion if a value type differs from the described one
+ */
+static void rb_sqlanywhere_stmt_build_plan(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sacapi_i32 num_cols = sqlany_num_cols(stmt_wrapper->stmt);
+  int cast = stmt_wrapper->connection_wrapper->cast;
+  VALUE intern_strings = rb_iv_get(stmt_wrapper->connection, "@intern_strings");
+  VALUE intern_max_size = rb_iv_get(stmt_wrapper->connection, "@intern_max_size");
+  sqlanywhere_column_plan *columns;
+  VALUE column_list;
+  VALUE column_keys;
+  sacapi_i32 i;
+
+  if (num_cols < 0) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  if (rb_sqlanywhere_stmt_plan_matches(stmt_wrapper, num_cols)) {
+    return;
+  }
+
+  // Plan is rebuilt in place, an error leaves it empty
+  stmt_wrapper->num_cols = 0;
+  stmt_wrapper->column_list = Qnil;
+  REALLOC_N(stmt_wrapper->columns, sqlanywhere_column_plan, num_cols);
+
+  column_list = rb_ary_new2((long)num_cols);
+  column_keys = rb_ary_new2((long)num_cols);
+  columns = stmt_wrapper->columns;
+
+  for (i = 0; i < num_cols; i++) {
+    if (sqlany_get_column_info(stmt_wrapper->stmt, i, &columns[i].info) == 0) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+
+    columns[i].convert = sqlanywhere_column_converter_for(
+      &columns[i].info,
+      cast,
+      rb_sqlanywhere_stmt_intern_column(intern_strings, intern_max_size, &columns[i].info)
+    );
+
+    if (cast && columns[i].info.native_type == DT_DECIMAL && stmt_wrapper->decimal_buffer == Qnil) {
+      stmt_wrapper->decimal_buffer = rb_str_buf_new(64);
+    }
+
+    rb_ary_store(column_list, (long)i, rb_sqlanywhere_column_new(&columns[i].info));
+    rb_ary_store(column_keys, (long)i, sqlanywhere_interned_str(columns[i].info.name, strlen(columns[i].info.name), stmt_wrapper->encoding));
+    // Name is owned by dbcapi and is not valid after the next describe
+    columns[i].info.name = NULL;
+  }
+
+  stmt_wrapper->num_cols = num_cols;
+  stmt_wrapper->column_list = rb_obj_freeze(column_list);
+  stmt_wrapper->column_keys = rb_obj_freeze(column_keys);
+  stmt_wrapper->column_symbols = Qnil;
+  stmt_wrapper->row_struct = Qnil;
+}
+
+/*
+ * Returns Struct class with members named after columns, classes are shared between statements
+ */
+static VALUE rb_sqlanywhere_stmt_row_struct(VALUE symbols) {
+  VALUE row_struct = rb_hash_lookup2(row_structs, symbols, Qnil);
+
+  if (row_struct == Qnil) {
+    if (RHASH_SIZE(row_structs) >= ROW_STRUCTS_MAX) {
+      rb_hash_clear(row_structs);
+    }
+
+    row_struct = rb_funcallv(rb_cStruct, intern_new, (int)RARRAY_LEN(symbols), RARRAY_CONST_PTR(symbols));
+    rb_hash_aset(row_structs, symbols, row_struct);
+  }
+
+  return row_struct;
+}
+
+/*
+ * Prepares keys or Struct class for the requested row shape, both are built once per column list
+ */
+static void rb_sqlanywhere_stmt_prepare_shape(sqlanywhere_stmt_wrapper *stmt_wrapper, struct sqlanywhere_fetch_args *fetch) {
+  VALUE symbols;
+  long i;
+
+  fetch->shape = stmt_wrapper->shape;
+  fetch->keys = stmt_wrapper->column_keys;
+  fetch->row_struct = Qnil;
+
+  if (fetch->shape != ROW_AS_SYMBOL_HASH && fetch->shape != ROW_AS_STRUCT) {
+    return;
+  }
+
+  if (stmt_wrapper->column_symbols == Qnil) {
+    symbols = rb_ary_new2(RARRAY_LEN(stmt_wrapper->column_keys));
+
+    for (i = 0; i < RARRAY_LEN(stmt_wrapper->column_keys); i++) {
+      rb_ary_store(symbols, i, rb_str_intern(RARRAY_AREF(stmt_wrapper->column_keys, i)));
+    }
+
+    stmt_wrapper->column_symbols = rb_obj_freeze(symbols);
+  }
+
+  fetch->keys = stmt_wrapper->column_symbols;
+
+  if (fetch->shape == ROW_AS_STRUCT) {
+    if (stmt_wrapper->row_struct == Qnil) {
+      stmt_wrapper->row_struct = rb_sqlanywhere_stmt_row_struct(stmt_wrapper->column_symbols);
+    }
+
+    fetch->row_struct = stmt_wrapper->row_struct;
+  }
+}
+
+/*
+ * Sets row shape used by following fetches from an as: option value, nil means :array
+ * Results are built from rows again, with result limits of the connection, until execute asks otherwise
+ */
+void rb_sqlanywhere_stmt_set_shape(VALUE self, VALUE as) {
+  GET_STATEMENT(self);
+
+  stmt_wrapper->columnar = 0;
+  stmt_wrapper->limits = stmt_wrapper->connection_wrapper->limits;
+
+  if (NIL_P(as) || as == Qundef || as == sym_array) {
+    stmt_wrapper->shape = ROW_AS_ARRAY;
+  } else if (as == sym_hash) {
+    stmt_wrapper->shape = ROW_AS_HASH;
+  } else if (as == sym_symbol_hash) {
+    stmt_wrapper->shape = ROW_AS_SYMBOL_HASH;
+  } else if (as == sym_struct) {
+    stmt_wrapper->shape = ROW_AS_STRUCT;
+  } else {
+    rb_raise(cSQLAnywhere2Error, "as: option must be one of :array, :hash, :symbol_hash, :struct");
+  }
+}
+
+static VALUE rb_sqlanywhere_stmt_shape_sym(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  switch(stmt_wrapper->shape) {
+  case ROW_AS_HASH:
+    return sym_hash;
+  case ROW_AS_SYMBOL_HASH:
+    return sym_symbol_hash;
+  case ROW_AS_STRUCT:
+    return sym_struct;
+  default:
+    return sym_array;
+  }
+}
+
+/*
+ * Returns statement to single row fetching
+ */
+static void rb_sqlanywhere_stmt_unbind_rowset(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+#if _SACAPI_VERSION+0 >= 4
+  if (stmt_wrapper->rowset_bound && !stmt_wrapper->closed) {
+    sqlany_clear_column_bindings(stmt_wrapper->stmt);
+    sqlany_set_rowset_size(stmt_wrapper->stmt, 1);
+  }
+#endif
+
+  stmt_wrapper->rowset_bound = 0;
+}
+
+#if _SACAPI_VERSION+0 >= 4
+static size_t sqlanywhere_rowset_width(a_sqlany_column_info *info) {
+  switch(info->type) {
+  case A_STRING:
+  case A_BINARY:
+    return info->max_size < ROWSET_MAX_COLUMN_WIDTH ? info->max_size + 1 : 0;
+  case A_DOUBLE:
+  case A_VAL64:
+  case A_UVAL64:
+    return 8;
+  case A_VAL32:
+  case A_UVAL32:
+    return 4;
+  case A_VAL16:
+  case A_UVAL16:
+    return 2;
+  case A_VAL8:
+  case A_UVAL8:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/*
+ * Binds column arrays for fetching fetch_size rows at once
+ * Returns 0 if some column can't be fetched this way, in which case rows are fetched one by one
+ */
+static int rb_sqlanywhere_stmt_bind_rowset(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sacapi_u32 size = stmt_wrapper->fetch_size;
+  sqlanywhere_rowset_column *column;
+  a_sqlany_data_value value;
+  sacapi_i32 i;
+
+  for (i = 0; i < stmt_wrapper->num_cols; i++) {
+    if (sqlanywhere_rowset_width(&stmt_wrapper->columns[i].info) == 0) {
+      return 0;
+    }
+  }
+
+  if (stmt_wrapper->rowset_cols != stmt_wrapper->num_cols || stmt_wrapper->rowset_size != size) {
+    rb_sqlanywhere_stmt_free_rowset(stmt_wrapper);
+
+    stmt_wrapper->rowset = ZALLOC_N(sqlanywhere_rowset_column, stmt_wrapper->num_cols);
+    stmt_wrapper->rowset_cols = stmt_wrapper->num_cols;
+    stmt_wrapper->rowset_size = size;
+
+    for (i = 0; i < stmt_wrapper->num_cols; i++) {
+      column = &stmt_wrapper->rowset[i];
+      column->lengths = ALLOC_N(size_t, size);
+      column->nulls = ALLOC_N(sacapi_bool, size);
+    }
+  }
+
+  for (i = 0; i < stmt_wrapper->num_cols; i++) {
+    column = &stmt_wrapper->rowset[i];
+
+    if (column->width != sqlanywhere_rowset_width(&stmt_wrapper->columns[i].info)) {
+      column->width = sqlanywhere_rowset_width(&stmt_wrapper->columns[i].info);
+      REALLOC_N(column->buffer, char, column->width * size);
+    }
+  }
+
+  if (!sqlany_set_rowset_size(stmt_wrapper->stmt, size) || !sqlany_set_column_bind_type(stmt_wrapper->stmt, 0)) {
+    rb_sqlanywhere_stmt_unbind_rowset(stmt_wrapper);
+    return 0;
+  }
+
+  stmt_wrapper->rowset_bound = 1;
+
+  for (i = 0; i < stmt_wrapper->num_cols; i++) {
+    column = &stmt_wrapper->rowset[i];
+
+    memset(&value, 0, sizeof(value));
+    value.buffer = column->buffer;
+    value.buffer_size = column->width;
+    value.length = column->lengths;
+    value.is_null = column->nulls;
+    value.type = stmt_wrapper->columns[i].info.type;
+
+    if (!sqlany_bind_column(stmt_wrapper->stmt, i, &value)) {
+      rb_sqlanywhere_stmt_unbind_rowset(stmt_wrapper);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/*
+ * libdbcapi multi-row fetching sometimes returns wrong row counts or garbage in bound arrays
+ * Checks that fetched rows look sane, so that broken rowsets are never returned
+ */
+static int rb_sqlanywhere_stmt_valid_rowset(struct sqlanywhere_fetch_args *fetch, sacapi_i32 fetched) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = fetch->stmt_wrapper;
+  sqlanywhere_rowset_column *column;
+  sacapi_i32 i;
+  sacapi_i32 j;
+
+  // Only the last rowset can be incomplete
+  if (fetch->rowset_short || fetched <= 0 || (sacapi_u32)fetched > stmt_wrapper->rowset_size) {
+    return 0;
+  }
+
+  for (i = 0; i < fetch->num_cols; i++) {
+    column = &stmt_wrapper->rowset[i];
+
+    for (j = 0; j < fetched; j++) {
+      if (column->nulls[j] != 0 && column->nulls[j] != 1) {
+        return 0;
+      }
+
+      if (column->nulls[j] && !fetch->columns[i].info.nullable) {
+        return 0;
+      }
+
+      if (!column->nulls[j] && column->lengths[j] > column->width) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/*
+ * Converts next row from the current rowset into values, fetching a new rowset when it is exhausted
+ * Returns 0 at the end of results and -1 if rowset was invalid, cursor is then positioned for single row fetching
+ */
+static int rb_sqlanywhere_stmt_fetch_rowset_values(struct sqlanywhere_fetch_args *fetch, VALUE *values) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = fetch->stmt_wrapper;
+  sqlanywhere_rowset_column *column;
+  a_sqlany_data_value col_value;
+  sacapi_i32 fetched;
+  sacapi_i32 i;
+
+  if (fetch->rowset_index >= fetch->rowset_fetched) {
+    rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+
+    if ((VALUE) rb_sqlanywhere_stats_without_gvl(
+      &stmt_wrapper->run,
+      &stmt_wrapper->run.fetch_ns,
+      nogvl_stmt_fetch_next,
+      stmt_wrapper,
+      nogvl_stmt_cancel,
+      stmt_wrapper
+    ) == Qfalse) {
+      return 0;
+    }
+
+    fetched = sqlany_fetched_rows(stmt_wrapper->stmt);
+
+    if (!rb_sqlanywhere_stmt_valid_rowset(fetch, fetched)) {
+      rb_sqlanywhere_stmt_unbind_rowset(stmt_wrapper);
+      fetch->rowset_active = 0;
+      fetch->reposition = (sacapi_i32)fetch->rows_fetched + 1;
+
+      return -1;
+    }
+
+    fetch->rowset_short = (sacapi_u32)fetched < stmt_wrapper->rowset_size;
+    fetch->rowset_fetched = (sacapi_u32)fetched;
+    fetch->rowset_index = 0;
+  }
+
+  for (i = 0; i < fetch->num_cols; i++) {
+    column = &stmt_wrapper->rowset[i];
+
+    if (column->nulls[fetch->rowset_index]) {
+      values[i] = Qnil;
+      continue;
+    }
+
+    col_value.buffer = column->buffer + column->width * fetch->rowset_index;
+    col_value.buffer_size = column->width;
+    col_value.length = &column->lengths[fetch->rowset_index];
+    stmt_wrapper->run.fetched_bytes += *col_value.length;
+    fetch->bytes_fetched += *col_value.length;
+    col_value.is_null = &column->nulls[fetch->rowset_index];
+    col_value.type = fetch->columns[i].info.type;
+
+    fetch->data.value = &col_value;
+    fetch->data.info = &fetch->columns[i].info;
+
+    values[i] = fetch->columns[i].convert(&fetch->data);
+  }
+
+  fetch->rowset_index++;
+  fetch->rows_fetched++;
+
+  return 1;
+}
+#endif
+
+/*
+ * Prepares fetching of the current result set, values are read from multirow rowsets when +rowsets+ is set
+ * and fetch_size allows it, otherwise from staging chunks
+ */
+static void rb_sqlanywhere_stmt_init_fetch(VALUE self, struct sqlanywhere_fetch_args *fetch, int rowsets) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = fetch->stmt_wrapper;
+
+  rb_sqlanywhere_stmt_unbind_rowset(stmt_wrapper);
+  rb_sqlanywhere_stmt_build_plan(stmt_wrapper);
+
+  fetch->num_cols = stmt_wrapper->num_cols;
+  fetch->columns = stmt_wrapper->columns;
+
+  fetch->data.encoding = stmt_wrapper->encoding;
+  fetch->data.cast = stmt_wrapper->connection_wrapper->cast;
+  fetch->data.connection_wrapper = stmt_wrapper->connection_wrapper;
+  fetch->data.decimal_buffer = stmt_wrapper->decimal_buffer;
+
+  fetch->rows_fetched = 0;
+  fetch->bytes_fetched = 0;
+  fetch->limited = 0;
+  fetch->rowset_active = 0;
+  fetch->rowset_short = 0;
+  fetch->rowset_fetched = 0;
+  fetch->rowset_index = 0;
+  fetch->reposition = 0;
+  fetch->chunk_rows = 0;
+  fetch->chunk = NULL;
+  fetch->prefetch = 0;
+  fetch->self = self;
+  fetch->lob_stream = stmt_wrapper->lob_stream;
+  fetch->started = sqlanywhere_stats_clock();
+  fetch->fetch_ns = stmt_wrapper->run.fetch_ns;
+
+  rb_sqlanywhere_stmt_prepare_shape(stmt_wrapper, fetch);
+
+#if _SACAPI_VERSION+0 >= 4
+  if (
+    stmt_wrapper->fetch_size > 1 &&
+    fetch->num_cols > 0 &&
+    !fetch->lob_stream &&
+    rowsets &&
+    sqlanywhere_api_version >= SQLANY_API_VERSION_4
+  ) {
+    fetch->rowset_active = rb_sqlanywhere_stmt_bind_rowset(stmt_wrapper);
+  }
+#endif
+}
+
+/*
+ * Fetches next chunk of rows without the GVL, or takes the prefetched one
+ * When prefetching is enabled the following chunk is fetched on a native thread while ruby converts this one
+ */
+static sqlanywhere_staging_chunk *rb_sqlanywhere_stmt_next_chunk(struct sqlanywhere_fetch_args *fetch) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = fetch->stmt_wrapper;
+  sqlanywhere_staging *staging = &stmt_wrapper->staging;
+  sqlanywhere_staging_chunk *chunk;
+
+  rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+
+  if (staging->prefetching) {
+    rb_sqlanywhere_stats_without_gvl(
+      &stmt_wrapper->run,
+      &stmt_wrapper->run.fetch_ns,
+      sqlanywhere_staging_wait,
+      staging,
+      sqlanywhere_staging_cancel,
+      staging
+    );
+  } else {
+    staging->connection = stmt_wrapper->connection_wrapper->connection;
+    staging->stmt = stmt_wrapper->stmt;
+    staging->num_cols = fetch->num_cols;
+    staging->reposition = fetch->reposition;
+    staging->chunk_rows = fetch->chunk_rows;
+
+    if (stmt_wrapper->closed) {
+      staging->chunks[staging->current].rows = 0;
+      staging->chunks[staging->current].done = 1;
+    } else {
+      rb_sqlanywhere_stats_without_gvl(
+        &stmt_wrapper->run,
+        &stmt_wrapper->run.fetch_ns,
+        sqlanywhere_staging_fill,
+        staging,
+        sqlanywhere_staging_cancel,
+        staging
+      );
+    }
+  }
+
+  fetch->reposition = 0;
+  chunk = &staging->chunks[staging->current];
+
+  if (chunk->error == SQLANYWHERE_STAGING_NO_MEMORY) {
+    rb_memerror();
+  } else if (chunk->error == SQLANYWHERE_STAGING_SQL_ERROR) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  stmt_wrapper->run.fetched_bytes += chunk->data_size;
+
+  if (fetch->prefetch && !chunk->done && !stmt_wrapper->closed) {
+    sqlanywhere_staging_prefetch(staging);
+  }
+
+  return chunk;
+}
+
+/*
+ * Fetches next row directly from the cursor, LOB columns become LobReaders reading the current row
+ * Returns 0 at the end of results
+ */
+static int rb_sqlanywhere_stmt_fetch_lob_values(struct sqlanywhere_fetch_args *fetch, VALUE *values) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = fetch->stmt_wrapper;
+  a_sqlany_data_value col_value;
+  a_sqlany_data_info data_info;
+  sacapi_i32 i;
+
+  stmt_wrapper->row_generation++;
+  rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+
+  if ((VALUE) rb_sqlanywhere_stats_without_gvl(
+    &stmt_wrapper->run,
+    &stmt_wrapper->run.fetch_ns,
+    nogvl_stmt_fetch_next,
+    stmt_wrapper,
+    nogvl_stmt_cancel,
+    stmt_wrapper
+  ) == Qfalse) {
+    return 0;
+  }
+
+  for (i = 0; i < fetch->num_cols; i++) {
+    if (sqlanywhere_is_lob(&fetch->columns[i].info)) {
+      if (!sqlany_get_data_info(stmt_wrapper->stmt, i, &data_info)) {
+        rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+      }
+
+      values[i] = data_info.is_null ? Qnil : rb_sqlanywhere_lob_new(
+        fetch->self,
+        stmt_wrapper,
+        (sacapi_u32)i,
+        data_info.data_size,
+        fetch->columns[i].info.type == A_BINARY
+      );
+      continue;
+    }
+
+    if (!sqlany_get_column(stmt_wrapper->stmt, i, &col_value)) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+
+    if (*col_value.is_null) {
+      values[i] = Qnil;
+      continue;
+    }
+
+    stmt_wrapper->run.fetched_bytes += *col_value.length;
+    fetch->bytes_fetched += *col_value.length;
+    fetch->data.value = &col_value;
+    fetch->data.info = &fetch->columns[i].info;
+
+    values[i] = fetch->columns[i].convert(&fetch->data);
+  }
+
+  fetch->rows_fetched++;
+
+  return 1;
+}
+
+/*
+ * Converts next row into values, returns 0 at the end of results
+ */
+static int rb_sqlanywhere_stmt_fetch_values(struct sqlanywhere_fetch_args *fetch, VALUE *values) {
+  sqlanywhere_staging_chunk *chunk = fetch->chunk;
+  a_sqlany_data_value col_value;
+  sacapi_i32 i;
+#if _SACAPI_VERSION+0 >= 4
+  int fetched;
+#endif
+
+  if (fetch->lob_stream) {
+    return rb_sqlanywhere_stmt_fetch_lob_values(fetch, values);
+  }
+
+#if _SACAPI_VERSION+0 >= 4
+  if (fetch->rowset_active && (fetched = rb_sqlanywhere_stmt_fetch_rowset_values(fetch, values)) >= 0) {
+    return fetched;
+  }
+#endif
+
+  if (chunk == NULL || chunk->index >= chunk->rows) {
+    if (chunk != NULL && chunk->done) {
+      return 0;
+    }
+
+    chunk = fetch->chunk = rb_sqlanywhere_stmt_next_chunk(fetch);
+
+    if (chunk->rows == 0) {
+      return 0;
+    }
+  }
+
+  for (i = 0; i < fetch->num_cols; i++) {
+    sqlanywhere_staging_value(chunk, fetch->num_cols, i, &col_value);
+
+    if (*col_value.is_null) {
+      values[i] = Qnil;
+      continue;
+    }
+
+    fetch->bytes_fetched += *col_value.length;
+    fetch->data.value = &col_value;
+    fetch->data.info = &fetch->columns[i].info;
+
+    values[i] = fetch->columns[i].convert(&fetch->data);
+  }
+
+  chunk->index++;
+  fetch->rows_fetched++;
+
+  return 1;
+}
+
+/*
+ * Returns next row in the shape requested with as:, or Qnil at the end of results
+ * Values live on the stack until the row is built so they stay visible to the GC
+ */
+static VALUE rb_sqlanywhere_stmt_fetch_row(struct sqlanywhere_fetch_args *fetch) {
+  VALUE *values = ALLOCA_N(VALUE, fetch->num_cols * 2);
+  VALUE row;
+  sacapi_i32 i;
+
+  if (!rb_sqlanywhere_stmt_fetch_values(fetch, values + fetch->num_cols)) {
+    return Qnil;
+  }
+
+  switch(fetch->shape) {
+  case ROW_AS_HASH:
+  case ROW_AS_SYMBOL_HASH:
+    for (i = 0; i < fetch->num_cols; i++) {
+      values[i * 2] = RARRAY_AREF(fetch->keys, i);
+      values[i * 2 + 1] = values[fetch->num_cols + i];
+    }
+
+#ifdef HAVE_RB_HASH_NEW_CAPA
+    row = rb_hash_new_capa(fetch->num_cols);
+#else
+    row = rb_hash_new();
+#endif
+    rb_hash_bulk_insert(fetch->num_cols * 2, values, row);
+    return row;
+  case ROW_AS_STRUCT:
+    return rb_class_new_instance(fetch->num_cols, values + fetch->num_cols, fetch->row_struct);
+  default:
+    return rb_ary_new_from_values(fetch->num_cols, values + fetch->num_cols);
+  }
+}
+
+static void rb_sqlanywhere_stmt_check_fetch_error(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  int error_code;
+
+  /* SQLAnywhere bug
+  * When executing a select query with wrong search type
+  * it doesn't return an error until we start to fetch results
+  * Example
+  *
+  * CREATE TABLE exp(id INT, name VARCHAR(255));
+  * SELECT * FROM exp where name = 123;
+  *
+  * This will only return an error when we start fetching results
+  */
+  error_code = sqlany_error(stmt_wrapper->connection_wrapper->connection, NULL, SACAPI_ERROR_SIZE);
+
+  if (error_code != 0 && error_code != ROW_NOT_FOUND_ERROR) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+}
+
+static int sqlanywhere_over_limits(const sqlanywhere_result_limits *limits, size_t rows, size_t bytes) {
+  return (limits->max_rows > 0 && rows > limits->max_rows) || (limits->max_bytes > 0 && bytes > limits->max_bytes);
+}
+
+/*
+ * Raises SQLAnywhere2::ResultLimitError when collecting stopped at a limit which doesn't truncate
+ */
+static void rb_sqlanywhere_stmt_check_limits(sqlanywhere_stmt_wrapper *stmt_wrapper, struct sqlanywhere_fetch_args *fetch) {
+  const sqlanywhere_result_limits *limits = &stmt_wrapper->limits;
+
+  if (!fetch->limited || limits->truncate) {
+    return;
+  }
+
+  if (limits->max_rows > 0 && (size_t)fetch->rows_fetched >= limits->max_rows) {
+    rb_raise(cSQLAnywhere2ResultLimitError, "Result has more rows than max_rows: %lu", (unsigned long)limits->max_rows);
+  }
+
+  rb_raise(cSQLAnywhere2ResultLimitError, "Result has more bytes than max_bytes: %lu", (unsigned long)limits->max_bytes);
+}
+
+/*
+ * Initial capacity of the row array from sqlany_num_rows, which is exact when positive and an estimate when negative
+ * Both are capped, estimates can be far off and an exact count is no reason to allocate a huge array up front
+ */
+static long rb_sqlanywhere_stmt_rows_capa(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sacapi_i32 num_rows = sqlany_num_rows(stmt_wrapper->stmt);
+  size_t capa = num_rows >= 0 ? (size_t)num_rows : (size_t)-(LONG_LONG)num_rows;
+
+  if (capa > ROWS_ESTIMATE_CAPA) {
+    capa = ROWS_ESTIMATE_CAPA;
+  }
+
+  if (stmt_wrapper->limits.max_rows > 0 && capa > stmt_wrapper->limits.max_rows) {
+    capa = stmt_wrapper->limits.max_rows;
+  }
+
+  return (long)capa;
+}
+
+/*
+ * Collects rows until the end of results or a result limit, the row past a limit is dropped
+ */
+static VALUE rb_sqlanywhere_stmt_collect_rows(VALUE ptr) {
+  struct sqlanywhere_fetch_args *fetch = (struct sqlanywhere_fetch_args *)ptr;
+  const sqlanywhere_result_limits *limits = &fetch->stmt_wrapper->limits;
+  VALUE rows = rb_ary_new_capa(rb_sqlanywhere_stmt_rows_capa(fetch->stmt_wrapper));
+  VALUE row;
+
+  while ((row = rb_sqlanywhere_stmt_fetch_row(fetch)) != Qnil) {
+    if (sqlanywhere_over_limits(limits, (size_t)fetch->rows_fetched, fetch->bytes_fetched)) {
+      fetch->rows_fetched--;
+      fetch->limited = 1;
+      break;
+    }
+
+    rb_ary_push(rows, row);
+  }
+
+  return rows;
+}
+
+/*
+ * Counts time since fetch->started which wasn't spent fetching as conversion
+ */
+static void rb_sqlanywhere_stmt_count_convert(struct sqlanywhere_fetch_args *fetch) {
+  sqlanywhere_stats *run = &fetch->stmt_wrapper->run;
+
+  run->convert_ns += sqlanywhere_stats_clock() - fetch->started - (run->fetch_ns - fetch->fetch_ns);
+}
+
+static VALUE rb_sqlanywhere_stmt_finish_fetch(VALUE ptr) {
+  struct sqlanywhere_fetch_args *fetch = (struct sqlanywhere_fetch_args *)ptr;
+
+  rb_sqlanywhere_stmt_count_convert(fetch);
+  fetch->stmt_wrapper->run.rows += fetch->rows_fetched;
+
+  // Prefetch thread is still running if conversion raised an error
+  if (fetch->stmt_wrapper->staging.prefetching) {
+    rb_thread_call_without_gvl(
+      sqlanywhere_staging_wait,
+      &fetch->stmt_wrapper->staging,
+      sqlanywhere_staging_cancel,
+      &fetch->stmt_wrapper->staging
+    );
+  }
+
+  rb_sqlanywhere_stmt_unbind_rowset(fetch->stmt_wrapper);
+
+  return Qnil;
+}
+
+/*
+ * Collects rows of the current result set, +truncated+ is set when rows past a limit were left unfetched
+ */
+static VALUE rb_sqlanywhere_stmt_rows(VALUE self, int *truncated) {
+  GET_STATEMENT(self);
+  struct sqlanywhere_fetch_args fetch;
+  VALUE rows;
+
+  *truncated = 0;
+  fetch.stmt_wrapper = stmt_wrapper;
+  rb_sqlanywhere_stmt_init_fetch(self, &fetch, 1);
+
+  if (fetch.num_cols == 0) {
+    return rb_ary_new();
+  }
+
+  // Nothing else runs on this connection while rows are collected, so the next chunk can be fetched in the background
+  fetch.prefetch = 1;
+
+  rows = rb_ensure(rb_sqlanywhere_stmt_collect_rows, (VALUE)&fetch, rb_sqlanywhere_stmt_finish_fetch, (VALUE)&fetch);
+  rb_sqlanywhere_stmt_check_fetch_error(stmt_wrapper);
+  rb_sqlanywhere_stmt_check_limits(stmt_wrapper, &fetch);
+  *truncated = fetch.limited;
+
+  return rows;
+}
+
+/*
+ * Counts size of the current staged row, returns 1 when appending it would exceed result limits
+ * Sizes are only summed when there is a max_bytes limit
+ */
+static int rb_sqlanywhere_stmt_staged_row_over_limits(struct sqlanywhere_fetch_args *fetch, sqlanywhere_staging_chunk *chunk) {
+  const sqlanywhere_result_limits *limits = &fetch->stmt_wrapper->limits;
+  a_sqlany_data_value col_value;
+  sacapi_i32 i;
+
+  if (limits->max_bytes > 0) {
+    for (i = 0; i < fetch->num_cols; i++) {
+      sqlanywhere_staging_value(chunk, fetch->num_cols, i, &col_value);
+
+      if (!*col_value.is_null) {
+        fetch->bytes_fetched += *col_value.length;
+      }
+    }
+  }
+
+  return sqlanywhere_over_limits(limits, (size_t)fetch->rows_fetched + 1, fetch->bytes_fetched);
+}
+
+/*
+ * Collects up to count rows, chunks are only filled with rows still missing from the page
+ */
+static VALUE rb_sqlanywhere_stmt_collect_page(VALUE ptr) {
+  struct sqlanywhere_page_args *args = (struct sqlanywhere_page_args *)ptr;
+  VALUE rows = rb_ary_new_capa(args->count > ROWS_ESTIMATE_CAPA ? ROWS_ESTIMATE_CAPA : args->count);
+  VALUE row;
+
+  while (RARRAY_LEN(rows) < args->count) {
+    args->fetch->chunk_rows = args->count - RARRAY_LEN(rows);
+
+    if (NIL_P(row = rb_sqlanywhere_stmt_fetch_row(args->fetch))) {
+      break;
+    }
+
+    rb_ary_push(rows, row);
+  }
+
+  return rows;
+}
+
+/*
+ * Returns result with up to +count+ rows of the open cursor starting at row +offset+, counted from 0
+ * Cursor is positioned with sqlany_fetch_absolute and chunks are never prefetched, so no rows past the page are read
+ */
+VALUE rb_sqlanywhere_stmt_fetch_page(VALUE self, long offset, long count) {
+  GET_STATEMENT(self);
+  struct sqlanywhere_fetch_args fetch;
+  struct sqlanywhere_page_args args;
+  VALUE rows;
+
+  fetch.stmt_wrapper = stmt_wrapper;
+  rb_sqlanywhere_stmt_init_fetch(self, &fetch, 0);
+
+  if (fetch.num_cols == 0) {
+    rows = rb_ary_new();
+  } else {
+    fetch.reposition = (sacapi_i32)(offset + 1);
+    args.fetch = &fetch;
+    args.count = count;
+
+    rows = rb_ensure(rb_sqlanywhere_stmt_collect_page, (VALUE)&args, rb_sqlanywhere_stmt_finish_fetch, (VALUE)&fetch);
+    rb_sqlanywhere_stmt_check_fetch_error(stmt_wrapper);
+  }
+
+  return rb_funcall(
+    cSQLAnywhere2Result,
+    intern_new,
+    3,
+    stmt_wrapper->column_list,
+    rows,
+    rb_sqlanywhere_stmt_shape_sym(stmt_wrapper)
+  );
+}
+
+/*
+ * Appends staged chunks to the column buffers, values are never converted to ruby objects
+ * Stops at the first row over result limits
+ */
+static VALUE rb_sqlanywhere_stmt_collect_columns(VALUE ptr) {
+  struct sqlanywhere_columnar_args *args = (struct sqlanywhere_columnar_args *)ptr;
+  struct sqlanywhere_fetch_args *fetch = args->fetch;
+  sqlanywhere_staging_chunk *chunk;
+  a_sqlany_data_value col_value;
+  sacapi_i32 i;
+
+  do {
+    chunk = fetch->chunk = rb_sqlanywhere_stmt_next_chunk(fetch);
+
+    for (; chunk->index < chunk->rows; chunk->index++) {
+      if (rb_sqlanywhere_stmt_staged_row_over_limits(fetch, chunk)) {
+        fetch->limited = 1;
+        return Qnil;
+      }
+
+      for (i = 0; i < fetch->num_cols; i++) {
+        sqlanywhere_staging_value(chunk, fetch->num_cols, i, &col_value);
+        sqlanywhere_columnar_append(&args->columns[i], fetch->rows_fetched, &col_value);
+      }
+
+      fetch->rows_fetched++;
+    }
+  } while (!chunk->done);
+
+  return Qnil;
+}
+
+static VALUE rb_sqlanywhere_stmt_columnar_result(VALUE self) {
+  GET_STATEMENT(self);
+  struct sqlanywhere_fetch_args fetch;
+  struct sqlanywhere_columnar_args args;
+  sacapi_i32 i;
+
+  fetch.stmt_wrapper = stmt_wrapper;
+  rb_sqlanywhere_stmt_init_fetch(self, &fetch, 0);
+
+  args.fetch = &fetch;
+  args.columns = ALLOCA_N(sqlanywhere_columnar_column, fetch.num_cols);
+
+  for (i = 0; i < fetch.num_cols; i++) {
+    sqlanywhere_columnar_init(&args.columns[i], &fetch.columns[i].info);
+  }
+
+  if (fetch.num_cols > 0) {
+    fetch.prefetch = 1;
+
+    rb_ensure(rb_sqlanywhere_stmt_collect_columns, (VALUE)&args, rb_sqlanywhere_stmt_finish_fetch, (VALUE)&fetch);
+    rb_sqlanywhere_stmt_check_fetch_error(stmt_wrapper);
+    rb_sqlanywhere_stmt_check_limits(stmt_wrapper, &fetch);
+  }
+
+  return rb_sqlanywhere_columnar_result_new(
+    stmt_wrapper->column_list,
+    args.columns,
+    fetch.rows_fetched,
+    stmt_wrapper->encoding,
+    fetch.limited
+  );
+}
+
+/*
+ * Writes buffered output to the IO, buffer is then reused like IO.copy_stream does
+ */
+static void rb_sqlanywhere_stmt_flush_copy(struct sqlanywhere_copy_out_args *args) {
+  if (RSTRING_LEN(args->buffer) > 0) {
+    rb_funcall(args->io, intern_write, 1, args->buffer);
+    rb_str_set_len(args->buffer, 0);
+  }
+}
+
+static VALUE rb_sqlanywhere_stmt_copy_rows(VALUE ptr) {
+  struct sqlanywhere_copy_out_args *args = (struct sqlanywhere_copy_out_args *)ptr;
+  struct sqlanywhere_fetch_args *fetch = args->fetch;
+  sqlanywhere_staging_chunk *chunk;
+  a_sqlany_data_value col_value;
+  sacapi_i32 i;
+
+  do {
+    chunk = fetch->chunk = rb_sqlanywhere_stmt_next_chunk(fetch);
+
+    for (; chunk->index < chunk->rows; chunk->index++) {
+      for (i = 0; i < fetch->num_cols; i++) {
+        if (i > 0) {
+          rb_str_cat(args->buffer, &args->format.col_sep, 1);
+        }
+
+        sqlanywhere_staging_value(chunk, fetch->num_cols, i, &col_value);
+        sqlanywhere_copy_append_value(args->buffer, &args->format, &col_value);
+      }
+
+      rb_str_cat(args->buffer, "\n", 1);
+      fetch->rows_fetched++;
+
+      if (RSTRING_LEN(args->buffer) >= SQLANYWHERE_COPY_FLUSH_BYTES) {
+        rb_sqlanywhere_stmt_flush_copy(args);
+      }
+    }
+  } while (!chunk->done);
+
+  rb_sqlanywhere_stmt_check_fetch_error(fetch->stmt_wrapper);
+  rb_sqlanywhere_stmt_flush_copy(args);
+
+  return Qnil;
+}
+
+static VALUE rb_sqlanywhere_stmt_finish_copy(VALUE ptr) {
+  struct sqlanywhere_copy_out_args *args = (struct sqlanywhere_copy_out_args *)ptr;
+
+  rb_sqlanywhere_stmt_finish_fetch((VALUE)args->fetch);
+
+  if (!args->fetch->stmt_wrapper->closed) {
+    sqlany_reset(args->fetch->stmt_wrapper->stmt);
+  }
+
+  rb_sqlanywhere_stmt_finish_run(args->fetch->stmt_wrapper);
+
+  return Qnil;
+}
+
+static void rb_sqlanywhere_stmt_copy_headers(struct sqlanywhere_copy_out_args *args) {
+  VALUE keys = args->fetch->stmt_wrapper->column_keys;
+  long i;
+
+  for (i = 0; i < RARRAY_LEN(keys); i++) {
+    if (i > 0) {
+      rb_str_cat(args->buffer, &args->format.col_sep, 1);
+    }
+
+    sqlanywhere_copy_append_text(args->buffer, &args->format, RSTRING_PTR(RARRAY_AREF(keys, i)), RSTRING_LEN(RARRAY_AREF(keys, i)));
+  }
+
+  rb_str_cat(args->buffer, "\n", 1);
+}
+
+/*
+ * Time spent in the block is not conversion, so conversion is timed per row
+ * Only every SQLANYWHERE_STATS_SAMPLE-th row is timed and counted for the rows in between
+ */
+static VALUE rb_sqlanywhere_stmt_yield_rows(VALUE ptr) {
+  struct sqlanywhere_fetch_args *fetch = (struct sqlanywhere_fetch_args *)ptr;
+  sqlanywhere_stats *run = &fetch->stmt_wrapper->run;
+  uint64_t convert_ns;
+  int sampled;
+  VALUE row;
+
+  for (;;) {
+    sampled = fetch->rows_fetched % SQLANYWHERE_STATS_SAMPLE == 0;
+
+    if (sampled) {
+      fetch->started = sqlanywhere_stats_clock();
+      fetch->fetch_ns = run->fetch_ns;
+    }
+
+    row = rb_sqlanywhere_stmt_fetch_row(fetch);
+
+    if (sampled) {
+      convert_ns = run->convert_ns;
+      rb_sqlanywhere_stmt_count_convert(fetch);
+      run->convert_ns = convert_ns + (run->convert_ns - convert_ns) * SQLANYWHERE_STATS_SAMPLE;
+    }
+
+    if (NIL_P(row)) {
+      break;
+    }
+
+    rb_yield(row);
+  }
+
+  rb_sqlanywhere_stmt_check_fetch_error(fetch->stmt_wrapper);
+
+  return Qnil;
+}
+
+static VALUE rb_sqlanywhere_stmt_finish_stream(VALUE ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = (sqlanywhere_stmt_wrapper *)ptr;
+
+  stmt_wrapper->lob_stream = 0;
+  // Invalidates LobReaders of the last row
+  stmt_wrapper->row_generation++;
+  rb_sqlanywhere_stmt_unbind_rowset(stmt_wrapper);
+
+  // Following result sets are still read by each_result_set
+  if (stmt_wrapper->result_sets) {
+    return Qnil;
+  }
+
+  stmt_wrapper->streaming = 0;
+
+  // Plan of the first result set is built again for the next execution
+  if (stmt_wrapper->result_index > 0) {
+    stmt_wrapper->result_index = 0;
+    stmt_wrapper->column_list = Qnil;
+  }
+
+  // Closes the cursor even if iteration was stopped early with break
+  if (!stmt_wrapper->closed) {
+    sqlany_reset(stmt_wrapper->stmt);
+  }
+
+  rb_sqlanywhere_stmt_finish_run(stmt_wrapper);
+
+  return Qnil;
+}
+
+/*
+ * Closes the cursor left open by a streamed execution or open_cursor
+ */
+void rb_sqlanywhere_stmt_close_stream(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
+  }
+}
+
+static VALUE rb_sqlanywhere_stmt_finish_each_row(VALUE ptr) {
+  struct sqlanywhere_fetch_args *fetch = (struct sqlanywhere_fetch_args *)ptr;
+
+  fetch->stmt_wrapper->run.rows += fetch->rows_fetched;
+
+  return rb_sqlanywhere_stmt_finish_stream((VALUE)fetch->stmt_wrapper);
+}
+
+/*
+ * Moves open cursor to the next result set, rows left in the current one are discarded
+ * Returns 0 when there are no more result sets
+ */
+static int rb_sqlanywhere_stmt_advance(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  stmt_wrapper->row_generation++;
+  rb_sqlanywhere_stmt_unbind_rowset(stmt_wrapper);
+  rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+
+  if ((VALUE) rb_sqlanywhere_stats_without_gvl(
+    &stmt_wrapper->run,
+    &stmt_wrapper->run.fetch_ns,
+    nogvl_stmt_next_result,
+    stmt_wrapper,
+    nogvl_stmt_cancel,
+    stmt_wrapper
+  ) == Qfalse) {
+    rb_sqlanywhere_stmt_check_fetch_error(stmt_wrapper);
+    return 0;
+  }
+
+  // Columns of the next result set are described again
+  stmt_wrapper->result_index++;
+  stmt_wrapper->column_list = Qnil;
+
+  return 1;
+}
+
+/* call-seq:
+ *    stmt.affected_rows
+ *
+ * Returns the number of rows changed, deleted, or inserted.
+ */
+static VALUE rb_sqlanywhere_stmt_affected_rows(VALUE self) {
+  sacapi_i32 affected;
+  GET_STATEMENT(self);
+
+  affected = sqlany_affected_rows(stmt_wrapper->stmt);
+
+  if (affected == -1) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  return ULL2NUM(affected);
+}
+
+/* call-seq: stmt.num_params # => Numeric
+ *
+ * Returns the number of parameters the prepared statement expects.
+ */
+static VALUE rb_sqlanywhere_stmt_num_params(VALUE self) {
+  sacapi_i32 params;
+  GET_STATEMENT(self);
+
+  params = sqlany_num_params(stmt_wrapper->stmt);
+
+  if (params == -1) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  return ULL2NUM(params);
+}
+
+/* call-seq: stmt.num_columns # => Numeric
+ *
+ * Returns the number of parameters the prepared statement expects.
+ */
+static VALUE rb_sqlanywhere_stmt_num_columns(VALUE self) {
+  sacapi_i32 cols;
+  GET_STATEMENT(self);
+
+  cols = sqlany_num_cols(stmt_wrapper->stmt);
+
+  if (cols == -1) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  return ULL2NUM(cols);
+}
+
+/* call-seq: stmt.columns # => array
+ *
+ * Returns a frozen list of columns that will be returned by this statement.
+ */
+static VALUE rb_sqlanywhere_stmt_columns(VALUE self) {
+  GET_STATEMENT(self);
+
+  rb_sqlanywhere_stmt_build_plan(stmt_wrapper);
+
+  return stmt_wrapper->column_list;
+}
+
+/* call-seq: stmt.fetch_size # => Numeric
+ *
+ * Returns the number of rows fetched from the server at once.
+ */
+static VALUE rb_sqlanywhere_stmt_fetch_size(VALUE self) {
+  GET_STATEMENT(self);
+
+  return UINT2NUM(stmt_wrapper->fetch_size);
+}
+
+/* call-seq: stmt.fetch_size = 100
+ *
+ * Sets the number of rows fetched from the server at once, defaults to connection fetch_size.
+ * Rows are fetched one by one if some column is too wide or multi-row fetch returns invalid data.
+ */
+static VALUE rb_sqlanywhere_stmt_set_fetch_size(VALUE self, VALUE fetch_size) {
+  GET_STATEMENT(self);
+
+  if (NUM2INT(fetch_size) <= 0) {
+    rb_raise(rb_eArgError, "fetch_size must be positive");
+  }
+
+  stmt_wrapper->fetch_size = NUM2UINT(fetch_size);
+
+  return fetch_size;
+}
+
+/* call-seq: stmt.close # => nil
+ *
+ * Explicitly closing this will free up server resources immediately rather
+ * than waiting for the garbage collector.
+ * This is also required to free up any locks in the database.
+ * Since statement execution creates a database lock with procedures which contain insert/update
+ * irregardless of commit statement
+ */
+static VALUE rb_sqlanywhere_stmt_close(VALUE self) {
+  GET_STATEMENT(self);
+
+  rb_thread_call_without_gvl(nogvl_stmt_close, stmt_wrapper, RUBY_UBF_IO, 0);
+
+  return Qnil;
+}
+
+static VALUE rb_sqlanywhere_stmt_create_result(VALUE self) {
+  GET_STATEMENT(self);
+  VALUE cols;
+  VALUE rows;
+  int truncated;
+
+  if (stmt_wrapper->columnar) {
+    return rb_sqlanywhere_stmt_columnar_result(self);
+  }
+
+  cols = rb_sqlanywhere_stmt_columns(self);
+  rows = rb_sqlanywhere_stmt_rows(self, &truncated);
+
+  return rb_funcall(
+    cSQLAnywhere2Result,
+    intern_new,
+    4,
+    cols,
+    rows,
+    rb_sqlanywhere_stmt_shape_sym(stmt_wrapper),
+    truncated ? Qtrue : Qfalse
+  );
+}
+
+/* call-seq: stmt.stats # => Hash
+ *
+ * Returns performance counters of all executions of the statement, including the one whose rows are still read.
+ * Times are in nanoseconds: prepare_ns, execute_ns, fetch_ns and convert_ns, the time spent building ruby values.
+ * Counts are executions, rows, fetched_bytes, bind_bytes and gvl_releases.
+ */
+static VALUE rb_sqlanywhere_stmt_stats(VALUE self) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  sqlanywhere_stats stats;
+
+  Data_Get_Struct(self, sqlanywhere_stmt_wrapper, stmt_wrapper);
+  stats = stmt_wrapper->stats;
+
+  sqlanywhere_stats_add(&stats, &stmt_wrapper->run);
+
+  return rb_sqlanywhere_stats_hash(&stats);
+}
+
+/* call-seq: stmt.connection # => SQLAnywhere2::Connection
+ *
+ * Returns connection the statement was prepared on.
+ */
+static VALUE rb_sqlanywhere_stmt_connection(VALUE self) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  Data_Get_Struct(self, sqlanywhere_stmt_wrapper, stmt_wrapper);
+
+  return stmt_wrapper->connection;
+}
+
+/* call-seq: stmt.closed? # => true or false
+ *
+ * Returns true if statement was closed explicitly or together with its connection.
+ */
+static VALUE rb_sqlanywhere_stmt_closed(VALUE self) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  Data_Get_Struct(self, sqlanywhere_stmt_wrapper, stmt_wrapper);
+
+  if (stmt_wrapper->closed || stmt_wrapper->connection_wrapper->closed) {
+    return Qtrue;
+  }
+
+  return sqlanywhere_connection_owned(stmt_wrapper->connection_wrapper) ? Qfalse : Qtrue;
+}
+
+/* call-seq: stmt.streaming? # => true or false
+ *
+ * Returns true while rows of a streamed execution have not been read to the end.
+ */
+static VALUE rb_sqlanywhere_stmt_streaming(VALUE self) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper;
+  Data_Get_Struct(self, sqlanywhere_stmt_wrapper, stmt_wrapper);
+
+  return stmt_wrapper->streaming ? Qtrue : Qfalse;
+}
+
+/* call-seq: stmt.last_result # => SQLAnywhere::Result
+ *
+ * Returns results from previously executed query
+ * Returns nil if last query didn't return a result set
+ * When used with multiple result query returns the first result set, others are read with each_result_set
+ */
+VALUE rb_sqlanywhere_stmt_last_result(VALUE self) {
+  GET_STATEMENT(self);
+  VALUE last_result;
+
+  if (stmt_wrapper->fetched) {
+    last_result = rb_iv_get(self, "@last_result");
+    return last_result;
+  }
+
+  last_result = rb_sqlanywhere_stmt_create_result(self);
+
+  rb_iv_set(self, "@last_result", last_result);
+
+  stmt_wrapper->fetched = 1;
+
+  return last_result;
+}
+
+/*
+ * Describes bind parameters once, following executions reuse descriptions and bind buffers
+ */
+static void rb_sqlanywhere_stmt_describe_binds(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sacapi_i32 num_params;
+  sqlanywhere_bind_param *binds;
+  sacapi_i32 i;
+
+  if (stmt_wrapper->num_params >= 0) {
+    return;
+  }
+
+  num_params = sqlany_num_params(stmt_wrapper->stmt);
+
+  if (num_params < 0) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  binds = num_params > 0 ? ZALLOC_N(sqlanywhere_bind_param, num_params) : NULL;
+
+  for (i = 0; i < num_params; i++) {
+    if (!sqlany_describe_bind_param(stmt_wrapper->stmt, i, &binds[i].param)) {
+      xfree(binds);
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+
+    binds[i].type = binds[i].param.value.type;
+    binds[i].param.value.is_null = &binds[i].is_null;
+    binds[i].param.value.length = &binds[i].length;
+  }
+
+  stmt_wrapper->binds = binds;
+  stmt_wrapper->num_params = num_params;
+}
+
+/*
+ * Reads IO bound to param index in chunks of lob_chunk_size and sends them without the GVL
+ * Only one chunk is held in memory at a time
+ */
+static void rb_sqlanywhere_stmt_send_stream(sqlanywhere_stmt_wrapper *stmt_wrapper, sacapi_u32 index, VALUE io) {
+  struct nogvl_send_param_data_args args;
+  size_t chunk_size = stmt_wrapper->connection_wrapper->lob_chunk_size;
+  VALUE buffer = rb_str_buf_new((long)chunk_size);
+  VALUE chunk;
+  VALUE sent;
+  int empty = 1;
+
+  args.execute.connection = stmt_wrapper->connection_wrapper->connection;
+  args.execute.stmt = stmt_wrapper->stmt;
+  args.index = index;
+
+  while (!NIL_P(chunk = rb_funcall(io, intern_read, 2, SIZET2NUM(chunk_size), buffer)) || empty) {
+    if (NIL_P(chunk)) {
+      // Empty IO is sent as an empty value
+      chunk = rb_str_new(NULL, 0);
+    }
+
+    StringValue(chunk);
+    empty = 0;
+
+    args.buffer = RSTRING_PTR(chunk);
+    args.size = (size_t)RSTRING_LEN(chunk);
+
+    rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+
+    rb_str_locktmp(chunk);
+    sent = (VALUE) rb_sqlanywhere_stats_without_gvl(
+      &stmt_wrapper->run,
+      &stmt_wrapper->run.execute_ns,
+      nogvl_stmt_send_param_data,
+      &args,
+      nogvl_stmt_execute_ubf,
+      &args.execute
+    );
+    stmt_wrapper->run.bind_bytes += args.size;
+    rb_str_unlocktmp(chunk);
+
+    if (sent == Qfalse) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+
+    if (args.size == 0) {
+      break;
+    }
+  }
+}
+
+/*
+ * Returns result of executed statement, or opens the cursor when rows are streamed
+ */
+VALUE rb_sqlanywhere_stmt_executed(VALUE self, VALUE stream) {
+  GET_STATEMENT(self);
+  VALUE result;
+
+  if (RTEST(stream)) {
+    rb_sqlanywhere_stmt_open_stream(self);
+
+    return self;
+  }
+
+  stmt_wrapper->fetched = 0;
+
+  result = rb_sqlanywhere_stmt_last_result(self);
+
+  // Reset statement to its prepared state condition
+  if (!sqlany_reset(stmt_wrapper->stmt)) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  rb_sqlanywhere_stmt_finish_run(stmt_wrapper);
+
+  return result;
+}
+
+/*
+ * Binds parameters and sends streamed ones, statement is then ready to be executed
+ */
+static void rb_sqlanywhere_stmt_bind(sqlanywhere_stmt_wrapper *stmt_wrapper, long argc, const VALUE *argv) {
+  sacapi_i32 i;
+  struct rb_data_to_sqlanywhere_data_args rb_data;
+
+  rb_sqlanywhere_stmt_describe_binds(stmt_wrapper);
+
+  if (argc != (long)stmt_wrapper->num_params) {
+    rb_raise(
+      cSQLAnywhere2Error,
+      "Bind parameter count (%ld) doesn't match number of arguments (%ld)",
+      (long)stmt_wrapper->num_params,
+      argc
+      );
+  }
+
+  rb_data.encoding = stmt_wrapper->encoding;
+  rb_data.connection_wrapper = stmt_wrapper->connection_wrapper;
+
+  for (i = 0; i < stmt_wrapper->num_params; i++) {
+    rb_data.arg = argv[i];
+    rb_data.bind = &stmt_wrapper->binds[i];
+
+    rb_data_to_sqlanywhere_data(&rb_data);
+    stmt_wrapper->run.bind_bytes += stmt_wrapper->binds[i].length;
+
+    if (!sqlany_bind_param(stmt_wrapper->stmt, i, &stmt_wrapper->binds[i].param)) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+  }
+
+  for (i = 0; i < stmt_wrapper->num_params; i++) {
+    if (stmt_wrapper->binds[i].streamed) {
+      rb_sqlanywhere_stmt_send_stream(stmt_wrapper, (sacapi_u32)i, argv[i]);
+    }
+  }
+}
+
+/*
+ * Executes bound statement without the GVL, every call is counted as one execution
+ */
+static void rb_sqlanywhere_stmt_execute_args(sqlanywhere_stmt_wrapper *stmt_wrapper, struct nogvl_stmt_execute_args *args) {
+  rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+  stmt_wrapper->run.executions++;
+
+  if ((VALUE)rb_sqlanywhere_stats_without_gvl(
+    &stmt_wrapper->run,
+    &stmt_wrapper->run.execute_ns,
+    nogvl_stmt_execute,
+    args,
+    nogvl_stmt_execute_ubf,
+    args
+  ) == Qfalse) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+}
+
+static void rb_sqlanywhere_stmt_run(sqlanywhere_stmt_wrapper *stmt_wrapper, long argc, const VALUE *argv) {
+  struct nogvl_stmt_execute_args args;
+
+  rb_sqlanywhere_stmt_bind(stmt_wrapper, argc, argv);
+
+  args.stmt = stmt_wrapper->stmt;
+  args.connection = stmt_wrapper->connection_wrapper->connection;
+
+  rb_sqlanywhere_stmt_execute_args(stmt_wrapper, &args);
+}
+
+/*
+ * Marks statement as having an open cursor which is consumed by each_row
+ * No result is stored for such execution
+ */
+void rb_sqlanywhere_stmt_open_stream(VALUE self) {
+  GET_STATEMENT(self);
+
+  stmt_wrapper->streaming = 1;
+  stmt_wrapper->fetched = 1;
+
+  rb_iv_set(self, "@last_result", Qnil);
+}
+
+/* call-seq: stmt.execute(*binds, stream: false, as: :array, format: :rows, max_rows: nil, max_bytes: nil, on_limit: :raise)
+ *
+ * Executes the current prepared statement, returns +result+.
+ * When +stream+ is true rows are not fetched and +self+ is returned,
+ * rows can then be read one at a time with each_row.
+ * When +format+ is :columnar SQLAnywhere2::ColumnarResult with values packed per column is returned.
+ * +max_rows+, +max_bytes+ and +on_limit+ override result limits of the connection for this execution.
+ */
+static VALUE rb_sqlanywhere_stmt_execute(int argc, VALUE *argv, VALUE self) {
+  GET_STATEMENT(self);
+  VALUE binds;
+  VALUE opts;
+  VALUE kw_values[6] = {Qfalse, Qnil, Qnil, Qundef, Qundef, Qundef};
+  VALUE stream;
+  VALUE as;
+  VALUE format;
+  ID kw_ids[6];
+
+  rb_scan_args(argc, argv, "*:", &binds, &opts);
+
+  if (!NIL_P(opts)) {
+    kw_ids[0] = SYM2ID(sym_stream);
+    kw_ids[1] = SYM2ID(sym_as);
+    kw_ids[2] = SYM2ID(sym_format);
+    kw_ids[3] = SYM2ID(sym_max_rows);
+    kw_ids[4] = SYM2ID(sym_max_bytes);
+    kw_ids[5] = SYM2ID(sym_on_limit);
+    rb_get_kwargs(opts, kw_ids, 0, 6, kw_values);
+  }
+
+  stream = kw_values[0] == Qundef ? Qfalse : kw_values[0];
+  as = kw_values[1] == Qundef ? Qnil : kw_values[1];
+  format = kw_values[2] == Qundef ? Qnil : kw_values[2];
+
+  if (!NIL_P(format) && format != sym_rows && format != sym_columnar) {
+    rb_raise(cSQLAnywhere2Error, "format: option must be one of :rows, :columnar");
+  }
+
+  if (format == sym_columnar && (RTEST(stream) || !NIL_P(as))) {
+    rb_raise(cSQLAnywhere2Error, "format: :columnar can not be combined with stream: or as: options");
+  }
+
+  rb_sqlanywhere_stmt_set_shape(self, as);
+  stmt_wrapper->columnar = format == sym_columnar;
+  rb_sqlanywhere_set_result_limits(&stmt_wrapper->limits, kw_values[3], kw_values[4], kw_values[5]);
+
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
+  }
+
+  rb_sqlanywhere_stmt_run(stmt_wrapper, RARRAY_LEN(binds), RARRAY_CONST_PTR(binds));
+
+  return rb_sqlanywhere_stmt_executed(self, stream);
+}
+
+/* call-seq: stmt.open_cursor(*binds, as: :array) # => SQLAnywhere2::Cursor
+ *
+ * Executes the current prepared statement and keeps its cursor open, pages of rows are then read with
+ * Cursor#fetch without executing the query again. Executing the statement again closes the cursor.
+ */
+static VALUE rb_sqlanywhere_stmt_open_cursor(int argc, VALUE *argv, VALUE self) {
+  GET_STATEMENT(self);
+  VALUE binds;
+  VALUE opts;
+  VALUE as = Qnil;
+  ID kw_ids[1];
+
+  rb_scan_args(argc, argv, "*:", &binds, &opts);
+
+  if (!NIL_P(opts)) {
+    kw_ids[0] = SYM2ID(sym_as);
+    rb_get_kwargs(opts, kw_ids, 0, 1, &as);
+  }
+
+  rb_sqlanywhere_stmt_set_shape(self, as);
+
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
+  }
+
+  rb_sqlanywhere_stmt_run(stmt_wrapper, RARRAY_LEN(binds), RARRAY_CONST_PTR(binds));
+  rb_sqlanywhere_stmt_open_stream(self);
+
+  return rb_sqlanywhere_cursor_new(self, stmt_wrapper);
+}
+
+/* call-seq: stmt.execute_async(*binds, stream: false, as: :array) # => SQLAnywhere2::AsyncResult
+ *
+ * Binds parameters and executes the statement on a native worker thread.
+ * Statement can not be used until execution finishes, AsyncResult#value returns the same as execute.
+ */
+static VALUE rb_sqlanywhere_stmt_execute_async(VALUE self, VALUE binds, VALUE stream, VALUE as) {
+  GET_STATEMENT(self);
+
+  Check_Type(binds, T_ARRAY);
+  rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+  rb_sqlanywhere_stmt_set_shape(self, as);
+
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
+  }
+
+  rb_sqlanywhere_stmt_bind(stmt_wrapper, RARRAY_LEN(binds), RARRAY_CONST_PTR(binds));
+
+  return rb_sqlanywhere_async_new(stmt_wrapper->connection, self, Qnil, stream, as);
+}
+
+static VALUE rb_sqlanywhere_stmt_run_update(VALUE ptr) {
+  struct sqlanywhere_update_args *update = (struct sqlanywhere_update_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = update->stmt_wrapper;
+  struct nogvl_stmt_update_args args;
+  VALUE result;
+
+  rb_sqlanywhere_stmt_bind(stmt_wrapper, update->argc, update->argv);
+
+  args.execute.stmt = stmt_wrapper->stmt;
+  args.execute.connection = stmt_wrapper->connection_wrapper->connection;
+  args.affected = 0;
+  args.reset = 0;
+
+  rb_sqlanywhere_connection_check_deadline(stmt_wrapper->connection_wrapper);
+  stmt_wrapper->run.executions++;
+  update->reset = 1;
+
+  result = (VALUE)rb_sqlanywhere_stats_without_gvl(
+    &stmt_wrapper->run,
+    &stmt_wrapper->run.execute_ns,
+    nogvl_stmt_execute_update,
+    &args,
+    nogvl_stmt_execute_ubf,
+    &args.execute
+  );
+  update->reset = !args.reset;
+
+  if (result == Qfalse) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  return LONG2NUM(args.affected);
+}
+
+/*
+ * Resets statement whose execution failed, finishes the run and disarms the deadline armed by execute_update
+ */
+static VALUE rb_sqlanywhere_stmt_finish_update(VALUE ptr) {
+  struct sqlanywhere_update_args *update = (struct sqlanywhere_update_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = update->stmt_wrapper;
+
+  if (update->reset && !stmt_wrapper->closed) {
+    sqlany_reset(stmt_wrapper->stmt);
+  }
+
+  rb_sqlanywhere_stmt_finish_run(stmt_wrapper);
+
+  if (update->armed) {
+    update->fired = RTEST(rb_sqlanywhere_connection_disarm_timeout(stmt_wrapper->connection));
+  }
+
+  return Qnil;
+}
+
+/* call-seq: stmt.execute_update(*binds, timeout: connection.timeout) # => integer
+ *
+ * Executes the current prepared statement and returns the number of affected rows without building a result.
+ * Meant for INSERT, UPDATE and DELETE statements, rows of other statements are discarded.
+ * Keywords are parsed without rb_scan_args and the timeout is armed natively,
+ * so no Ruby objects are allocated besides the returned Integer.
+ */
+static VALUE rb_sqlanywhere_stmt_execute_update(int argc, VALUE *argv, VALUE self) {
+  GET_STATEMENT(self);
+  struct sqlanywhere_update_args update;
+  VALUE timeout = rb_ivar_get(stmt_wrapper->connection, intern_timeout);
+  VALUE timeout_kw = Qundef;
+  VALUE affected;
+  ID kw_ids[1];
+
+  if (rb_keyword_given_p()) {
+    kw_ids[0] = SYM2ID(sym_timeout);
+    rb_get_kwargs(argv[--argc], kw_ids, 0, 1, &timeout_kw);
+    timeout = timeout_kw == Qundef ? timeout : timeout_kw;
+  }
+
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
+  }
+
+  // No result is kept for such execution
+  rb_ivar_set(self, intern_last_result, Qnil);
+  stmt_wrapper->fetched = 1;
+
+  update.stmt_wrapper = stmt_wrapper;
+  update.argc = argc;
+  update.argv = argv;
+  update.reset = 0;
+  update.fired = 0;
+
+  // Same as Connection#with_timeout, nested calls share the deadline of the outermost one
+  update.armed = !NIL_P(timeout) && RTEST(rb_sqlanywhere_connection_arm_timeout(stmt_wrapper->connection, timeout));
+
+  affected = rb_ensure(
+    rb_sqlanywhere_stmt_run_update,
+    (VALUE)&update,
+    rb_sqlanywhere_stmt_finish_update,
+    (VALUE)&update
+  );
+
+  // Deadline passed right after the execution, same as Connection#with_timeout the result is discarded
+  if (update.fired) {
+    rb_raise(cSQLAnywhere2TimeoutError, "Timeout expired");
+  }
+
+  return affected;
+}
+
+static VALUE rb_sqlanywhere_stmt_check_batch_row(sqlanywhere_stmt_wrapper *stmt_wrapper, VALUE row) {
+  Check_Type(row, T_ARRAY);
+
+  if (RARRAY_LEN(row) != (long)stmt_wrapper->num_params) {
+    rb_raise(
+      cSQLAnywhere2Error,
+      "Bind parameter count (%ld) doesn't match number of arguments (%ld)",
+      (long)stmt_wrapper->num_params,
+      RARRAY_LEN(row)
+      );
+  }
+
+  return row;
+}
+
+/*
+ * Returns affected rows of the last execution, raises if the server didn't report them
+ */
+static sacapi_i32 rb_sqlanywhere_stmt_batch_affected(sqlanywhere_stmt_wrapper *stmt_wrapper) {
+  sacapi_i32 affected = sqlany_affected_rows(stmt_wrapper->stmt);
+
+  if (affected == -1) {
+    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  }
+
+  return affected;
+}
+
+/*
+ * Executes rows one by one, used when client library doesn't support batches
+ */
+static VALUE rb_sqlanywhere_stmt_execute_rows(VALUE ptr) {
+  struct sqlanywhere_batch_args *batch = (struct sqlanywhere_batch_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = batch->stmt_wrapper;
+  VALUE result = rb_ary_new();
+  long total = RARRAY_LEN(batch->rows);
+  long start;
+  long i;
+  LONG_LONG affected;
+  VALUE row;
+
+  for (start = 0; start < total; start += batch->batch_size) {
+    affected = 0;
+
+    for (i = start; i < total && i < start + batch->batch_size; i++) {
+      row = rb_sqlanywhere_stmt_check_batch_row(stmt_wrapper, RARRAY_AREF(batch->rows, i));
+
+      rb_sqlanywhere_stmt_run(stmt_wrapper, RARRAY_LEN(row), RARRAY_CONST_PTR(row));
+      affected += rb_sqlanywhere_stmt_batch_affected(stmt_wrapper);
+
+      if (!sqlany_reset(stmt_wrapper->stmt)) {
+        rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+      }
+    }
+
+    rb_ary_push(result, LL2NUM(affected));
+  }
+
+  return result;
+}
+
+/*
+ * Leaves statement ready for the next execution when a row fails
+ */
+static VALUE rb_sqlanywhere_stmt_finish_rows(VALUE ptr) {
+  struct sqlanywhere_batch_args *batch = (struct sqlanywhere_batch_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = batch->stmt_wrapper;
+
+  if (!stmt_wrapper->closed) {
+    sqlany_reset(stmt_wrapper->stmt);
+  }
+
+  rb_sqlanywhere_stmt_finish_run(stmt_wrapper);
+
+  return Qnil;
+}
+
+#if _SACAPI_VERSION+0 >= 4
+/*
+ * Encodes values other than strings, numbers and booleans the same way as single row binds
+ * Used for text parameters of a batch, IO values can not be sent in batches
+ */
+static sqlanywhere_bind_param *sqlanywhere_batch_encode(struct sqlanywhere_batch_args *batch, VALUE arg) {
+  struct rb_data_to_sqlanywhere_data_args data;
+
+  data.encoding = batch->stmt_wrapper->encoding;
+  data.connection_wrapper = batch->stmt_wrapper->connection_wrapper;
+  data.arg = arg;
+  data.bind = &batch->scratch;
+
+  rb_data_to_sqlanywhere_data(&data);
+
+  if (batch->scratch.streamed) {
+    rb_raise(rb_eTypeError, "Cannot convert type. IO values can not be sent in batches");
+  }
+
+  return &batch->scratch;
+}
+
+/*
+ * Returns width of the element a value needs when its parameter is sent as a string
+ */
+static size_t sqlanywhere_batch_value_width(struct sqlanywhere_batch_args *batch, VALUE arg) {
+  switch(TYPE(arg)) {
+  case T_STRING:
+    return RSTRING_LEN(arg);
+  case T_FIXNUM:
+  case T_TRUE:
+  case T_FALSE:
+    return 21;
+  case T_BIGNUM:
+    return rb_absint_size(arg, NULL) * 3 + 2;
+  case T_FLOAT:
+    return 32;
+  case T_NIL:
+    return 0;
+  default:
+    return sqlanywhere_batch_encode(batch, arg)->length;
+  }
+}
+
+/*
+ * Widens parameters for the row, same as copy_in batches packed arrays stay within SQLANYWHERE_COPY_BATCH_BYTES
+ * Returns 0 without changing widths if the row doesn't fit, first row of a batch always fits
+ * so oversized rows are executed on their own
+ */
+static int sqlanywhere_batch_fit_row(struct sqlanywhere_batch_args *batch, VALUE row, long rows) {
+  struct sqlanywhere_batch_param *param;
+  size_t row_width = 0;
+  sacapi_i32 i;
+
+  for (i = 0; i < batch->stmt_wrapper->num_params; i++) {
+    param = &batch->params[i];
+    param->row_width = sqlanywhere_batch_value_width(batch, RARRAY_AREF(row, i));
+    row_width += param->row_width > param->width ? param->row_width : param->width;
+  }
+
+  if (rows > 0 && row_width > SQLANYWHERE_COPY_BATCH_BYTES / (size_t)(rows + 1)) {
+    return 0;
+  }
+
+  for (i = 0; i < batch->stmt_wrapper->num_params; i++) {
+    param = &batch->params[i];
+
+    if (param->row_width > param->width) {
+      param->width = param->row_width;
+    }
+  }
+
+  return 1;
+}
+
+/*
+ * Chooses one type for all values of a parameter in a batch and the width of a single element
+ * Integers, booleans and floats are sent as numbers, parameters which contain strings, big integers
+ * or other values are sent as strings as wide as the widest value fitted into the batch
+ */
+static void sqlanywhere_batch_param_type(struct sqlanywhere_batch_args *batch, long start, long count, long index, a_sqlany_data_type *type, size_t *width) {
+  int has_string = 0, has_binary = 0, has_double = 0, has_integer = 0;
+  long i;
+  VALUE arg;
+
+  for (i = start; i < start + count; i++) {
+    arg = RARRAY_AREF(RARRAY_AREF(batch->rows, i), index);
+
+    switch(TYPE(arg)) {
+    case T_STRING:
+      has_string = 1;
+      has_binary |= rb_enc_get(arg) == rb_ascii8bit_encoding();
+      break;
+    case T_FIXNUM:
+    case T_TRUE:
+    case T_FALSE:
+      has_integer = 1;
+      break;
+    case T_FLOAT:
+      has_double = 1;
+      break;
+    case T_NIL:
+      break;
+    default:
+      has_string = 1;
+      break;
+    }
+  }
+
+  if (has_string) {
+    *type = has_binary ? A_BINARY : A_STRING;
+    *width = batch->params[index].width > 0 ? batch->params[index].width : 1;
+  } else if (has_double) {
+    *type = A_DOUBLE;
+    *width = sizeof(double);
+  } else if (has_integer) {
+    *type = A_VAL64;
+    *width = sizeof(LONG_LONG);
+  } else {
+    *type = A_VAL32;
+    *width = sizeof(int);
+  }
+}
+
+/*
+ * Writes text of a batch value into its element, returns its length
+ */
+static size_t sqlanywhere_batch_put_string(struct sqlanywhere_batch_args *batch, char *element, VALUE arg) {
+  sqlanywhere_bind_param *scratch;
+  size_t length;
+
+  if (arg == Qtrue || arg == Qfalse) {
+    element[0] = arg == Qtrue ? '1' : '0';
+    return 1;
+  }
+
+  if (RB_TYPE_P(arg, T_STRING) || RB_INTEGER_TYPE_P(arg) || RB_FLOAT_TYPE_P(arg)) {
+    arg = rb_obj_as_string(arg);
+    length = RSTRING_LEN(arg);
+    memcpy(element, RSTRING_PTR(arg), length);
+    RB_GC_GUARD(arg);
+
+    return length;
+  }
+
+  scratch = sqlanywhere_batch_encode(batch, arg);
+  memcpy(element, scratch->param.value.buffer, scratch->length);
+
+  return scratch->length;
+}
+
+/*
+ * Packs values of a single parameter into contiguous arrays and binds them
+ */
+static void sqlanywhere_batch_bind_param(struct sqlanywhere_batch_args *batch, long start, long count, sacapi_u32 index) {
+  struct sqlanywhere_batch_param *param = &batch->params[index];
+  a_sqlany_data_type type;
+  size_t width;
+  char *element;
+  long i;
+  VALUE arg;
+
+  sqlanywhere_batch_param_type(batch, start, count, index, &type, &width);
+
+  if (param->capacity < width * count) {
+    param->capacity = width * count;
+    REALLOC_N(param->buffer, char, param->capacity);
+  }
+
+  for (i = 0; i < count; i++) {
+    arg = RARRAY_AREF(RARRAY_AREF(batch->rows, start + i), index);
+    element = param->buffer + width * i;
+    param->nulls[i] = NIL_P(arg);
+    param->lengths[i] = 0;
+
+    if (NIL_P(arg)) {
+      continue;
+    }
+
+    switch(type) {
+    case A_STRING:
+    case A_BINARY:
+      param->lengths[i] = sqlanywhere_batch_put_string(batch, element, arg);
+      break;
+    case A_DOUBLE:
+      *(double *)element = arg == Qtrue || arg == Qfalse ? (double)(arg == Qtrue) : NUM2DBL(arg);
+      param->lengths[i] = sizeof(double);
+      break;
+    default:
+      *(LONG_LONG *)element = arg == Qtrue || arg == Qfalse ? (LONG_LONG)(arg == Qtrue) : NUM2LL(arg);
+      param->lengths[i] = sizeof(LONG_LONG);
+      break;
+    }
+
+    batch->stmt_wrapper->run.bind_bytes += param->lengths[i];
+  }
+
+  param->param.value.buffer = param->buffer;
+  param->param.value.buffer_size = width;
+  param->param.value.length = param->lengths;
+  param->param.value.is_null = param->nulls;
+  param->param.value.type = type;
+  param->param.value.is_address = 0;
+
+  if (!sqlany_bind_param(batch->stmt_wrapper->stmt, index, &param->param)) {
+    rb_raise_sqlanywhere_stmt_error(batch->stmt_wrapper);
+  }
+}
+
+static VALUE rb_sqlanywhere_stmt_execute_batches(VALUE ptr) {
+  struct sqlanywhere_batch_args *batch = (struct sqlanywhere_batch_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = batch->stmt_wrapper;
+  struct nogvl_stmt_execute_args args;
+  VALUE result = rb_ary_new();
+  long total = RARRAY_LEN(batch->rows);
+  long start;
+  long count;
+  VALUE row;
+  sacapi_i32 i;
+
+  args.stmt = stmt_wrapper->stmt;
+  args.connection = stmt_wrapper->connection_wrapper->connection;
+
+  for (i = 0; i < stmt_wrapper->num_params; i++) {
+    batch->params[i].param = stmt_wrapper->binds[i].param;
+    batch->params[i].lengths = ALLOC_N(size_t, batch->batch_size);
+    batch->params[i].nulls = ALLOC_N(sacapi_bool, batch->batch_size);
+  }
+
+  for (start = 0; start < total; start += count) {
+    for (i = 0; i < stmt_wrapper->num_params; i++) {
+      batch->params[i].width = 0;
+    }
+
+    // Batch is cut early when its parameter arrays would grow too large, the rest goes to the next execution
+    for (count = 0; count < batch->batch_size && start + count < total; count++) {
+      row = RARRAY_AREF(batch->rows, start + count);
+      rb_sqlanywhere_stmt_check_batch_row(stmt_wrapper, row);
+
+      if (!sqlanywhere_batch_fit_row(batch, row, count)) {
+        break;
+      }
+    }
+
+    // Column-wise binding, each parameter is an array of count values
+    if (!sqlany_set_batch_size(stmt_wrapper->stmt, (sacapi_u32)count) ||
+      !sqlany_set_param_bind_type(stmt_wrapper->stmt, 0)) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+
+    for (i = 0; i < stmt_wrapper->num_params; i++) {
+      sqlanywhere_batch_bind_param(batch, start, count, i);
+    }
+
+    rb_sqlanywhere_stmt_execute_args(stmt_wrapper, &args);
+
+    rb_ary_push(result, LONG2NUM(rb_sqlanywhere_stmt_batch_affected(stmt_wrapper)));
+
+    if (!sqlany_reset(stmt_wrapper->stmt)) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+  }
+
+  return result;
+}
+
+static VALUE rb_sqlanywhere_stmt_finish_batches(VALUE ptr) {
+  struct sqlanywhere_batch_args *batch = (struct sqlanywhere_batch_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = batch->stmt_wrapper;
+  sacapi_i32 i;
+
+  // Following executions bind a single row
+  if (!stmt_wrapper->closed) {
+    sqlany_set_batch_size(stmt_wrapper->stmt, 1);
+  }
+
+  for (i = 0; i < stmt_wrapper->num_params; i++) {
+    xfree(batch->params[i].buffer);
+    xfree(batch->params[i].lengths);
+    xfree(batch->params[i].nulls);
+  }
+
+  xfree(batch->params);
+  xfree(batch->scratch.buffer);
+
+  rb_sqlanywhere_stmt_finish_run(stmt_wrapper);
+
+  return Qnil;
+}
+#endif
+
+/* call-seq: stmt.execute_batch(rows, batch_size: 1000) # => array
+ *
+ * Executes the current prepared statement for every row of +rows+, sending up to +batch_size+ rows at once.
+ * Batches are cut earlier when their parameter arrays would take more than 16 MB, a larger row is sent on its own.
+ * Each row is an array of bind values.
+ * Returns an array with the number of affected rows for each batch.
+ * When client library doesn't support batches rows are executed one by one.
+ */
+static VALUE rb_sqlanywhere_stmt_execute_batch(int argc, VALUE *argv, VALUE self) {
+  GET_STATEMENT(self);
+  struct sqlanywhere_batch_args batch;
+  VALUE rows;
+  VALUE opts;
+  VALUE batch_size = Qundef;
+  ID kw_ids[1];
+
+  rb_scan_args(argc, argv, "1:", &rows, &opts);
+  Check_Type(rows, T_ARRAY);
+
+  if (!NIL_P(opts)) {
+    kw_ids[0] = SYM2ID(sym_batch_size);
+    rb_get_kwargs(opts, kw_ids, 0, 1, &batch_size);
+  }
+
+  batch.batch_size = batch_size == Qundef ? 1000 : NUM2LONG(batch_size);
+
+  if (batch.batch_size <= 0) {
+    rb_raise(rb_eArgError, "batch_size must be positive");
+  }
+
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
+  }
+
+  rb_sqlanywhere_stmt_describe_binds(stmt_wrapper);
+
+  batch.stmt_wrapper = stmt_wrapper;
+  batch.rows = rows;
+  batch.params = NULL;
+  MEMZERO(&batch.scratch, sqlanywhere_bind_param, 1);
+
+#if _SACAPI_VERSION+0 >= 4
+  if (sqlanywhere_api_version >= SQLANY_API_VERSION_4 && stmt_wrapper->num_params > 0) {
+    batch.params = ZALLOC_N(struct sqlanywhere_batch_param, stmt_wrapper->num_params);
+
+    return rb_ensure(rb_sqlanywhere_stmt_execute_batches, (VALUE)&batch, rb_sqlanywhere_stmt_finish_batches, (VALUE)&batch);
+  }
+#endif
+
+  return rb_ensure(rb_sqlanywhere_stmt_execute_rows, (VALUE)&batch, rb_sqlanywhere_stmt_finish_rows, (VALUE)&batch);
+}
+
+/* call-seq: stmt.each_row(*binds, as: :array, lob: :string) { |row| ... } # => nil
+ *
+ * Fetches and yields rows one at a time without storing them.
+ * Uses the cursor opened by a streamed execution, otherwise executes the statement with +binds+ first.
+ * The cursor is closed once all rows are read or iteration is stopped early.
+ * With lob: :stream, LONG BINARY/LONG VARCHAR values are yielded as SQLAnywhere2::LobReader
+ * which reads the value in chunks and is valid only until the block returns.
+ */
+static VALUE rb_sqlanywhere_stmt_each_row(int argc, VALUE *argv, VALUE self) {
+  GET_STATEMENT(self);
+  struct sqlanywhere_fetch_args fetch;
+  VALUE binds;
+  VALUE opts;
+  VALUE kw_values[2] = {Qnil, Qnil};
+  VALUE as;
+  VALUE lob;
+  ID kw_ids[2];
+
+  rb_scan_args(argc, argv, "*:", &binds, &opts);
+
+  if (!NIL_P(opts)) {
+    kw_ids[0] = SYM2ID(sym_as);
+    kw_ids[1] = SYM2ID(sym_lob);
+    rb_get_kwargs(opts, kw_ids, 0, 2, kw_values);
+  }
+
+  as = kw_values[0] == Qundef ? Qnil : kw_values[0];
+  lob = kw_values[1] == Qundef ? Qnil : kw_values[1];
+
+  if (!NIL_P(lob) && lob != sym_string && lob != sym_stream) {
+    rb_raise(cSQLAnywhere2Error, "lob: option must be :string or :stream");
+  }
+
+  // Streamed execution already chose the shape, unless it is given again
+  if (!stmt_wrapper->streaming || !NIL_P(as)) {
+    rb_sqlanywhere_stmt_set_shape(self, as);
+  }
+
+  if (!stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_run(stmt_wrapper, RARRAY_LEN(binds), RARRAY_CONST_PTR(binds));
+    rb_sqlanywhere_stmt_open_stream(self);
+  }
+
+  stmt_wrapper->lob_stream = lob == sym_stream;
+
+  fetch.stmt_wrapper = stmt_wrapper;
+  rb_sqlanywhere_stmt_init_fetch(self, &fetch, 1);
+
+  rb_ensure(rb_sqlanywhere_stmt_yield_rows, (VALUE)&fetch, rb_sqlanywhere_stmt_finish_each_row, (VALUE)&fetch);
+
+  return Qnil;
+}
+
+/* call-seq: stmt.next_result # => true or false
+ *
+ * Moves the open cursor to the next result set, rows left in the current one are discarded.
+ * Cursor is open after a streamed execution until each_row reads all rows, and inside each_result_set.
+ * Returns false and closes the cursor when there are no more result sets.
+ */
+static VALUE rb_sqlanywhere_stmt_next_result(VALUE self) {
+  GET_STATEMENT(self);
+
+  if (!stmt_wrapper->streaming) {
+    return Qfalse;
+  }
+
+  if (rb_sqlanywhere_stmt_advance(stmt_wrapper)) {
+    return Qtrue;
+  }
+
+  stmt_wrapper->result_sets = 0;
+  rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
+
+  return Qfalse;
+}
+
+static VALUE rb_sqlanywhere_stmt_yield_result_sets(VALUE self) {
+  GET_STATEMENT(self);
+  sacapi_u32 index;
 
-        if (data.database_timezone == sym_local) {
-          ret_data = rb_funcall(ret_data, intern_localtime, 0);
-        } else {
-          ret_data = rb_funcall(ret_data, intern_utc, 0);
-        }
+  for (;;) {
+    index = stmt_wrapper->result_index;
+    rb_sqlanywhere_stmt_build_plan(stmt_wrapper);
 
-        break;
-      case DT_TIME:
-        ret_data = rb_funcall(cTime, intern_parse, 2, ret_data, data.opt_time_date);
+    // Result sets without columns, e.g. from statements inside a procedure, are skipped
+    if (stmt_wrapper->num_cols > 0) {
+      rb_yield(self);
+    }
 
-        if (data.database_timezone == sym_local) {
-          ret_data = rb_funcall(ret_data, intern_localtime, 0);
-        } else {
-          ret_data = rb_funcall(ret_data, intern_utc, 0);
-        }
+    if (!stmt_wrapper->streaming || stmt_wrapper->closed) {
+      break;
+    }
 
-        break;
-      case DT_BIT:
-        ret_data = FIX2INT(ret_data) == 1 ? Qtrue : Qfalse;
-        break;
-      default:
-        break;
-      }
+    // Block may have moved to the following result set with next_result already
+    if (stmt_wrapper->result_index == index && !rb_sqlanywhere_stmt_advance(stmt_wrapper)) {
+      break;
     }
   }
 
-  return ret_data;
+  return Qnil;
 }
 
-static void *nogvl_stmt_execute(void *ptr) {
-  struct nogvl_stmt_execute_args *args = ptr;
-  sacapi_bool result;
+static VALUE rb_sqlanywhere_stmt_finish_result_sets(VALUE ptr) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = (sqlanywhere_stmt_wrapper *)ptr;
 
-  result = sqlany_execute(args->stmt);
+  stmt_wrapper->result_sets = 0;
 
-  return (void*)(result != 0 ? Qtrue : Qfalse);
+  return rb_sqlanywhere_stmt_finish_stream(ptr);
 }
 
-static void nogvl_stmt_execute_ubf(void *ptr) {
-  struct nogvl_stmt_execute_args *args = ptr;
-
-  sqlany_cancel(args->connection);
-}
+/* call-seq: stmt.each_result_set(*binds, as: :array) { |stmt| ... } # => nil
+ *
+ * Yields the statement once for every result set of a query returning several, e.g. a stored procedure.
+ * Inside the block columns describe the current result set and each_row streams its rows,
+ * rows of other result sets are never fetched into memory.
+ * Uses the cursor opened by a streamed execution, otherwise executes the statement with +binds+ first.
+ */
+static VALUE rb_sqlanywhere_stmt_each_result_set(int argc, VALUE *argv, VALUE self) {
+  GET_STATEMENT(self);
+  VALUE binds;
+  VALUE opts;
+  VALUE as = Qundef;
+  ID kw_ids[1];
 
-static void *nogvl_stmt_close(void *ptr) {
-  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
+  rb_scan_args(argc, argv, "*:", &binds, &opts);
 
-  if (!stmt_wrapper->closed) {
-    stmt_wrapper->closed = 1;
-    sqlany_free_stmt(stmt_wrapper->stmt);
+  if (!NIL_P(opts)) {
+    kw_ids[0] = SYM2ID(sym_as);
+    rb_get_kwargs(opts, kw_ids, 0, 1, &as);
   }
 
-  return NULL;
-}
+  as = as == Qundef ? Qnil : as;
 
-static void *nogvl_stmt_fetch_next(void *ptr) {
-  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
-  sacapi_bool result = 0;
+  if (!stmt_wrapper->streaming || !NIL_P(as)) {
+    rb_sqlanywhere_stmt_set_shape(self, as);
+  }
 
-  if (!stmt_wrapper->closed) {
-    result = sqlany_fetch_next(stmt_wrapper->stmt);
+  if (!stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_run(stmt_wrapper, RARRAY_LEN(binds), RARRAY_CONST_PTR(binds));
+    rb_sqlanywhere_stmt_open_stream(self);
   }
 
-  return (void*)(result != 0 ? Qtrue : Qfalse);
-}
+  stmt_wrapper->result_sets = 1;
 
-static void rb_sqlanywhere_stmt_mark(void * ptr) {
-  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
-  if (!stmt_wrapper) return;
+  rb_ensure(rb_sqlanywhere_stmt_yield_result_sets, self, rb_sqlanywhere_stmt_finish_result_sets, (VALUE)stmt_wrapper);
 
-  rb_gc_mark(stmt_wrapper->connection);
+  return Qnil;
 }
 
-static void rb_sqlanywhere_stmt_free(void *ptr) {
-  sqlanywhere_stmt_wrapper *stmt_wrapper = ptr;
-
-  nogvl_stmt_close(stmt_wrapper);
-  decr_sqlanywhere_connection(stmt_wrapper->connection_wrapper);
-  xfree(stmt_wrapper);
-}
+/*
+ * Fills copy format from format: and null: option values
+ * Returns the NULL representation string, which has to stay referenced while the format is used
+ */
+static VALUE rb_sqlanywhere_stmt_copy_format(VALUE format, VALUE null, sqlanywhere_copy_format *copy_format) {
+  format = format == Qundef || NIL_P(format) ? sym_csv : format;
+  null = null == Qundef ? Qnil : null;
 
-static void rb_raise_sqlanywhere_stmt_error(sqlanywhere_stmt_wrapper *stmt_wrapper) {
-  rb_raise_sqlanywhere_error(stmt_wrapper->connection);
-}
+  if (format != sym_csv && format != sym_tsv) {
+    rb_raise(cSQLAnywhere2Error, "format: option must be one of :csv, :tsv");
+  }
 
-VALUE rb_sqlanywhere_stmt_new(VALUE connection, a_sqlany_stmt *stmt) {
-  GET_CONNECTION(connection);
-  sqlanywhere_stmt_wrapper *stmt_wrapper;
-  VALUE rb_stmt;
+  if (NIL_P(null)) {
+    null = rb_str_new_cstr(format == sym_tsv ? "\\N" : "");
+  }
 
-  rb_stmt = Data_Make_Struct(
-    cSQLAnywhere2Statement,
-    sqlanywhere_stmt_wrapper,
-    rb_sqlanywhere_stmt_mark,
-    rb_sqlanywhere_stmt_free,
-    stmt_wrapper
-  );
+  StringValue(null);
 
-  stmt_wrapper->connection = connection;
-  stmt_wrapper->connection_wrapper = DATA_PTR(connection);
-  stmt_wrapper->connection_wrapper->refcount++;
-  stmt_wrapper->closed = 0;
-  stmt_wrapper->fetched = 0;
-  stmt_wrapper->stmt = stmt;
+  copy_format->tsv = format == sym_tsv;
+  copy_format->col_sep = copy_format->tsv ? '\t' : ',';
+  copy_format->null = RSTRING_PTR(null);
+  copy_format->null_len = RSTRING_LEN(null);
 
-  return rb_stmt;
+  return null;
 }
 
-static VALUE rb_sqlanywhere_stmt_rows(VALUE self) {
+/* call-seq: stmt.copy_out(io, *binds, format: :csv, headers: false, null: nil) # => Integer
+ *
+ * Executes the statement and writes its rows to +io+ as CSV or TSV, returns number of rows written.
+ * Rows are formatted from fetched buffers into an output buffer which is written to +io+ in large chunks.
+ */
+static VALUE rb_sqlanywhere_stmt_copy_out(int argc, VALUE *argv, VALUE self) {
   GET_STATEMENT(self);
-  GET_CONNECTION(stmt_wrapper->connection);
-  VALUE rows = rb_ary_new();
-  sacapi_i32 num_cols = sqlany_num_cols(stmt_wrapper->stmt);
-  struct sqlanywhere_data_to_rb_data_args sqlanywhere_data;
-  a_sqlany_data_value col_value;
-  int error_code;
-  VALUE row;
-  int i;
+  struct sqlanywhere_fetch_args fetch;
+  struct sqlanywhere_copy_out_args args;
+  VALUE io;
+  VALUE binds;
+  VALUE opts;
+  VALUE kw_values[3] = {Qundef, Qundef, Qundef};
+  VALUE null;
+  ID kw_ids[3];
+
+  rb_scan_args(argc, argv, "1*:", &io, &binds, &opts);
+
+  if (!NIL_P(opts)) {
+    kw_ids[0] = SYM2ID(sym_format);
+    kw_ids[1] = SYM2ID(sym_headers);
+    kw_ids[2] = SYM2ID(sym_null);
+    rb_get_kwargs(opts, kw_ids, 0, 3, kw_values);
+  }
 
-  sqlanywhere_data.encoding = rb_sqlanywhere_encoding(stmt_wrapper->connection);
-  sqlanywhere_data.cast = rb_iv_get(stmt_wrapper->connection, "@cast") == Qtrue;
-  sqlanywhere_data.database_timezone = rb_iv_get(stmt_wrapper->connection, "@database_timezone");
-  sqlanywhere_data.opt_time_date = rb_funcall(cDate, intern_new, 2, INT2NUM(2000), INT2NUM(1));
+  null = rb_sqlanywhere_stmt_copy_format(kw_values[0], kw_values[2], &args.format);
 
-  if (num_cols < 0) {
-    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
-  }
+  args.io = io;
+  args.fetch = &fetch;
 
-  if (num_cols == 0) {
-    return rows;
-  }
+  rb_sqlanywhere_stmt_set_shape(self, Qnil);
 
-  a_sqlany_column_info column_info[num_cols];
-  for (i = 0; i < num_cols; i++) {
-    sqlany_get_column_info(stmt_wrapper->stmt, i, &column_info[i]);
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
   }
 
-  while((VALUE) rb_thread_call_without_gvl(nogvl_stmt_fetch_next, stmt_wrapper, RUBY_UBF_IO, 0) == Qtrue) {
-    row = rb_ary_new();
+  rb_sqlanywhere_stmt_run(stmt_wrapper, RARRAY_LEN(binds), RARRAY_CONST_PTR(binds));
 
-    for (i = 0; i < num_cols; i++) {
-      if (!sqlany_get_column(stmt_wrapper->stmt, i, &col_value)) {
-        rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
-      }
-
-      sqlanywhere_data.value = &col_value;
-      sqlanywhere_data.info = &column_info[i];
+  // Rows go to the IO only, no result is stored
+  stmt_wrapper->fetched = 1;
+  rb_iv_set(self, "@last_result", Qnil);
 
-      rb_ary_push(row, sqlanywhere_data_to_rb_data(sqlanywhere_data));
-    }
+  fetch.stmt_wrapper = stmt_wrapper;
+  rb_sqlanywhere_stmt_init_fetch(self, &fetch, 0);
 
-    rb_ary_push(rows, row);
+  if (fetch.num_cols == 0) {
+    sqlany_reset(stmt_wrapper->stmt);
+    return INT2FIX(0);
   }
 
-  /* SQLAnywhere bug
-  * When executing a select query with wrong search type
-  * it doesn't return an error until we start to fetch results
-  * Example
-  *
-  * CREATE TABLE exp(id INT, name VARCHAR(255));
-  * SELECT * FROM exp where name = 123;
-  *
-  * This will only return an error when we start fetching results
-  */
-  error_code = sqlany_error(wrapper->connection, NULL, SACAPI_ERROR_SIZE);
+  args.buffer = rb_str_buf_new(SQLANYWHERE_COPY_FLUSH_BYTES);
+  rb_enc_associate(args.buffer, stmt_wrapper->encoding);
 
-  if (error_code != 0 && error_code != ROW_NOT_FOUND_ERROR) {
-    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  if (kw_values[1] != Qundef && RTEST(kw_values[1])) {
+    rb_sqlanywhere_stmt_copy_headers(&args);
   }
 
-  return rows;
+  fetch.prefetch = 1;
+
+  rb_ensure(rb_sqlanywhere_stmt_copy_rows, (VALUE)&args, rb_sqlanywhere_stmt_finish_copy, (VALUE)&args);
+
+  RB_GC_GUARD(null);
+
+  return LONG2NUM(fetch.rows_fetched);
 }
 
-/* call-seq:
- *    stmt.affected_rows
- *
- * Returns the number of rows changed, deleted, or inserted.
+/*
+ * Packs parsed values of a single parameter into a column-wise array and binds it
+ * Strings are as wide as the longest value of the batch, numbers are 64 bit
  */
-static VALUE rb_sqlanywhere_stmt_affected_rows(VALUE self) {
-  sacapi_i32 affected;
-  GET_STATEMENT(self);
+static void rb_sqlanywhere_stmt_bind_copy_param(struct sqlanywhere_copy_in_args *args, sacapi_i32 index) {
+  sqlanywhere_copy_batch *batch = &args->parser.batch;
+  struct sqlanywhere_batch_param *param = &args->params[index];
+  a_sqlany_data_type type = batch->types[index];
+  size_t width = batch->widths[index];
+  size_t cell;
+  long i;
+
+  if (param->capacity < width * batch->rows) {
+    param->capacity = width * batch->rows;
+    REALLOC_N(param->buffer, char, param->capacity);
+  }
 
-  affected = sqlany_affected_rows(stmt_wrapper->stmt);
+  for (i = 0; i < batch->rows; i++) {
+    cell = (size_t)i * batch->num_params + index;
+    param->nulls[i] = batch->nulls[cell];
+    param->lengths[i] = 0;
 
-  if (affected == -1) {
-    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    if (batch->nulls[cell]) {
+      continue;
+    }
+
+    if (type == A_STRING || type == A_BINARY) {
+      param->lengths[i] = batch->lengths[cell];
+      memcpy(param->buffer + width * i, batch->data + batch->offsets[cell], batch->lengths[cell]);
+    } else {
+      param->lengths[i] = width;
+      memcpy(param->buffer + width * i, &batch->numbers[cell], width);
+    }
+
+    args->stmt_wrapper->run.bind_bytes += param->lengths[i];
   }
 
-  return ULL2NUM(affected);
+  param->param.value.buffer = param->buffer;
+  param->param.value.buffer_size = width;
+  param->param.value.length = param->lengths;
+  param->param.value.is_null = param->nulls;
+  param->param.value.type = type;
+#if _SACAPI_VERSION+0 >= 4
+  param->param.value.is_address = 0;
+#endif
 }
 
-/* call-seq: stmt.num_params # => Numeric
- *
- * Returns the number of parameters the prepared statement expects.
+/*
+ * Executes all rows of the batch at once, returns 0 if client library doesn't support batches
  */
-static VALUE rb_sqlanywhere_stmt_num_params(VALUE self) {
-  sacapi_i32 params;
-  GET_STATEMENT(self);
+static int rb_sqlanywhere_stmt_execute_copy_batch(struct sqlanywhere_copy_in_args *args) {
+#if _SACAPI_VERSION+0 >= 4
+  sqlanywhere_stmt_wrapper *stmt_wrapper = args->stmt_wrapper;
+  struct nogvl_stmt_execute_args execute;
+  sacapi_i32 i;
 
-  params = sqlany_num_params(stmt_wrapper->stmt);
+  if (sqlanywhere_api_version < SQLANY_API_VERSION_4) {
+    return 0;
+  }
 
-  if (params == -1) {
+  if (!sqlany_set_batch_size(stmt_wrapper->stmt, (sacapi_u32)args->parser.batch.rows) ||
+    !sqlany_set_param_bind_type(stmt_wrapper->stmt, 0)) {
     rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
   }
 
-  return ULL2NUM(params);
-}
+  for (i = 0; i < stmt_wrapper->num_params; i++) {
+    if (!sqlany_bind_param(stmt_wrapper->stmt, i, &args->params[i].param)) {
+      rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+    }
+  }
 
-/* call-seq: stmt.num_columns # => Numeric
- *
- * Returns the number of parameters the prepared statement expects.
- */
-static VALUE rb_sqlanywhere_stmt_num_columns(VALUE self) {
-  sacapi_i32 cols;
-  GET_STATEMENT(self);
+  execute.stmt = stmt_wrapper->stmt;
+  execute.connection = stmt_wrapper->connection_wrapper->connection;
 
-  cols = sqlany_num_cols(stmt_wrapper->stmt);
+  rb_sqlanywhere_stmt_execute_args(stmt_wrapper, &execute);
 
-  if (cols == -1) {
+  if (!sqlany_reset(stmt_wrapper->stmt)) {
     rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
   }
 
-  return ULL2NUM(cols);
+  return 1;
+#else
+  return 0;
+#endif
 }
 
-/* call-seq: stmt.columns # => array
- *
- * Returns a list of columns that will be returned by this statement.
+/*
+ * Executes rows of the batch one by one, binding single elements of the packed arrays
  */
-static VALUE rb_sqlanywhere_stmt_columns(VALUE self) {
-  sacapi_i32 column_count;
+static void rb_sqlanywhere_stmt_execute_copy_rows(struct sqlanywhere_copy_in_args *args) {
+  sqlanywhere_stmt_wrapper *stmt_wrapper = args->stmt_wrapper;
+  struct nogvl_stmt_execute_args execute;
+  a_sqlany_bind_param param;
+  long row;
   sacapi_i32 i;
-  VALUE column_list;
-  GET_STATEMENT(self);
-  GET_CONNECTION(stmt_wrapper->connection);
 
-  column_count = sqlany_num_cols(stmt_wrapper->stmt);
-  column_list = rb_ary_new2((long)column_count);
+  execute.stmt = stmt_wrapper->stmt;
+  execute.connection = stmt_wrapper->connection_wrapper->connection;
 
-  for (i = 0; i < column_count; i++) {
-    VALUE rb_field;
-    a_sqlany_column_info column_info;
+  for (row = 0; row < args->parser.batch.rows; row++) {
+    for (i = 0; i < stmt_wrapper->num_params; i++) {
+      param = args->params[i].param;
+      param.value.buffer += param.value.buffer_size * row;
+      param.value.length += row;
+      param.value.is_null += row;
 
-    if (sqlany_get_column_info(stmt_wrapper->stmt, i, &column_info) == 0) {
+      if (!sqlany_bind_param(stmt_wrapper->stmt, i, &param)) {
+        rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+      }
+    }
+
+    rb_sqlanywhere_stmt_execute_args(stmt_wrapper, &execute);
+
+    if (!sqlany_reset(stmt_wrapper->stmt)) {
       rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
     }
+  }
+}
 
-    rb_field = rb_funcall(
-      cSQLAnywhere2Column,
-      intern_new,
-      7,
-      rb_str_new2(column_info.name),
-      INT2NUM(column_info.type),
-      INT2NUM(column_info.native_type),
-      INT2NUM(column_info.precision),
-      INT2NUM(column_info.scale),
-      LONG2NUM(column_info.max_size),
-      column_info.nullable == 1 ? Qtrue : Qfalse
-    );
+static void rb_sqlanywhere_stmt_flush_copy_in(struct sqlanywhere_copy_in_args *args) {
+  sacapi_i32 i;
 
-    rb_ary_store(column_list, (long)i, rb_field);
+  if (args->parser.batch.rows == 0) {
+    return;
   }
 
-  return column_list;
-}
+  for (i = 0; i < args->stmt_wrapper->num_params; i++) {
+    rb_sqlanywhere_stmt_bind_copy_param(args, i);
+  }
 
-/* call-seq: stmt.close # => nil
- *
- * Explicitly closing this will free up server resources immediately rather
- * than waiting for the garbage collector.
- * This is also required to free up any locks in the database.
- * Since statement execution creates a database lock with procedures which contain insert/update
- * irregardless of commit statement
- */
-static VALUE rb_sqlanywhere_stmt_close(VALUE self) {
-  GET_STATEMENT(self);
+  if (!rb_sqlanywhere_stmt_execute_copy_batch(args)) {
+    rb_sqlanywhere_stmt_execute_copy_rows(args);
+  }
 
-  rb_thread_call_without_gvl(nogvl_stmt_close, stmt_wrapper, RUBY_UBF_IO, 0);
+  if (args->commit) {
+    rb_funcall(args->stmt_wrapper->connection, intern_commit_bang, 0);
+  }
 
-  return Qnil;
+  args->rows += args->parser.batch.rows;
+  args->batches++;
+
+  sqlanywhere_copy_batch_clear(&args->parser);
 }
 
-static VALUE rb_sqlanywhere_stmt_create_result(VALUE self) {
-  VALUE cols = rb_sqlanywhere_stmt_columns(self);
-  VALUE rows = rb_sqlanywhere_stmt_rows(self);
+static VALUE rb_sqlanywhere_stmt_copy_in_rows(VALUE ptr) {
+  struct sqlanywhere_copy_in_args *args = (struct sqlanywhere_copy_in_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = args->stmt_wrapper;
+  sqlanywhere_copy_parser *parser = &args->parser;
+  VALUE buffer = rb_str_buf_new(SQLANYWHERE_COPY_FLUSH_BYTES);
+  long batch_size = parser->batch.batch_size;
+  size_t offset;
+  sacapi_i32 i;
 
-  return rb_funcall(cSQLAnywhere2Result, intern_new, 2, cols, rows);
-}
+  sqlanywhere_copy_parser_init(parser, stmt_wrapper->binds, stmt_wrapper->num_params, batch_size);
 
-/* call-seq: stmt.last_result # => SQLAnywhere::Result
- *
- * Returns results from previously executed query
- * Returns nil if last query didn't return a result set
- * When used with multiple result query returns an array of SQLAnywhere::Result
- */
-VALUE rb_sqlanywhere_stmt_last_result(VALUE self) {
-  GET_STATEMENT(self);
-  VALUE last_result;
+  args->params = ZALLOC_N(struct sqlanywhere_batch_param, stmt_wrapper->num_params);
 
-  if (stmt_wrapper->fetched) {
-    last_result = rb_iv_get(self, "@last_result");
-    return last_result;
+  for (i = 0; i < stmt_wrapper->num_params; i++) {
+    args->params[i].param = stmt_wrapper->binds[i].param;
+    args->params[i].lengths = ALLOC_N(size_t, batch_size);
+    args->params[i].nulls = ALLOC_N(sacapi_bool, batch_size);
   }
 
-  if (sqlany_num_cols(stmt_wrapper->stmt) < 0) {
-    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  while (!NIL_P(rb_funcall(args->io, intern_read, 2, INT2NUM(SQLANYWHERE_COPY_FLUSH_BYTES), buffer))) {
+    for (offset = 0; offset < (size_t)RSTRING_LEN(buffer);) {
+      offset += sqlanywhere_copy_parse(parser, RSTRING_PTR(buffer) + offset, RSTRING_LEN(buffer) - offset);
+
+      if (parser->batch.rows == batch_size || parser->batch.pending) {
+        rb_sqlanywhere_stmt_flush_copy_in(args);
+      }
+    }
   }
 
-  last_result = rb_sqlanywhere_stmt_create_result(self);
+  sqlanywhere_copy_parse_end(parser);
 
-  rb_iv_set(self, "@last_result", last_result);
+  // Last row may be left pending
+  while (parser->batch.rows > 0) {
+    rb_sqlanywhere_stmt_flush_copy_in(args);
+  }
 
-  stmt_wrapper->fetched = 1;
+  return Qnil;
+}
 
-  return last_result;
+static VALUE rb_sqlanywhere_stmt_finish_copy_in(VALUE ptr) {
+  struct sqlanywhere_copy_in_args *args = (struct sqlanywhere_copy_in_args *)ptr;
+  sqlanywhere_stmt_wrapper *stmt_wrapper = args->stmt_wrapper;
+  sacapi_i32 i;
+
+  if (!stmt_wrapper->closed) {
+#if _SACAPI_VERSION+0 >= 4
+    if (sqlanywhere_api_version >= SQLANY_API_VERSION_4) {
+      sqlany_set_batch_size(stmt_wrapper->stmt, 1);
+    }
+#endif
+    sqlany_reset(stmt_wrapper->stmt);
+  }
+
+  if (args->params != NULL) {
+    for (i = 0; i < stmt_wrapper->num_params; i++) {
+      xfree(args->params[i].buffer);
+      xfree(args->params[i].lengths);
+      xfree(args->params[i].nulls);
+    }
+
+    xfree(args->params);
+  }
+
+  sqlanywhere_copy_parser_free(&args->parser);
+
+  rb_sqlanywhere_stmt_finish_run(stmt_wrapper);
+
+  return Qnil;
 }
 
-/* call-seq: stmt.execute
+/* call-seq: stmt.copy_in(io, format: :csv, batch_size: 1000, headers: false, null: nil, commit: true) # => Hash
  *
- * Executes the current prepared statement, returns +result+.
+ * Reads CSV or TSV rows from +io+ and executes the statement with fields of every row as bind parameters.
+ * Fields are parsed natively into arrays typed after the described parameters and sent +batch_size+ rows at once,
+ * each batch is committed unless +commit+ is false.
+ * Rows with a wrong number of fields or values not matching the parameter type are skipped.
+ * Returns {rows:, batches:, skipped:, first_bad_line:}.
  */
-static VALUE rb_sqlanywhere_stmt_execute(int argc, VALUE *argv, VALUE self) {
+static VALUE rb_sqlanywhere_stmt_copy_in(int argc, VALUE *argv, VALUE self) {
   GET_STATEMENT(self);
-  GET_CONNECTION(stmt_wrapper->connection);
-  sacapi_i32 bind_count;
-  sacapi_i32 i;
-  a_sqlany_stmt *stmt;
+  struct sqlanywhere_copy_in_args args;
+  VALUE io;
+  VALUE opts;
+  VALUE kw_values[5] = {Qundef, Qundef, Qundef, Qundef, Qundef};
+  VALUE null;
   VALUE result;
-  rb_encoding *encoding;
-  struct nogvl_stmt_execute_args args;
-  struct rb_data_to_sqlanywhere_data_args rb_data;
-  int args_count = rb_scan_args(argc, argv, "*", NULL);
-  sacapi_i32 alloc_count = 0;
-
-  encoding = rb_sqlanywhere_encoding(stmt_wrapper->connection);
-  stmt = stmt_wrapper->stmt;
-  bind_count = sqlany_num_params(stmt);
+  ID kw_ids[5];
 
-  rb_data.encoding = encoding;
+  rb_scan_args(argc, argv, "1:", &io, &opts);
 
-  if (args_count != (sacapi_i32)bind_count) {
-    rb_raise(
-      cSQLAnywhere2Error,
-      "Bind parameter count (%ld) doesn't match number of arguments (%d)",
-      (long)bind_count,
-      args_count
-      );
+  if (!NIL_P(opts)) {
+    kw_ids[0] = SYM2ID(sym_format);
+    kw_ids[1] = SYM2ID(sym_batch_size);
+    kw_ids[2] = SYM2ID(sym_headers);
+    kw_ids[3] = SYM2ID(sym_null);
+    kw_ids[4] = SYM2ID(sym_commit);
+    rb_get_kwargs(opts, kw_ids, 0, 5, kw_values);
   }
 
-  // Hold binds to free them up later
-  a_sqlany_bind_param bind_params[bind_count];
-
-  if (bind_count > 0) {
-    for (i = 0; i < bind_count; i++) {
-      if (!sqlany_describe_bind_param(stmt, i, &bind_params[i])) {
-        rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
-      }
+  MEMZERO(&args, struct sqlanywhere_copy_in_args, 1);
 
-      rb_data.arg = argv[i];
-      rb_data.value = &bind_params[i].value;
+  null = rb_sqlanywhere_stmt_copy_format(kw_values[0], kw_values[3], &args.parser.format);
+  args.parser.batch.batch_size = kw_values[1] == Qundef ? 1000 : NUM2LONG(kw_values[1]);
+  args.parser.headers = kw_values[2] != Qundef && RTEST(kw_values[2]);
+  args.commit = kw_values[4] == Qundef || RTEST(kw_values[4]);
+  args.stmt_wrapper = stmt_wrapper;
+  args.io = io;
 
-      rb_data_to_sqlanywhere_data(rb_data);
-      alloc_count++;
+  if (args.parser.batch.batch_size <= 0) {
+    rb_raise(rb_eArgError, "batch_size must be positive");
+  }
 
-      if (!sqlany_bind_param(stmt, i, &bind_params[i])) {
-        FREE_BINDS;
-        rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
-      }
-    }
+  if (stmt_wrapper->streaming) {
+    rb_sqlanywhere_stmt_finish_stream((VALUE)stmt_wrapper);
   }
 
-  args.stmt = stmt;
-  args.connection = wrapper->connection;
+  rb_sqlanywhere_stmt_describe_binds(stmt_wrapper);
 
-  if ((VALUE)rb_thread_call_without_gvl(nogvl_stmt_execute, &args, nogvl_stmt_execute_ubf, &args) == Qfalse) {
-    FREE_BINDS;
-    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
+  if (stmt_wrapper->num_params == 0) {
+    rb_raise(cSQLAnywhere2Error, "copy_in requires a statement with bind parameters");
   }
 
-  FREE_BINDS;
+  // Nothing is fetched from the statement, no result is stored
+  stmt_wrapper->fetched = 1;
+  rb_iv_set(self, "@last_result", Qnil);
 
-  stmt_wrapper->fetched = 0;
+  rb_ensure(rb_sqlanywhere_stmt_copy_in_rows, (VALUE)&args, rb_sqlanywhere_stmt_finish_copy_in, (VALUE)&args);
 
-  result = rb_sqlanywhere_stmt_last_result(self);
+  RB_GC_GUARD(null);
 
-  // Reset statement to its prepared state condition
-  if (!sqlany_reset(stmt)) {
-    rb_raise_sqlanywhere_stmt_error(stmt_wrapper);
-  }
+  result = rb_hash_new();
+  rb_hash_aset(result, sym_rows, LONG2NUM(args.rows));
+  rb_hash_aset(result, sym_batches, LONG2NUM(args.batches));
+  rb_hash_aset(result, sym_skipped, LONG2NUM(args.parser.skipped));
+  rb_hash_aset(result, sym_first_bad_line, args.parser.first_bad_line > 0 ? LONG2NUM(args.parser.first_bad_line) : Qnil);
 
   return result;
 }
 
 void init_sqlanywhere_statement() {
-  cDate = rb_const_get(rb_cObject, rb_intern("Date"));
-  cTime = rb_const_get(rb_cObject, rb_intern("Time"));
-  cBigDecimal = rb_const_get(rb_cObject, rb_intern("BigDecimal"));
   cSQLAnywhere2Result = rb_const_get(mSQLAnywhere2, rb_intern("Result"));
-  cSQLAnywhere2Column = rb_const_get(mSQLAnywhere2, rb_intern("Column"));
 
   cSQLAnywhere2Statement = rb_define_class_under(mSQLAnywhere2, "Statement", rb_cObject);
   rb_undef_alloc_func(cSQLAnywhere2Statement);
-  rb_define_method(cSQLAnywhere2Statement, "execute", rb_sqlanywhere_stmt_execute, -1);
+  rb_define_method(cSQLAnywhere2Statement, "connection", rb_sqlanywhere_stmt_connection, 0);
+  rb_define_method(cSQLAnywhere2Statement, "stats", rb_sqlanywhere_stmt_stats, 0);
   rb_define_method(cSQLAnywhere2Statement, "close", rb_sqlanywhere_stmt_close, 0);
+  rb_define_method(cSQLAnywhere2Statement, "closed?", rb_sqlanywhere_stmt_closed, 0);
+  rb_define_method(cSQLAnywhere2Statement, "streaming?", rb_sqlanywhere_stmt_streaming, 0);
+  rb_define_method(cSQLAnywhere2Statement, "next_result", rb_sqlanywhere_stmt_next_result, 0);
   rb_define_method(cSQLAnywhere2Statement, "num_columns", rb_sqlanywhere_stmt_num_columns, 0);
   rb_define_method(cSQLAnywhere2Statement, "columns", rb_sqlanywhere_stmt_columns, 0);
   rb_define_method(cSQLAnywhere2Statement, "num_params", rb_sqlanywhere_stmt_num_params, 0);
   rb_define_method(cSQLAnywhere2Statement, "affected_rows", rb_sqlanywhere_stmt_affected_rows, 0);
   rb_define_method(cSQLAnywhere2Statement, "last_result", rb_sqlanywhere_stmt_last_result, 0);
-
-  sym_local = ID2SYM(rb_intern("local"));
+  rb_define_method(cSQLAnywhere2Statement, "fetch_size", rb_sqlanywhere_stmt_fetch_size, 0);
+  rb_define_method(cSQLAnywhere2Statement, "fetch_size=", rb_sqlanywhere_stmt_set_fetch_size, 1);
+  rb_define_method(cSQLAnywhere2Statement, "execute_update", rb_sqlanywhere_stmt_execute_update, -1);
+  rb_define_private_method(cSQLAnywhere2Statement, "_execute", rb_sqlanywhere_stmt_execute, -1);
+  rb_define_private_method(cSQLAnywhere2Statement, "_execute_batch", rb_sqlanywhere_stmt_execute_batch, -1);
+  rb_define_private_method(cSQLAnywhere2Statement, "_execute_async", rb_sqlanywhere_stmt_execute_async, 3);
+  rb_define_private_method(cSQLAnywhere2Statement, "_open_cursor", rb_sqlanywhere_stmt_open_cursor, -1);
+  rb_define_private_method(cSQLAnywhere2Statement, "_each_row", rb_sqlanywhere_stmt_each_row, -1);
+  rb_define_private_method(cSQLAnywhere2Statement, "_each_result_set", rb_sqlanywhere_stmt_each_result_set, -1);
+  rb_define_private_method(cSQLAnywhere2Statement, "_copy_out", rb_sqlanywhere_stmt_copy_out, -1);
+  rb_define_private_method(cSQLAnywhere2Statement, "_copy_in", rb_sqlanywhere_stmt_copy_in, -1);
+
+  sym_stream = ID2SYM(rb_intern("stream"));
+  sym_batch_size = ID2SYM(rb_intern("batch_size"));
+  sym_as = ID2SYM(rb_intern("as"));
+  sym_lob = ID2SYM(rb_intern("lob"));
+  sym_format = ID2SYM(rb_intern("format"));
+  sym_timeout = ID2SYM(rb_intern("timeout"));
+  sym_rows = ID2SYM(rb_intern("rows"));
+  sym_columnar = ID2SYM(rb_intern("columnar"));
+  sym_max_rows = ID2SYM(rb_intern("max_rows"));
+  sym_max_bytes = ID2SYM(rb_intern("max_bytes"));
+  sym_on_limit = ID2SYM(rb_intern("on_limit"));
+  sym_csv = ID2SYM(rb_intern("csv"));
+  sym_tsv = ID2SYM(rb_intern("tsv"));
+  sym_headers = ID2SYM(rb_intern("headers"));
+  sym_null = ID2SYM(rb_intern("null"));
+  sym_commit = ID2SYM(rb_intern("commit"));
+  sym_batches = ID2SYM(rb_intern("batches"));
+  sym_skipped = ID2SYM(rb_intern("skipped"));
+  sym_first_bad_line = ID2SYM(rb_intern("first_bad_line"));
+  sym_string = ID2SYM(rb_intern("string"));
+  sym_array = ID2SYM(rb_intern("array"));
+  sym_hash = ID2SYM(rb_intern("hash"));
+  sym_symbol_hash = ID2SYM(rb_intern("symbol_hash"));
+  sym_struct = ID2SYM(rb_intern("struct"));
+
+  row_structs = rb_hash_new();
+  rb_gc_register_address(&row_structs);
 
   intern_new = rb_intern("new");
-  intern_parse = rb_intern("parse");
-  intern_BigDecimal = rb_intern("BigDecimal");
-  intern_localtime = rb_intern("localtime");
-  intern_utc = rb_intern("utc");
+  intern_read = rb_intern("read");
+  intern_write = rb_intern("write");
+  intern_commit_bang = rb_intern("commit!");
+  intern_call = rb_intern("call");
+  intern_stats_hook = rb_intern("@stats_hook");
+  intern_timeout = rb_intern("@timeout");
+  intern_last_result = rb_intern("@last_result");
+  intern_external_encoding = rb_intern("external_encoding");
+  intern_to_time = rb_intern("to_time");
+  intern_to_s = rb_intern("to_s");
+  intern_year = rb_intern("year");
+  intern_mon = rb_intern("mon");
+  intern_mday = rb_intern("mday");
+
+  cDate = rb_const_get(rb_cObject, rb_intern("Date"));
+  cDateTime = rb_const_get(rb_cObject, rb_intern("DateTime"));
+  cBigDecimal = rb_const_get(rb_cObject, rb_intern("BigDecimal"));
+
+  str_plain_format = rb_obj_freeze(rb_str_new_cstr("F"));
+  rb_gc_register_address(&str_plain_format);
 }
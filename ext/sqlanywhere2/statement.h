@@ -1,17 +1,104 @@
 #ifndef SQLANYWHERE_STATEMENT_H
 #define SQLANYWHERE_STATEMENT_H
 
+struct rb_data_to_sqlanywhere_data_args;
+
+typedef void (*sqlanywhere_bind_encoder)(struct rb_data_to_sqlanywhere_data_args *data);
+
+/*
+ * Bind parameter with storage reused between executions
+ * Fixed width values are written in place, strings are copied into buffer which only grows
+ * Streamed params (IO values) have no buffer, their data is sent with sqlany_send_param_data
+ * type is the one described by sqlany_describe_bind_param, param type follows the bound value
+ * encode is chosen for klass of the bound value and reused while following values have the same class
+ */
+typedef struct {
+  a_sqlany_bind_param param;
+  a_sqlany_data_type type;
+  sacapi_bool is_null;
+  size_t length;
+  char *buffer;
+  size_t capacity;
+  int streamed;
+  VALUE klass;
+  sqlanywhere_bind_encoder encode;
+  union {
+    LONG_LONG val64;
+    int val32;
+    double val_double;
+    unsigned char val8;
+  } fixed;
+} sqlanywhere_bind_param;
+
+/*
+ * Column-wise buffers for multi-row fetching
+ */
 typedef struct {
+  char *buffer;
+  size_t width;
+  size_t *lengths;
+  sacapi_bool *nulls;
+} sqlanywhere_rowset_column;
+
+enum sqlanywhere_row_shape {
+  ROW_AS_ARRAY,
+  ROW_AS_HASH,
+  ROW_AS_SYMBOL_HASH,
+  ROW_AS_STRUCT
+};
+
+/*
+ * stats counts finished executions, run the current one until its result is read
+ */
+typedef struct sqlanywhere_stmt_wrapper {
+  VALUE self;
   VALUE connection;
   sqlanywhere_connection_wrapper *connection_wrapper;
+  struct sqlanywhere_stmt_wrapper *prev;
+  struct sqlanywhere_stmt_wrapper *next;
   a_sqlany_stmt *stmt;
   int closed;
   int fetched;
+  int streaming;
+  rb_encoding *encoding;
+  sacapi_i32 num_cols;
+  sqlanywhere_column_plan *columns;
+  VALUE column_list;
+  VALUE column_keys;
+  VALUE column_symbols;
+  VALUE row_struct;
+  enum sqlanywhere_row_shape shape;
+  int columnar;
+  sqlanywhere_result_limits limits;
+  int lob_stream;
+  int result_sets;
+  sacapi_u32 result_index;
+  unsigned long row_generation;
+  VALUE decimal_buffer;
+  sacapi_i32 num_params;
+  sqlanywhere_bind_param *binds;
+  sacapi_u32 fetch_size;
+  sacapi_u32 rowset_size;
+  sacapi_i32 rowset_cols;
+  sqlanywhere_rowset_column *rowset;
+  int rowset_bound;
+  sqlanywhere_staging staging;
+  sqlanywhere_async_job *job;
+  sqlanywhere_stats stats;
+  sqlanywhere_stats run;
 } sqlanywhere_stmt_wrapper;
 
 void init_sqlanywhere_statement(void);
 
-VALUE rb_sqlanywhere_stmt_new(VALUE connection, a_sqlany_stmt *stmt);
+VALUE rb_sqlanywhere_stmt_new(VALUE connection, a_sqlany_stmt *stmt, const sqlanywhere_stats *stats);
 VALUE rb_sqlanywhere_stmt_last_result(VALUE self);
+void rb_sqlanywhere_stmt_open_stream(VALUE self);
+void rb_sqlanywhere_stmt_set_shape(VALUE self, VALUE as);
+VALUE rb_sqlanywhere_stmt_executed(VALUE self, VALUE stream);
+VALUE rb_sqlanywhere_stmt_fetch_page(VALUE self, long offset, long count);
+void rb_sqlanywhere_stmt_close_stream(sqlanywhere_stmt_wrapper *stmt_wrapper);
+void rb_sqlanywhere_stmt_finish_run(sqlanywhere_stmt_wrapper *stmt_wrapper);
+void sqlanywhere_stmt_free_binds(sqlanywhere_bind_param *binds, sacapi_i32 num_params);
+void sqlanywhere_stmt_close_all(sqlanywhere_connection_wrapper *connection_wrapper);
 
 #endif
@@ -0,0 +1,72 @@
+#include <sqlanywhere2.h>
+
+static VALUE sym_prepare_ns, sym_execute_ns, sym_fetch_ns, sym_convert_ns;
+static VALUE sym_executions, sym_rows, sym_fetched_bytes, sym_bind_bytes, sym_gvl_releases;
+
+uint64_t sqlanywhere_stats_clock(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+void sqlanywhere_stats_add(sqlanywhere_stats *stats, const sqlanywhere_stats *other) {
+  stats->prepare_ns += other->prepare_ns;
+  stats->execute_ns += other->execute_ns;
+  stats->fetch_ns += other->fetch_ns;
+  stats->convert_ns += other->convert_ns;
+  stats->executions += other->executions;
+  stats->rows += other->rows;
+  stats->fetched_bytes += other->fetched_bytes;
+  stats->bind_bytes += other->bind_bytes;
+  stats->gvl_releases += other->gvl_releases;
+}
+
+/*
+ * Calls func without the GVL like rb_thread_call_without_gvl, the time it took is added to counter
+ */
+void *rb_sqlanywhere_stats_without_gvl(
+  sqlanywhere_stats *stats,
+  uint64_t *counter,
+  void *(*func)(void *),
+  void *data1,
+  rb_unblock_function_t *ubf,
+  void *data2
+) {
+  uint64_t start = sqlanywhere_stats_clock();
+  void *result = rb_thread_call_without_gvl(func, data1, ubf, data2);
+
+  *counter += sqlanywhere_stats_clock() - start;
+  stats->gvl_releases++;
+
+  return result;
+}
+
+VALUE rb_sqlanywhere_stats_hash(const sqlanywhere_stats *stats) {
+  VALUE hash = rb_hash_new();
+
+  rb_hash_aset(hash, sym_prepare_ns, ULL2NUM(stats->prepare_ns));
+  rb_hash_aset(hash, sym_execute_ns, ULL2NUM(stats->execute_ns));
+  rb_hash_aset(hash, sym_fetch_ns, ULL2NUM(stats->fetch_ns));
+  rb_hash_aset(hash, sym_convert_ns, ULL2NUM(stats->convert_ns));
+  rb_hash_aset(hash, sym_executions, ULL2NUM(stats->executions));
+  rb_hash_aset(hash, sym_rows, ULL2NUM(stats->rows));
+  rb_hash_aset(hash, sym_fetched_bytes, ULL2NUM(stats->fetched_bytes));
+  rb_hash_aset(hash, sym_bind_bytes, ULL2NUM(stats->bind_bytes));
+  rb_hash_aset(hash, sym_gvl_releases, ULL2NUM(stats->gvl_releases));
+
+  return hash;
+}
+
+void init_sqlanywhere_stats() {
+  sym_prepare_ns = ID2SYM(rb_intern("prepare_ns"));
+  sym_execute_ns = ID2SYM(rb_intern("execute_ns"));
+  sym_fetch_ns = ID2SYM(rb_intern("fetch_ns"));
+  sym_convert_ns = ID2SYM(rb_intern("convert_ns"));
+  sym_executions = ID2SYM(rb_intern("executions"));
+  sym_rows = ID2SYM(rb_intern("rows"));
+  sym_fetched_bytes = ID2SYM(rb_intern("fetched_bytes"));
+  sym_bind_bytes = ID2SYM(rb_intern("bind_bytes"));
+  sym_gvl_releases = ID2SYM(rb_intern("gvl_releases"));
+}
@@ -0,0 +1,39 @@
+#ifndef SQLANYWHERE_STATS_H
+#define SQLANYWHERE_STATS_H
+
+#include <stdint.h>
+
+// Rows streamed to a block have their conversion timed once per this many rows
+#define SQLANYWHERE_STATS_SAMPLE 16
+
+/*
+ * Performance counters of a statement or connection, times are nanoseconds of the monotonic clock
+ * Counters are plain integers, they are only updated by the thread executing the statement
+ */
+typedef struct {
+  uint64_t prepare_ns;
+  uint64_t execute_ns;
+  uint64_t fetch_ns;
+  uint64_t convert_ns;
+  uint64_t executions;
+  uint64_t rows;
+  uint64_t fetched_bytes;
+  uint64_t bind_bytes;
+  uint64_t gvl_releases;
+} sqlanywhere_stats;
+
+void init_sqlanywhere_stats(void);
+
+uint64_t sqlanywhere_stats_clock(void);
+void sqlanywhere_stats_add(sqlanywhere_stats *stats, const sqlanywhere_stats *other);
+void *rb_sqlanywhere_stats_without_gvl(
+  sqlanywhere_stats *stats,
+  uint64_t *counter,
+  void *(*func)(void *),
+  void *data1,
+  rb_unblock_function_t *ubf,
+  void *data2
+);
+VALUE rb_sqlanywhere_stats_hash(const sqlanywhere_stats *stats);
+
+#endif
@@ -0,0 +1,194 @@
+#include <sqlanywhere2.h>
+
+#ifdef HAVE_PTHREAD_H
+
+/*
+ * Single native thread shared by all connections, started on first use and again after fork
+ * Deadlines are measured on watchdog_clock, the monotonic clock where condition variables can wait on it
+ */
+static pthread_mutex_t watchdog_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t watchdog_cond;
+static clockid_t watchdog_clock = CLOCK_REALTIME;
+static sqlanywhere_deadline *watchdog_deadlines = NULL;
+static int watchdog_running = 0;
+static int watchdog_atfork = 0;
+static int watchdog_cond_ready = 0;
+
+static void sqlanywhere_watchdog_init_cond(void) {
+#if defined(HAVE_PTHREAD_CONDATTR_SETCLOCK) && defined(CLOCK_MONOTONIC)
+  pthread_condattr_t attr;
+
+  if (pthread_condattr_init(&attr) == 0) {
+    if (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0 && pthread_cond_init(&watchdog_cond, &attr) == 0) {
+      pthread_condattr_destroy(&attr);
+      watchdog_clock = CLOCK_MONOTONIC;
+      watchdog_cond_ready = 1;
+      return;
+    }
+
+    pthread_condattr_destroy(&attr);
+  }
+#endif
+
+  pthread_cond_init(&watchdog_cond, NULL);
+  watchdog_clock = CLOCK_REALTIME;
+  watchdog_cond_ready = 1;
+}
+
+static int sqlanywhere_deadline_passed(const struct timespec *at, const struct timespec *now) {
+  return now->tv_sec > at->tv_sec || (now->tv_sec == at->tv_sec && now->tv_nsec >= at->tv_nsec);
+}
+
+static void sqlanywhere_deadline_unlink(sqlanywhere_deadline *deadline) {
+  sqlanywhere_deadline **link;
+
+  for (link = &watchdog_deadlines; *link != NULL; link = &(*link)->next) {
+    if (*link == deadline) {
+      *link = deadline->next;
+      break;
+    }
+  }
+
+  deadline->armed = 0;
+  deadline->next = NULL;
+}
+
+/*
+ * Cancels requests of passed deadlines, then sleeps until the earliest remaining one or until a new one is armed
+ */
+static void *sqlanywhere_watchdog_run(void *ptr) {
+  sqlanywhere_deadline *deadline, *next;
+  struct timespec now, wake;
+  int waiting;
+
+  pthread_mutex_lock(&watchdog_mutex);
+
+  for (;;) {
+    clock_gettime(watchdog_clock, &now);
+    waiting = 0;
+
+    for (deadline = watchdog_deadlines; deadline != NULL; deadline = next) {
+      next = deadline->next;
+
+      if (sqlanywhere_deadline_passed(&deadline->at, &now)) {
+        sqlany_cancel(deadline->connection);
+        deadline->fired = 1;
+        sqlanywhere_deadline_unlink(deadline);
+      } else if (!waiting || !sqlanywhere_deadline_passed(&wake, &deadline->at)) {
+        wake = deadline->at;
+        waiting = 1;
+      }
+    }
+
+    if (waiting) {
+      pthread_cond_timedwait(&watchdog_cond, &watchdog_mutex, &wake);
+    } else {
+      pthread_cond_wait(&watchdog_cond, &watchdog_mutex);
+    }
+  }
+
+  return NULL;
+}
+
+// Watchdog thread does not exist in forked child and deadlines armed by the parent are not cancelled there
+static void sqlanywhere_watchdog_atfork_child(void) {
+  pthread_mutex_init(&watchdog_mutex, NULL);
+  sqlanywhere_watchdog_init_cond();
+  watchdog_deadlines = NULL;
+  watchdog_running = 0;
+}
+
+/*
+ * Returns 1 when armed, 0 if deadline is already armed and -1 if watchdog thread could not be started
+ */
+int sqlanywhere_deadline_arm(sqlanywhere_deadline *deadline, double timeout) {
+  pthread_t thread;
+  double seconds;
+
+  pthread_mutex_lock(&watchdog_mutex);
+
+  if (deadline->armed) {
+    pthread_mutex_unlock(&watchdog_mutex);
+    return 0;
+  }
+
+  if (!watchdog_atfork) {
+    pthread_atfork(NULL, NULL, sqlanywhere_watchdog_atfork_child);
+    watchdog_atfork = 1;
+  }
+
+  if (!watchdog_cond_ready) {
+    sqlanywhere_watchdog_init_cond();
+  }
+
+  if (!watchdog_running) {
+    if (pthread_create(&thread, NULL, sqlanywhere_watchdog_run, NULL) != 0) {
+      pthread_mutex_unlock(&watchdog_mutex);
+      return -1;
+    }
+
+    pthread_detach(thread);
+    watchdog_running = 1;
+  }
+
+  clock_gettime(watchdog_clock, &deadline->at);
+  seconds = (double)deadline->at.tv_nsec / 1e9 + timeout;
+  deadline->at.tv_sec += (time_t)seconds;
+  deadline->at.tv_nsec = (long)((seconds - (double)(time_t)seconds) * 1e9);
+
+  deadline->armed = 1;
+  deadline->fired = 0;
+  deadline->next = watchdog_deadlines;
+  watchdog_deadlines = deadline;
+
+  pthread_cond_signal(&watchdog_cond);
+  pthread_mutex_unlock(&watchdog_mutex);
+
+  return 1;
+}
+
+/*
+ * Returns 1 if deadline passed before it was disarmed
+ */
+int sqlanywhere_deadline_disarm(sqlanywhere_deadline *deadline) {
+  int fired;
+
+  pthread_mutex_lock(&watchdog_mutex);
+
+  if (deadline->armed) {
+    sqlanywhere_deadline_unlink(deadline);
+  }
+
+  fired = deadline->fired;
+  deadline->fired = 0;
+
+  pthread_mutex_unlock(&watchdog_mutex);
+
+  return fired;
+}
+
+int sqlanywhere_deadline_fired(sqlanywhere_deadline *deadline) {
+  int fired;
+
+  pthread_mutex_lock(&watchdog_mutex);
+  fired = deadline->fired;
+  pthread_mutex_unlock(&watchdog_mutex);
+
+  return fired;
+}
+
+#else
+
+int sqlanywhere_deadline_arm(sqlanywhere_deadline *deadline, double timeout) {
+  return -1;
+}
+
+int sqlanywhere_deadline_disarm(sqlanywhere_deadline *deadline) {
+  return 0;
+}
+
+int sqlanywhere_deadline_fired(sqlanywhere_deadline *deadline) {
+  return 0;
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef SQLANYWHERE_WATCHDOG_H
+#define SQLANYWHERE_WATCHDOG_H
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+/*
+ * Deadline of a connection, the watchdog thread calls sqlany_cancel once it passes
+ * Armed deadlines are linked in a list owned by the watchdog
+ */
+typedef struct sqlanywhere_deadline {
+  struct timespec at;
+  int armed;
+  int fired;
+  a_sqlany_connection *connection;
+  struct sqlanywhere_deadline *next;
+} sqlanywhere_deadline;
+
+int sqlanywhere_deadline_arm(sqlanywhere_deadline *deadline, double timeout);
+int sqlanywhere_deadline_disarm(sqlanywhere_deadline *deadline);
+int sqlanywhere_deadline_fired(sqlanywhere_deadline *deadline);
+
+#endif
@@ -6,10 +6,15 @@ require 'time'
 require 'sqlanywhere2/version' unless defined? SQLAnywhere2::VERSION
 require 'sqlanywhere2/error'
 require 'sqlanywhere2/result'
+require 'sqlanywhere2/columnar_result'
 require 'sqlanywhere2/column'
 require 'sqlanywhere2/sqlanywhere2'
 require 'sqlanywhere2/connection'
 require 'sqlanywhere2/statement'
+require 'sqlanywhere2/statement_cache'
+require 'sqlanywhere2/async_result'
+require 'sqlanywhere2/cursor'
+require 'sqlanywhere2/pool'
 
 module SQLAnywhere2
 end
@@ -0,0 +1,21 @@
+# frozen_string_literal: true
+
+require 'io/wait'
+
+module SQLAnywhere2
+  class AsyncResult
+    # Waits on the completion pipe, which lets a Fiber scheduler run other fibers meanwhile
+    def wait(timeout = nil)
+      return self if ready?
+
+      to_io.wait_readable(timeout) ? self : nil
+    end
+
+    def value
+      wait
+      _value
+    ensure
+      to_io.close if ready? && !to_io.closed?
+    end
+  end
+end
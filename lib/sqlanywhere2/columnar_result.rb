@@ -0,0 +1,103 @@
+# frozen_string_literal: true
+
+module SQLAnywhere2
+  # Result of execute(format: :columnar), values of each column are stored in a Vector instead of row arrays
+  class ColumnarResult
+    include Enumerable
+
+    attr_reader :columns, :vectors, :size
+
+    private_class_method :new # This is can only be called natively in C land
+
+    def initialize(columns, vectors, size, truncated = false)
+      @columns = columns
+      @vectors = vectors
+      @size = size
+      @truncated = truncated
+    end
+
+    # True when rows past max_rows or max_bytes were left out because of on_limit: :truncate
+    def truncated?
+      @truncated
+    end
+
+    # Returns Vector by column index or name
+    def [](key)
+      return @vectors[key] if key.is_a?(Integer)
+
+      index = @columns.index { |column| column.name == key.to_s }
+      index && @vectors[index]
+    end
+
+    def each(&block)
+      return to_enum(:each) unless block_given?
+
+      @vectors.each(&block)
+    end
+
+    def to_h
+      @columns.each_with_index.to_h { |column, index| [column.name, @vectors[index].to_a] }
+    end
+
+    # Values of a single column
+    #
+    # Numeric types are packed into +data+ in native byte order, NULL values are stored as zero.
+    # Values of :string and :binary columns are concatenated into +data+,
+    # +offsets+ holds size + 1 native 64 bit integers and value n spans from offsets[n] to offsets[n + 1].
+    # Bit n of +nulls+ (LSB first, as read by unpack('b*')) is set when value n is NULL.
+    class Vector
+      DIRECTIVES = {
+        int8: 'c', uint8: 'C', int16: 's', uint16: 'S', int32: 'l', uint32: 'L',
+        int64: 'q', uint64: 'Q', double: 'd'
+      }.freeze
+
+      attr_reader :column, :type, :data, :nulls, :offsets, :size
+
+      private_class_method :new # This is can only be called natively in C land
+
+      def initialize(column, type, data, nulls, offsets, size)
+        @column = column
+        @type = type
+        @data = data
+        @nulls = nulls
+        @offsets = offsets
+        @size = size
+      end
+
+      # Pack directive of packed values, nil for :string and :binary
+      def directive
+        DIRECTIVES[@type]
+      end
+
+      def null?(index)
+        @nulls.getbyte(index >> 3)[index & 7] == 1
+      end
+
+      def [](index)
+        return nil if index.negative? || index >= @size || null?(index)
+
+        if @offsets
+          start, finish = @offsets.unpack("@#{index * 8}Q2")
+          @data.byteslice(start, finish - start)
+        else
+          width = @data.bytesize / @size
+          @data.unpack1("@#{index * width}#{directive}")
+        end
+      end
+
+      def to_a
+        values = @offsets ? slices : @data.unpack("#{directive}*")
+
+        @nulls.unpack1('b*').each_char.with_index { |bit, index| values[index] = nil if bit == '1' && index < @size }
+
+        values
+      end
+
+      private
+
+      def slices
+        @offsets.unpack('Q*').each_cons(2).map { |start, finish| @data.byteslice(start, finish - start) }
+      end
+    end
+  end
+end
@@ -2,11 +2,16 @@
 
 module SQLAnywhere2
   class Connection
+    DECIMAL_AS = %i[bigdecimal integer_when_exact float rational].freeze
+    ON_LIMIT = %i[raise truncate].freeze
+
     # rubocop:disable Style/ClassVars
     @@initialized_pids = []
     # rubocop:enable Style/ClassVars
 
-    attr_reader :conn_string, :cast, :database_timezone, :encoding, :enable_crash_fix
+    attr_reader :conn_string, :cast, :database_timezone, :decimal_as, :encoding, :enable_crash_fix, :fetch_size,
+                :intern_strings, :intern_max_size, :lob_chunk_size, :statement_cache_size, :timeout, :max_rows,
+                :max_bytes, :on_limit
 
     def initialize(opts = {})
       raise SQLAnywhere2::Error, 'Options parameter must be a Hash' unless opts.is_a?(Hash)
@@ -19,17 +24,27 @@ module SQLAnywhere2
       @enable_crash_fix = opts[:enable_crash_fix] || false
       @database_timezone = opts[:database_timezone] || :local
       @cast = opts[:cast].nil? ? true : opts[:cast]
+      @decimal_as = opts[:decimal_as] || :bigdecimal
+      @fetch_size = opts[:fetch_size] || 1
+      @intern_strings = opts[:intern_strings] || false
+      @intern_max_size = opts[:intern_max_size]
+      @lob_chunk_size = opts[:lob_chunk_size] || 65_536
+      @statement_cache_size = opts[:statement_cache_size] || 100
+      @timeout = opts[:timeout]
+      @max_rows = opts[:max_rows]
+      @max_bytes = opts[:max_bytes]
+      @on_limit = opts[:on_limit] || :raise
       @encoding = conn_opts['CharSet'] || opts[:encoding] || Encoding.default_external.name
 
       # Check for correct encoding. This will raise ArgumentError if encoding not found
       Encoding.find(@encoding)
       conn_opts['CharSet'] = @encoding
 
-      if @database_timezone != :utc && @database_timezone != :local
-        raise SQLAnywhere2::Error, ':database_timezone option must be :utc or :local'
-      end
+      check_opts!
 
       @conn_string = build_conn_string(conn_opts)
+      @statement_cache = StatementCache.new(@statement_cache_size)
+      @prepare = method(:_prepare)
 
       initialize_process
       initialize_connection
@@ -37,19 +52,93 @@ module SQLAnywhere2
       execute_immediate('CREATE VARIABLE @@sqlawnywhere2_fix char(1)') if @enable_crash_fix
     end
 
-    def execute_immediate(sql)
+    def execute_immediate(sql, timeout: @timeout)
+      check_sql!(sql)
+      with_timeout(timeout) { _execute_immediate(sql) }
+    end
+
+    def execute_direct(sql, stream: false, as: nil, timeout: @timeout)
+      check_sql!(sql)
+      with_timeout(timeout) { _execute_direct(preprocess_sql(sql), stream, as) }
+    end
+
+    # Takes no timeout, execution outlives the call, bound it with AsyncResult#wait and AsyncResult#cancel
+    def execute_async(sql, stream: false, as: nil)
+      check_sql!(sql)
+      _execute_async(preprocess_sql(sql), stream, as)
+    end
+
+    def stream(sql, as: nil, lob: :string, timeout: @timeout, &block)
+      return enum_for(:stream, sql, as: as, lob: lob, timeout: timeout) unless block_given?
+
+      with_timeout(timeout) do
+        statement, = execute_direct(sql, stream: true, as: as, timeout: nil)
+        statement.each_row(lob: lob, timeout: nil, &block)
+      ensure
+        statement.close if statement
+      end
+    end
+
+    def prepare(sql, timeout: @timeout)
       check_sql!(sql)
-      _execute_immediate(sql)
+      with_timeout(timeout) { _prepare(preprocess_sql(sql)) }
     end
 
-    def execute_direct(sql)
+    # Executes statement prepared once per distinct SQL and kept in the statement cache
+    def execute(sql, *binds, timeout: @timeout, **opts)
       check_sql!(sql)
-      _execute_direct(preprocess_sql(sql))
+      sql = preprocess_sql(sql)
+
+      with_timeout(timeout) do
+        @statement_cache.with(sql, @prepare) do |statement|
+          statement.execute(*binds, **opts, timeout: nil)
+        end
+      end
     end
 
-    def prepare(sql)
+    # Same as execute for INSERT, UPDATE and DELETE statements, returns number of affected rows without a result
+    def execute_update(sql, *binds, timeout: @timeout)
       check_sql!(sql)
-      _prepare(preprocess_sql(sql))
+      sql = preprocess_sql(sql)
+
+      with_timeout(timeout) do
+        @statement_cache.with(sql, @prepare) { |statement| statement.execute_update(*binds, timeout: nil) }
+      end
+    end
+
+    # Cancels requests still running after +timeout+ seconds, they raise SQLAnywhere2::TimeoutError
+    # Requests started after the deadline raise as well, so does the block when it outlives the deadline
+    # Nested calls share the deadline of the outermost one
+    def with_timeout(timeout = @timeout)
+      return yield if timeout.nil? || !_arm_timeout(timeout)
+
+      begin
+        result = yield
+      ensure
+        fired = _disarm_timeout
+      end
+      raise SQLAnywhere2::TimeoutError, 'Timeout expired' if fired
+
+      result
+    end
+
+    def statement_cache_stats
+      @statement_cache.stats
+    end
+
+    attr_reader :stats_hook
+
+    # +hook+ is called with the statement and counters of every finished execution, see Statement#stats
+    def stats_hook=(hook)
+      raise SQLAnywhere2::Error, 'stats_hook must respond to call' unless hook.nil? || hook.respond_to?(:call)
+
+      @stats_hook = hook
+    end
+
+    def reset!
+      @statement_cache.clear
+      close_statements
+      rollback!
     end
 
     private
@@ -68,6 +157,64 @@ module SQLAnywhere2
       raise SQLAnywhere2::Error, 'SQL must not be empty' if sql.empty?
     end
 
+    def check_opts!
+      if @database_timezone != :utc && @database_timezone != :local
+        raise SQLAnywhere2::Error, ':database_timezone option must be :utc or :local'
+      end
+
+      unless DECIMAL_AS.include?(@decimal_as)
+        raise SQLAnywhere2::Error, ":decimal_as option must be one of #{DECIMAL_AS.map(&:inspect).join(', ')}"
+      end
+
+      check_limits!
+      check_result_limits!
+      check_intern_strings!
+    end
+
+    def check_limits!
+      unless @fetch_size.is_a?(Integer) && @fetch_size.positive?
+        raise SQLAnywhere2::Error, ':fetch_size option must be a positive Integer'
+      end
+
+      unless @lob_chunk_size.is_a?(Integer) && @lob_chunk_size.positive?
+        raise SQLAnywhere2::Error, ':lob_chunk_size option must be a positive Integer'
+      end
+
+      unless @statement_cache_size.is_a?(Integer) && @statement_cache_size >= 0
+        raise SQLAnywhere2::Error, ':statement_cache_size option must be a non-negative Integer'
+      end
+
+      return if @timeout.nil? || (@timeout.is_a?(Numeric) && @timeout.positive?)
+
+      raise SQLAnywhere2::Error, ':timeout option must be a positive Numeric'
+    end
+
+    def check_result_limits!
+      unless @max_rows.nil? || (@max_rows.is_a?(Integer) && @max_rows.positive?)
+        raise SQLAnywhere2::Error, ':max_rows option must be a positive Integer'
+      end
+
+      unless @max_bytes.nil? || (@max_bytes.is_a?(Integer) && @max_bytes.positive?)
+        raise SQLAnywhere2::Error, ':max_bytes option must be a positive Integer'
+      end
+
+      return if ON_LIMIT.include?(@on_limit)
+
+      raise SQLAnywhere2::Error, ":on_limit option must be one of #{ON_LIMIT.map(&:inspect).join(', ')}"
+    end
+
+    def check_intern_strings!
+      if @intern_strings.is_a?(Array)
+        @intern_strings = @intern_strings.map { |name| name.to_s.dup.freeze }.freeze
+      elsif @intern_strings != true && @intern_strings != false
+        raise SQLAnywhere2::Error, ':intern_strings option must be true, false or an Array of column names'
+      end
+
+      return if @intern_max_size.nil? || (@intern_max_size.is_a?(Integer) && @intern_max_size.positive?)
+
+      raise SQLAnywhere2::Error, ':intern_max_size option must be a positive Integer'
+    end
+
     def preprocess_sql(sql)
       @enable_crash_fix ? "set @@sqlawnywhere2_fix = ''; #{sql}" : sql
     end
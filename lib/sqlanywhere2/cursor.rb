@@ -0,0 +1,15 @@
+# frozen_string_literal: true
+
+module SQLAnywhere2
+  # Open cursor of Statement#open_cursor, pages are read without executing the query again
+  class Cursor
+    # Returns SQLAnywhere2::Result with up to +count+ rows starting at row +offset+, counted from 0
+    def fetch(offset:, count:, timeout: statement.connection.timeout)
+      statement.connection.with_timeout(timeout) { _fetch(offset, count) }
+    end
+
+    def columns
+      statement.columns
+    end
+  end
+end
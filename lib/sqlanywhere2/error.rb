@@ -17,4 +17,10 @@ module SQLAnywhere2
       super(msg.encode(**ENCODE_OPTS))
     end
   end
+
+  class PoolTimeoutError < Error; end
+
+  class TimeoutError < Error; end
+
+  class ResultLimitError < Error; end
 end
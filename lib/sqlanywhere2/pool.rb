@@ -0,0 +1,215 @@
+# frozen_string_literal: true
+
+module SQLAnywhere2
+  class Pool
+    POOL_OPTS = %i[size min_idle checkout_timeout ping_interval ping_timeout].freeze
+
+    attr_reader :size, :min_idle, :checkout_timeout, :ping_interval, :ping_timeout
+
+    def initialize(opts = {})
+      raise SQLAnywhere2::Error, 'Options parameter must be a Hash' unless opts.is_a?(Hash)
+
+      opts = opts.transform_keys(&:to_sym)
+
+      @size = opts.fetch(:size, 5)
+      @min_idle = opts.fetch(:min_idle, 0)
+      @checkout_timeout = opts.fetch(:checkout_timeout, 5)
+      @ping_interval = opts.fetch(:ping_interval, 30)
+      @ping_timeout = opts.fetch(:ping_timeout, 5)
+      @connection_opts = opts.reject { |key, _| POOL_OPTS.include?(key) }.freeze
+
+      check_opts!
+
+      @mutex = Mutex.new
+      @available = ConditionVariable.new
+      @shutdown = false
+      reset_state
+
+      prewarm
+    end
+
+    def with(timeout: @checkout_timeout)
+      connection = checkout(timeout: timeout)
+
+      begin
+        yield connection
+      ensure
+        checkin(connection)
+      end
+    end
+
+    def checkout(timeout: @checkout_timeout)
+      deadline = monotonic_time + timeout
+
+      loop do
+        entry = reserve(deadline)
+        connection = entry ? validate(entry) : connect
+
+        return connection if connection
+      end
+    end
+
+    def checkin(connection)
+      healthy = owned?(connection) && reset_connection(connection)
+
+      kept = @mutex.synchronize do
+        check_fork!
+        next true unless @in_use.delete(connection.object_id)
+
+        @available.signal
+        next @idle.push([connection, monotonic_time]) if healthy && !@shutdown
+
+        @total -= 1
+        false
+      end
+
+      connection.close unless kept
+
+      nil
+    end
+
+    def shutdown
+      idle = @mutex.synchronize do
+        @shutdown = true
+        @available.broadcast
+        @total -= @idle.size
+        @idle.slice!(0..)
+      end
+
+      idle.each { |connection, _| connection.close }
+
+      nil
+    end
+
+    def stats
+      @mutex.synchronize do
+        check_fork!
+        { size: @size, total: @total, idle: @idle.size, in_use: @in_use.size }
+      end
+    end
+
+    private
+
+    def check_opts!
+      raise SQLAnywhere2::Error, ':size option must be a positive Integer' unless positive_integer?(@size)
+
+      unless @min_idle.is_a?(Integer) && @min_idle >= 0 && @min_idle <= @size
+        raise SQLAnywhere2::Error, ':min_idle option must be an Integer between 0 and :size'
+      end
+
+      raise SQLAnywhere2::Error, ':checkout_timeout option must be a Numeric' unless @checkout_timeout.is_a?(Numeric)
+      raise SQLAnywhere2::Error, ':ping_interval option must be a Numeric' unless @ping_interval.is_a?(Numeric)
+
+      unless @ping_timeout.is_a?(Numeric) && @ping_timeout.positive?
+        raise SQLAnywhere2::Error, ':ping_timeout option must be a positive Numeric'
+      end
+    end
+
+    def positive_integer?(value)
+      value.is_a?(Integer) && value.positive?
+    end
+
+    def monotonic_time
+      Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    end
+
+    # Connections inherited from parent process belong to it, so they are forgotten without closing
+    def reset_state
+      @pid = Process.pid
+      @idle = []
+      @in_use = {}
+      @total = 0
+    end
+
+    def check_fork!
+      reset_state if @pid != Process.pid
+    end
+
+    def owned?(connection)
+      @pid == Process.pid && !connection.closed?
+    end
+
+    # Returns idle connection with its idle time, or nil after reserving a slot for a new connection
+    def reserve(deadline)
+      @mutex.synchronize do
+        check_fork!
+
+        loop do
+          raise SQLAnywhere2::Error, 'Pool is shut down' if @shutdown
+          return @idle.pop unless @idle.empty?
+
+          if @total < @size
+            @total += 1
+            return nil
+          end
+
+          wait_available(deadline)
+        end
+      end
+    end
+
+    def wait_available(deadline)
+      remaining = deadline - monotonic_time
+
+      if remaining <= 0
+        raise SQLAnywhere2::PoolTimeoutError, "Could not checkout connection within #{@checkout_timeout} seconds"
+      end
+
+      @available.wait(@mutex, remaining)
+    end
+
+    def connect
+      connection = Connection.new(@connection_opts)
+      track(connection)
+    rescue StandardError
+      release_slot
+      raise
+    end
+
+    # Idle connections are pinged only after ping_interval, closed ones are always discarded
+    def validate(entry)
+      connection, idle_since = entry
+
+      alive = !connection.closed? && (monotonic_time - idle_since < @ping_interval || ping(connection))
+      return track(connection) if alive
+
+      connection.close
+      release_slot
+      nil
+    end
+
+    # Server which stopped responding is cancelled after ping_timeout instead of blocking checkout
+    def ping(connection)
+      connection.with_timeout(@ping_timeout) { connection.ping }
+    rescue SQLAnywhere2::Error
+      false
+    end
+
+    def track(connection)
+      @mutex.synchronize do
+        @in_use[connection.object_id] = connection
+      end
+
+      connection
+    end
+
+    def release_slot
+      @mutex.synchronize do
+        @total -= 1
+        @available.signal
+      end
+    end
+
+    def reset_connection(connection)
+      connection.reset!
+      true
+    rescue SQLAnywhere2::Error
+      false
+    end
+
+    def prewarm
+      connections = Array.new(@min_idle) { checkout(timeout: 0) }
+      connections.each { |connection| checkin(connection) }
+    end
+  end
+end
@@ -4,13 +4,21 @@ module SQLAnywhere2
   class Result
     include Enumerable
 
-    attr_reader :columns, :rows
+    # Row shape, one of :array, :hash, :symbol_hash or :struct
+    attr_reader :columns, :rows, :as
 
     private_class_method :new # This is can only be called natively in C land
 
-    def initialize(columns, rows)
+    def initialize(columns, rows, as = :array, truncated = false)
       @columns = columns
       @rows = rows
+      @as = as
+      @truncated = truncated
+    end
+
+    # True when rows past max_rows or max_bytes were left out because of on_limit: :truncate
+    def truncated?
+      @truncated
     end
 
     def each(&block)
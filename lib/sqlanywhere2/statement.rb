@@ -3,5 +3,44 @@
 module SQLAnywhere2
   class Statement
     private_class_method :new
+
+    def execute(*binds, timeout: connection.timeout, **opts)
+      connection.with_timeout(timeout) { _execute(*binds, **opts) }
+    end
+
+    # Executes the statement and keeps its cursor open, see SQLAnywhere2::Cursor
+    def open_cursor(*binds, timeout: connection.timeout, **opts)
+      connection.with_timeout(timeout) { _open_cursor(*binds, **opts) }
+    end
+
+    # Takes no timeout, see Connection#execute_async
+    def execute_async(*binds, stream: false, as: nil)
+      _execute_async(binds, stream, as)
+    end
+
+    def execute_batch(rows, timeout: connection.timeout, **opts)
+      connection.with_timeout(timeout) { _execute_batch(rows, **opts) }
+    end
+
+    def each_row(*binds, timeout: connection.timeout, **opts, &block)
+      return enum_for(:each_row, *binds, timeout: timeout, **opts) unless block
+
+      connection.with_timeout(timeout) { _each_row(*binds, **opts, &block) }
+    end
+
+    # Writes rows to +io+ as CSV or TSV, returns number of rows written
+    def copy_out(io, *binds, timeout: connection.timeout, **opts)
+      connection.with_timeout(timeout) { _copy_out(io, *binds, **opts) }
+    end
+
+    def copy_in(io, timeout: connection.timeout, **opts)
+      connection.with_timeout(timeout) { _copy_in(io, **opts) }
+    end
+
+    def each_result_set(*binds, timeout: connection.timeout, **opts, &block)
+      return enum_for(:each_result_set, *binds, timeout: timeout, **opts) unless block
+
+      connection.with_timeout(timeout) { _each_result_set(*binds, **opts, &block) }
+    end
   end
 end
@@ -0,0 +1,80 @@
+# frozen_string_literal: true
+
+module SQLAnywhere2
+  # LRU cache of prepared statements keyed by SQL, Hash insertion order is used as recency order
+  class StatementCache
+    attr_reader :capacity, :hits, :misses, :evictions
+
+    def initialize(capacity)
+      @capacity = capacity
+      @statements = {}
+      @in_use = {}
+      @hits = 0
+      @misses = 0
+      @evictions = 0
+    end
+
+    def size
+      @statements.size
+    end
+
+    # Yields cached statement for +sql+, +prepare+ is called with +sql+ when it is missing, closed or busy
+    def with(sql, prepare)
+      statement = checkout(sql, prepare)
+      yield statement
+    ensure
+      checkin(sql, statement) if statement
+    end
+
+    def clear
+      @statements.each_value { |statement| statement.close unless busy?(statement) }
+      @statements.clear
+    end
+
+    def stats
+      { size: size, capacity: @capacity, hits: @hits, misses: @misses, evictions: @evictions }
+    end
+
+    private
+
+    def checkout(sql, prepare)
+      statement = @statements.delete(sql)
+
+      if statement && !statement.closed? && !busy?(statement)
+        @hits += 1
+      else
+        # Busy statement is left to its current user and closed on checkin
+        @misses += 1
+        statement = prepare.call(sql)
+      end
+
+      store(sql, statement) if @capacity.positive?
+      @in_use[statement.object_id] = true
+
+      statement
+    end
+
+    # Statements which are not cached are closed, unless rows are still streamed from them
+    def checkin(sql, statement)
+      @in_use.delete(statement.object_id)
+
+      return if @statements[sql].equal?(statement) || statement.streaming?
+
+      statement.close
+    end
+
+    def store(sql, statement)
+      @statements[sql] = statement
+
+      while @statements.size > @capacity
+        _, evicted = @statements.shift
+        @evictions += 1
+        evicted.close unless busy?(evicted)
+      end
+    end
+
+    def busy?(statement)
+      @in_use.key?(statement.object_id) || statement.streaming?
+    end
+  end
+end
@@ -1,6 +1,7 @@
 # frozen_string_literal: true
 
 require 'rspec'
+require 'stringio'
 require 'sqlanywhere2'
 require 'yaml'
 
@@ -0,0 +1,82 @@
+# frozen_string_literal: true
+
+require './spec/spec_helper'
+
+RSpec.describe SQLAnywhere2::AsyncResult do
+  let(:connection) { new_connection }
+
+  it 'should not allow initialization' do
+    expect { SQLAnywhere2::AsyncResult.new }.to raise_error(NoMethodError)
+  end
+
+  it 'should return same value as execute_direct' do
+    statement, result = connection.execute_async('SELECT 1 AS a').value
+
+    expect(statement).to be_an_instance_of(SQLAnywhere2::Statement)
+    expect(result.to_a).to eq([[1]])
+  end
+
+  it 'should return same value as Statement#execute' do
+    statement = connection.prepare('SELECT ? AS a')
+    async = statement.execute_async(2, as: :hash)
+
+    expect(async.value.to_a).to eq([{ 'a' => 2 }])
+    expect(async).to be_ready
+  end
+
+  it 'should run queries of different connections concurrently' do
+    connections = Array.new(3) { new_connection }
+    started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+
+    results = connections.map { |conn| conn.execute_async("WAITFOR DELAY '00:00:01'") }
+    results.each(&:value)
+
+    expect(Process.clock_gettime(Process::CLOCK_MONOTONIC) - started).to be < 2
+  end
+
+  it 'should signal completion through IO' do
+    async = connection.execute_async('SELECT 1')
+
+    expect(IO.select([async.to_io], nil, nil, 5)).not_to be_nil
+    expect(async).to be_ready
+  end
+
+  it 'should not allow using statement while it executes' do
+    statement = connection.prepare("WAITFOR DELAY '00:00:01'")
+    async = statement.execute_async
+
+    expect { statement.execute }.to raise_error(SQLAnywhere2::Error)
+    async.value
+  end
+
+  it 'should not allow using connection while it executes' do
+    async = connection.execute_async("WAITFOR DELAY '00:00:01'")
+
+    expect { connection.execute('SELECT 1') }.to raise_error(SQLAnywhere2::Error, /asynchronously/)
+    expect { connection.ping }.to raise_error(SQLAnywhere2::Error, /asynchronously/)
+    async.value
+    expect(connection.ping).to be(true)
+  end
+
+  it 'should cancel execution when connection is closed' do
+    async = connection.execute_async("WAITFOR DELAY '00:00:05'")
+    sleep 0.1
+
+    connection.close
+    expect { async.value }.to raise_error(SQLAnywhere2::Error)
+  end
+
+  it 'should cancel execution' do
+    async = connection.execute_async("WAITFOR DELAY '00:00:05'")
+    sleep 0.1
+
+    expect(async.cancel).to be(true)
+    expect { async.value }.to raise_error(SQLAnywhere2::Error)
+  end
+
+  it 'should raise execution error from value' do
+    async = connection.execute_async('SELECT * FROM missing_table')
+
+    expect { async.value }.to raise_error(SQLAnywhere2::Error)
+  end
+end
@@ -0,0 +1,52 @@
+# frozen_string_literal: true
+
+require './spec/spec_helper'
+
+RSpec.describe SQLAnywhere2::ColumnarResult do
+  let!(:connection) { new_connection }
+  let(:query) do
+    'SELECT row_num "id", CAST(row_num * 1.5 AS DOUBLE) "ratio", ' \
+      "IF MOD(row_num, 2) = 0 THEN NULL ELSE 'name ' || row_num ENDIF \"name\" FROM sa_rowgenerator(1, 3)"
+  end
+
+  it 'should not allow initialization' do
+    expect { SQLAnywhere2::ColumnarResult.new }.to raise_error(NoMethodError)
+  end
+
+  it 'should return one vector per column' do
+    result = connection.prepare(query).execute(format: :columnar)
+
+    expect(result.size).to eq(3)
+    expect(result.columns.map(&:name)).to eq(%w[id ratio name])
+    expect(result.vectors.map(&:type)).to eq(%i[uint32 double string])
+  end
+
+  it 'should pack numeric values into binary strings' do
+    result = connection.prepare(query).execute(format: :columnar)
+
+    expect(result['id'].data.unpack('L*')).to eq([1, 2, 3])
+    expect(result['ratio'].data.unpack('d*')).to eq([1.5, 3.0, 4.5])
+    expect(result['id'].data.encoding).to eq(Encoding::BINARY)
+  end
+
+  it 'should store strings with offsets and nulls in a bitmap' do
+    vector = connection.prepare(query).execute(format: :columnar)['name']
+
+    expect(vector.offsets.unpack('Q*')).to eq([0, 6, 6, 12])
+    expect(vector.nulls.unpack1('b3')).to eq('010')
+    expect(vector.to_a).to eq(['name 1', nil, 'name 3'])
+    expect(vector[2]).to eq('name 3')
+  end
+
+  it 'should be returned by Connection#execute' do
+    result = connection.execute('SELECT row_num FROM sa_rowgenerator(1, ?)', 2, format: :columnar)
+
+    expect(result.to_h).to eq({ 'row_num' => [1, 2] })
+  end
+
+  it 'should not be combined with streaming' do
+    statement = connection.prepare(query)
+
+    expect { statement.execute(format: :columnar, stream: true) }.to raise_error(SQLAnywhere2::Error)
+  end
+end
@@ -40,6 +40,21 @@ RSpec.describe SQLAnywhere2::Connection do
 
         expect(connection.database_timezone).to eq(:utc)
       end
+
+      it 'should return utc times for :utc option' do
+        _, result = new_connection(database_timezone: :utc).execute_direct('SELECT "_timestamp_" FROM sqlanywhere2_test')
+
+        expect(result.first[0]).to eq(Time.utc(1999, 1, 2, 21, 20, 53))
+        expect(result.first[0]).to be_utc
+      end
+
+      it 'should read custom timestamp_format values as utc for :utc option' do
+        connection = new_connection(database_timezone: :utc)
+        connection.execute_immediate("SET TEMPORARY OPTION timestamp_format = 'DD.MM.YYYY HH:NN:SS'")
+        _, result = connection.execute_direct('SELECT "_timestamp_" FROM sqlanywhere2_test')
+
+        expect(result.first[0]).to eq(Time.utc(1999, 1, 2, 21, 20, 53))
+      end
     end
 
     context ':cast' do
@@ -58,6 +73,114 @@ RSpec.describe SQLAnywhere2::Connection do
       end
     end
 
+    context ':decimal_as' do
+      let(:query) { 'SELECT CAST(12 AS NUMERIC(18,0)), CAST(1.1 AS NUMERIC(2,1)), CAST(12 AS NUMERIC(30,0))' }
+
+      it 'should default to :bigdecimal' do
+        _, result = new_connection.execute_direct(query)
+
+        expect(result.first).to all(be_an_instance_of(BigDecimal))
+      end
+
+      it 'should return Integer for exact values with :integer_when_exact' do
+        _, result = new_connection(decimal_as: :integer_when_exact).execute_direct(query)
+
+        expect(result.first).to eq([12, BigDecimal('1.1'), BigDecimal('12')])
+        expect(result.first[0]).to be_an_instance_of(Integer)
+        expect(result.first[2]).to be_an_instance_of(BigDecimal)
+      end
+
+      it 'should return Float with :float' do
+        _, result = new_connection(decimal_as: :float).execute_direct(query)
+
+        expect(result.first).to eq([12.0, 1.1, 12.0])
+      end
+
+      it 'should return Rational with :rational' do
+        _, result = new_connection(decimal_as: :rational).execute_direct(query)
+
+        expect(result.first).to eq([12r, 11/10r, 12r])
+      end
+
+      it 'should raise error for unknown option' do
+        expect { new_connection(decimal_as: :test) }.to raise_error(SQLAnywhere2::Error)
+      end
+    end
+
+    context ':intern_strings' do
+      let(:query) { 'SELECT \'NEW\' "status", CAST(\'text\' AS VARCHAR(100)) "text" FROM sa_rowgenerator(1, 2)' }
+
+      it 'should return frozen shared strings' do
+        _, result = new_connection(intern_strings: true).execute_direct(query)
+
+        expect(result.rows[0][0]).to be_frozen
+        expect(result.rows[0][0]).to equal(result.rows[1][0])
+      end
+
+      it 'should only intern listed columns' do
+        _, result = new_connection(intern_strings: [:status]).execute_direct(query)
+
+        expect(result.rows[0][0]).to be_frozen
+        expect(result.rows[0][1]).not_to be_frozen
+      end
+
+      it 'should not intern columns longer than :intern_max_size' do
+        _, result = new_connection(intern_strings: true, intern_max_size: 10).execute_direct(query)
+
+        expect(result.rows[0][0]).to be_frozen
+        expect(result.rows[0][1]).not_to be_frozen
+      end
+
+      it 'should raise error for invalid option' do
+        expect { new_connection(intern_strings: 'status') }.to raise_error(SQLAnywhere2::Error)
+      end
+    end
+
+    context ':timeout' do
+      it 'should raise error when :timeout is not positive' do
+        expect { new_connection(timeout: 0) }.to raise_error(SQLAnywhere2::Error)
+      end
+
+      it 'should cancel queries running longer than :timeout' do
+        connection = new_connection(timeout: 0.2)
+
+        query = "WAITFOR DELAY '00:00:05'"
+
+        expect { connection.execute_immediate(query) }.to raise_error(SQLAnywhere2::TimeoutError)
+      end
+
+      it 'should allow overriding :timeout per call' do
+        connection = new_connection(timeout: 0.2)
+
+        expect { connection.execute_immediate("WAITFOR DELAY '00:00:01'", timeout: nil) }.not_to raise_error
+      end
+    end
+
+    context ':max_rows and :max_bytes' do
+      let(:query) { 'SELECT row_num FROM sa_rowgenerator(1, 10)' }
+
+      it 'should raise error for invalid options' do
+        expect { new_connection(max_rows: 0) }.to raise_error(SQLAnywhere2::Error)
+        expect { new_connection(max_bytes: '1M') }.to raise_error(SQLAnywhere2::Error)
+        expect { new_connection(on_limit: :warn) }.to raise_error(SQLAnywhere2::Error)
+      end
+
+      it 'should limit results of all statements' do
+        connection = new_connection(max_rows: 5)
+
+        expect { connection.execute_direct(query) }.to raise_error(SQLAnywhere2::ResultLimitError)
+        expect(connection.execute(query, max_rows: nil).rows.size).to eq(10)
+      end
+
+      it 'should truncate results with :on_limit :truncate' do
+        connection = new_connection(max_rows: 5, on_limit: :truncate)
+        result = connection.execute(query)
+
+        expect(result.rows).to eq((1..5).map { |i| [i] })
+        expect(result).to be_truncated
+      end
+    end
+
     context ':enable_crash_fix' do
       let(:connection) { new_connection(enable_crash_fix: true) }
 
@@ -111,6 +234,13 @@ RSpec.describe SQLAnywhere2::Connection do
       expect(result).to be_an_instance_of(SQLAnywhere2::Result)
     end
 
+    it 'should not fetch result when streaming' do
+      statement, result = connection.execute_direct('SELECT id FROM sqlanywhere2_test', stream: true)
+
+      expect(result).to be_nil
+      expect(statement.each_row.to_a).to eq([[0]])
+    end
+
     it 'should raise an error if sql is empty' do
       expect { connection.execute_direct('') }.to raise_error(SQLAnywhere2::Error)
     end
@@ -120,6 +250,22 @@ RSpec.describe SQLAnywhere2::Connection do
     end
   end
 
+  context '#stream' do
+    let(:connection) { new_connection }
+
+    it 'should yield rows' do
+      rows = []
+
+      connection.stream('SELECT row_num FROM sa_rowgenerator(1, 3)') { |row| rows.push(row) }
+
+      expect(rows).to eq([[1], [2], [3]])
+    end
+
+    it 'should return an enumerator without a block' do
+      expect(connection.stream('SELECT id FROM sqlanywhere2_test').to_a).to eq([[0]])
+    end
+  end
+
   context '#prepare' do
     let(:connection) { new_connection }
 
@@ -138,6 +284,145 @@ RSpec.describe SQLAnywhere2::Connection do
     end
   end
 
+  context '#execute' do
+    let(:connection) { new_connection(statement_cache_size: 2) }
+
+    it 'should reuse prepared statements' do
+      3.times { expect(connection.execute('SELECT ?', 1).first[0]).to eq(1) }
+
+      expect(connection.statement_cache_stats).to include(size: 1, hits: 2, misses: 1)
+    end
+
+    it 'should evict least recently used statements' do
+      connection.execute('SELECT 1')
+      connection.execute('SELECT 2')
+      connection.execute('SELECT 1')
+      connection.execute('SELECT 3')
+      connection.execute('SELECT 1')
+
+      expect(connection.statement_cache_stats).to include(size: 2, hits: 2, misses: 3, evictions: 1)
+    end
+
+    it 'should not reuse statement which is still streaming' do
+      statement = connection.execute('SELECT 1', stream: true)
+
+      expect(connection.execute('SELECT 1').first[0]).to eq(1)
+      expect(statement.each_row.to_a).to eq([[1]])
+    end
+
+    it 'should prepare again after cached statement was closed' do
+      connection.execute('SELECT 1')
+      connection.close_statements
+
+      expect(connection.execute('SELECT 1').first[0]).to eq(1)
+      expect(connection.statement_cache_stats).to include(misses: 2)
+    end
+
+    it 'should not cache statements when :statement_cache_size is 0' do
+      connection = new_connection(statement_cache_size: 0)
+
+      expect(connection.execute('SELECT 1').first[0]).to eq(1)
+      expect(connection.statement_cache_stats).to include(size: 0, misses: 1)
+    end
+  end
+
+  context '#execute_update' do
+    let(:connection) { new_connection }
+
+    it 'should return affected rows and reuse prepared statements' do
+      sql = 'INSERT INTO sqlanywhere2_test(id, "_bounded_string_") VALUES(?, ?)'
+
+      expect(connection.execute_update(sql, 1, 'a')).to eq(1)
+      expect(connection.execute_update(sql, 2, 'b')).to eq(1)
+      expect(connection.execute_update('DELETE FROM sqlanywhere2_test WHERE id > ?', 0)).to eq(2)
+      expect(connection.statement_cache_stats).to include(hits: 1, misses: 2)
+    end
+  end
+
+  context '#with_timeout' do
+    let(:connection) { new_connection }
+
+    it 'should cancel statement execution' do
+      statement = connection.prepare("WAITFOR DELAY '00:00:05'")
+
+      expect { statement.execute(timeout: 0.2) }.to raise_error(SQLAnywhere2::TimeoutError)
+    end
+
+    it 'should share deadline between calls in block' do
+      expect do
+        connection.with_timeout(0.5) do
+          connection.execute_immediate("WAITFOR DELAY '00:00:00.300'")
+          connection.execute_immediate("WAITFOR DELAY '00:00:00.300'")
+        end
+      end.to raise_error(SQLAnywhere2::TimeoutError)
+    end
+
+    it 'should refuse requests started after the deadline' do
+      executed = 0
+
+      expect do
+        connection.with_timeout(0.5) do
+          loop do
+            connection.execute('SELECT 1')
+            executed += 1
+          end
+        end
+      end.to raise_error(SQLAnywhere2::TimeoutError)
+      expect(executed).to be > 0
+
+      expect do
+        connection.with_timeout(0.2) do
+          sleep 0.3
+          connection.execute_immediate('SELECT 1')
+        end
+      end.to raise_error(SQLAnywhere2::TimeoutError, 'Timeout expired')
+    end
+
+    it 'should raise when block returns after the deadline' do
+      expect { connection.with_timeout(0.2) { sleep 0.3 } }.to raise_error(SQLAnywhere2::TimeoutError)
+    end
+
+    it 'should leave connection usable after timeout' do
+      query = "WAITFOR DELAY '00:00:05'"
+
+      expect { connection.execute_direct(query, timeout: 0.2) }.to raise_error(SQLAnywhere2::TimeoutError)
+
+      _, result = connection.execute_direct('SELECT 1')
+      expect(result.first[0]).to eq(1)
+    end
+  end
+
+  context '#stats' do
+    let(:connection) { new_connection }
+
+    it 'should count finished executions' do
+      connection.prepare('SELECT row_num FROM sa_rowgenerator(1, ?)').execute(10)
+
+      stats = connection.stats
+
+      expect(stats[:executions]).to eq(1)
+      expect(stats[:rows]).to eq(10)
+      expect(stats[:prepare_ns]).to be > 0
+      expect(stats[:execute_ns]).to be > 0
+    end
+
+    it 'should pass stats of every finished execution to stats_hook' do
+      events = []
+      connection.stats_hook = ->(statement, stats) { events << [statement, stats] }
+
+      statement = connection.prepare('SELECT row_num FROM sa_rowgenerator(1, 3)')
+      statement.execute
+      statement.each_row.to_a
+
+      expect(events.map(&:first)).to eq([statement, statement])
+      expect(events.map { |_, stats| stats[:rows] }).to eq([3, 3])
+    end
+
+    it 'should raise an error when stats_hook is not callable' do
+      expect { connection.stats_hook = 1 }.to raise_error(SQLAnywhere2::Error)
+    end
+  end
+
   context '#commit' do
     let(:connection) { new_connection }
 
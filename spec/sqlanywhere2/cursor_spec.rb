@@ -0,0 +1,60 @@
+# frozen_string_literal: true
+
+require './spec/spec_helper'
+
+RSpec.describe SQLAnywhere2::Cursor do
+  let!(:connection) { new_connection }
+  let(:statement) { connection.prepare('SELECT row_num FROM sa_rowgenerator(1, 100) ORDER BY row_num DESC') }
+
+  it 'should not allow initialization' do
+    expect { SQLAnywhere2::Cursor.new }.to raise_error(NoMethodError)
+  end
+
+  it 'should fetch pages at any offset without executing again' do
+    cursor = statement.open_cursor
+
+    expect(cursor.fetch(offset: 0, count: 3).rows).to eq([[100], [99], [98]])
+    expect(cursor.fetch(offset: 50, count: 2).rows).to eq([[50], [49]])
+    expect(cursor.fetch(offset: 10, count: 1).rows).to eq([[90]])
+    expect(statement.stats[:executions]).to eq(1)
+  end
+
+  it 'should return short pages at the end of results' do
+    cursor = statement.open_cursor
+
+    expect(cursor.fetch(offset: 98, count: 5).rows).to eq([[2], [1]])
+    expect(cursor.fetch(offset: 100, count: 5).rows).to eq([])
+  end
+
+  it 'should return rows in shape given with as:' do
+    cursor = statement.open_cursor(as: :hash)
+    result = cursor.fetch(offset: 0, count: 1)
+
+    expect(result.as).to eq(:hash)
+    expect(result.rows).to eq([{ 'row_num' => 100 }])
+  end
+
+  it 'should return rows estimate' do
+    expect(statement.open_cursor.rows_estimate).to be_positive
+  end
+
+  it 'should raise an error for invalid offset or count' do
+    cursor = statement.open_cursor
+
+    expect { cursor.fetch(offset: -1, count: 1) }.to raise_error(ArgumentError)
+    expect { cursor.fetch(offset: 0, count: 0) }.to raise_error(ArgumentError)
+  end
+
+  it 'should be closed by close and by executing the statement again' do
+    cursor = statement.open_cursor
+    cursor.close
+
+    expect(cursor).to be_closed
+    expect { cursor.fetch(offset: 0, count: 1) }.to raise_error(SQLAnywhere2::Error)
+
+    cursor = statement.open_cursor
+    statement.execute
+
+    expect(cursor).to be_closed
+  end
+end
@@ -0,0 +1,47 @@
+# frozen_string_literal: true
+
+require './spec/spec_helper'
+
+RSpec.describe SQLAnywhere2::LobReader do
+  let!(:connection) { new_connection(lob_chunk_size: 4) }
+  let(:query) { "SELECT CAST(REPEAT('abc', 5) AS LONG BINARY), CAST(NULL AS LONG VARCHAR), 1" }
+
+  it 'should not allow initialization' do
+    expect { SQLAnywhere2::LobReader.new }.to raise_error(NoMethodError)
+  end
+
+  it 'should be yielded for LOB columns with lob: :stream' do
+    connection.stream(query, lob: :stream) do |row|
+      expect(row[0]).to be_an_instance_of(SQLAnywhere2::LobReader)
+      expect(row[1]).to be_nil
+      expect(row[2]).to eq(1)
+    end
+  end
+
+  it 'should read value in parts' do
+    connection.stream(query, lob: :stream) do |row|
+      lob = row[0]
+
+      expect(lob.size).to eq(15)
+      expect(lob.read(4)).to eq('abca')
+      expect(lob.pos).to eq(4)
+      expect(lob.read).to eq('bcabcabcabc')
+      expect(lob.read(4)).to be_nil
+      expect(lob).to be_eof
+    end
+  end
+
+  it 'should yield chunks of lob_chunk_size' do
+    connection.stream(query, lob: :stream) do |row|
+      expect(row[0].each_chunk.map(&:bytesize)).to eq([4, 4, 4, 3])
+    end
+  end
+
+  it 'should raise an error when read after its row' do
+    lob = nil
+
+    connection.stream(query, lob: :stream) { |row| lob = row[0] }
+
+    expect { lob.read }.to raise_error(SQLAnywhere2::Error)
+  end
+end
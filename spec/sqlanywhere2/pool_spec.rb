@@ -0,0 +1,82 @@
+# frozen_string_literal: true
+
+require './spec/spec_helper'
+
+RSpec.describe SQLAnywhere2::Pool do
+  let(:pool) { SQLAnywhere2::Pool.new(DatabaseCredentials['root'].merge(size: 2, checkout_timeout: 0.1)) }
+
+  after { pool.shutdown }
+
+  it 'should validate options' do
+    credentials = DatabaseCredentials['root']
+
+    expect { SQLAnywhere2::Pool.new(credentials.merge(size: 0)) }.to raise_error(SQLAnywhere2::Error)
+    expect { SQLAnywhere2::Pool.new(credentials.merge(min_idle: 6)) }.to raise_error(SQLAnywhere2::Error)
+    expect { SQLAnywhere2::Pool.new(credentials.merge(ping_timeout: 0)) }.to raise_error(SQLAnywhere2::Error)
+  end
+
+  it 'should open min_idle connections' do
+    pool = SQLAnywhere2::Pool.new(DatabaseCredentials['root'].merge(min_idle: 2))
+
+    expect(pool.stats).to include(total: 2, idle: 2)
+    pool.shutdown
+  end
+
+  it 'should reuse connections' do
+    first = pool.with { |connection| connection }
+    second = pool.with { |connection| connection }
+
+    expect(second).to equal(first)
+  end
+
+  it 'should ping idle connections under ping_timeout' do
+    pool = SQLAnywhere2::Pool.new(DatabaseCredentials['root'].merge(size: 1, ping_interval: 0, ping_timeout: 1))
+    first = pool.with { |connection| connection }
+
+    expect(first).to receive(:with_timeout).with(1).and_call_original
+    expect(pool.with { |connection| connection }).to equal(first)
+    pool.shutdown
+  end
+
+  it 'should raise error when no connection is available in time' do
+    pool.checkout
+    pool.checkout
+
+    expect { pool.checkout }.to raise_error(SQLAnywhere2::PoolTimeoutError)
+  end
+
+  it 'should close statements and rollback on checkin' do
+    statement = pool.with do |connection|
+      connection.execute_immediate('INSERT INTO sqlanywhere2_test(id) VALUES(1)')
+      connection.prepare('SELECT 1')
+    end
+
+    expect { statement.execute }.to raise_error(SQLAnywhere2::Error)
+    pool.with do |connection|
+      _, result = connection.execute_direct('SELECT COUNT(*) FROM sqlanywhere2_test WHERE id = 1')
+      expect(result.first[0]).to eq(0)
+    end
+  end
+
+  it 'should discard closed connections' do
+    closed = pool.with(&:close)
+
+    expect(pool.with { |connection| connection }).not_to equal(closed)
+  end
+
+  it 'should not reuse connections after fork' do
+    connection = pool.with { |conn| conn }
+
+    reader, writer = IO.pipe
+    pid = fork do
+      pool.with { |conn| writer.write(conn.equal?(connection) ? 'reused' : 'new') }
+      writer.write(connection.closed? ? ' closed' : ' open')
+      exit!(0)
+    end
+    writer.close
+    Process.wait(pid)
+
+    expect(reader.read).to eq('new closed')
+    expect(connection.ping).to be(true)
+  end
+end
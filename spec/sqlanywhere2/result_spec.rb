@@ -26,6 +26,44 @@ RSpec.describe SQLAnywhere2::Result do
     end
   end
 
+  context 'as:' do
+    let(:query) { 'SELECT row_num "id", \'name\' "name" FROM sa_rowgenerator(1, 2)' }
+
+    it 'should default to :array' do
+      _, result = connection.execute_direct(query)
+
+      expect(result.as).to eq(:array)
+    end
+
+    it 'should return hashes with shared frozen keys for :hash' do
+      _, result = connection.execute_direct(query, as: :hash)
+
+      expect(result.as).to eq(:hash)
+      expect(result.rows).to eq([{ 'id' => 1, 'name' => 'name' }, { 'id' => 2, 'name' => 'name' }])
+      expect(result.rows[0].keys.first).to be_frozen
+      expect(result.rows[0].keys.first).to equal(result.rows[1].keys.first)
+    end
+
+    it 'should return hashes with symbol keys for :symbol_hash' do
+      _, result = connection.execute_direct(query, as: :symbol_hash)
+
+      expect(result.rows.first).to eq({ id: 1, name: 'name' })
+    end
+
+    it 'should return structs of one class for :struct' do
+      _, result = connection.execute_direct(query, as: :struct)
+      _, other_result = connection.execute_direct(query, as: :struct)
+
+      expect(result.rows.first.id).to eq(1)
+      expect(result.rows.first.name).to eq('name')
+      expect(result.rows.first.class).to equal(other_result.rows.first.class)
+    end
+
+    it 'should raise an error for unknown shape' do
+      expect { connection.execute_direct(query, as: :set) }.to raise_error(SQLAnywhere2::Error)
+    end
+  end
+
   context '#columns' do
     it 'should return an array of columns in proper order' do
       _, result = connection.execute_direct('SELECT 1 "a", 2 "b", 3 "c"')
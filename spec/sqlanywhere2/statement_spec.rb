@@ -57,6 +57,48 @@ RSpec.describe SQLAnywhere2::Statement do
       expect(statement.execute).to be_an_instance_of(SQLAnywhere2::Result)
     end
 
+    it 'should return rows in shape given with as: for this execution only' do
+      statement = connection.prepare('SELECT 1 "a"')
+
+      expect(statement.execute(as: :hash).rows).to eq([{ 'a' => 1 }])
+      expect(statement.execute.rows).to eq([[1]])
+    end
+
+    it 'should return all rows of results larger than a fetch chunk in order' do
+      statement = connection.prepare('SELECT row_num, REPEAT(\'x\', MOD(row_num, 50)) FROM sa_rowgenerator(1, 2000)')
+
+      expect(statement.execute.rows).to eq((1..2000).map { |i| [i, 'x' * (i % 50)] })
+    end
+
+    context 'result limits' do
+      let(:statement) { connection.prepare("SELECT row_num, REPEAT('x', 10) FROM sa_rowgenerator(1, 10)") }
+
+      it 'should raise SQLAnywhere2::ResultLimitError for results over max_rows:' do
+        expect(statement.execute(max_rows: 10).rows.size).to eq(10)
+        expect { statement.execute(max_rows: 9) }.to raise_error(SQLAnywhere2::ResultLimitError)
+      end
+
+      it 'should truncate results over max_bytes: with on_limit: :truncate' do
+        result = statement.execute(max_bytes: 50, on_limit: :truncate)
+
+        expect(result.rows).to eq((1..3).map { |i| [i, 'x' * 10] })
+        expect(result).to be_truncated
+      end
+
+      it 'should truncate columnar results' do
+        result = statement.execute(format: :columnar, max_rows: 4, on_limit: :truncate)
+
+        expect(result.size).to eq(4)
+        expect(result).to be_truncated
+      end
+
+      it 'should apply limits to this execution only' do
+        statement.execute(max_rows: 2, on_limit: :truncate)
+
+        expect(statement.execute).not_to be_truncated
+      end
+    end
+
     it 'should return an error when number of bound params is different from execution params' do
       statement = connection.prepare('SELECT TOP ? 1')
       expect { statement.execute }.to raise_error(SQLAnywhere2::Error)
@@ -91,6 +133,18 @@ RSpec.describe SQLAnywhere2::Statement do
       expect(first_row[22]).to be_within(1e+38).of(real_test_val)
     end
 
+    it 'should retrieve fractional seconds' do
+      statement = connection.prepare("SELECT CAST('1999-01-02 21:20:53.123456' AS TIMESTAMP)")
+
+      expect(statement.execute.first[0]).to eq(Time.new(1999, 1, 2, 21, 20, Rational(53_123_456, 1_000_000)))
+    end
+
+    it 'should retrieve TIME on 2000-01-01' do
+      statement = connection.prepare("SELECT CAST('21:20:53' AS TIME)")
+
+      expect(statement.execute.first[0]).to eq(Time.new(2000, 1, 1, 21, 20, 53))
+    end
+
     context 'bind types' do
       it 'should bind BINARY correctly' do
         statement = connection.prepare('SELECT CAST(? AS BINARY)')
@@ -107,6 +161,18 @@ RSpec.describe SQLAnywhere2::Statement do
         expect(result.first[0].unpack('c*')).to eq(binary_test_val)
       end
 
+      it 'should bind IO to LONG BINARY in chunks' do
+        data = (0..255).to_a.pack('C*') * 10
+        statement = new_connection(lob_chunk_size: 100).prepare(
+          'INSERT INTO sqlanywhere2_test(id, "_unbounded_binary_") VALUES(1, ?)'
+        )
+
+        statement.execute(StringIO.new(data))
+        _, result = connection.execute_direct('SELECT "_unbounded_binary_" FROM sqlanywhere2_test WHERE id = 1')
+
+        expect(result.first[0]).to eq(data)
+      end
+
       it 'should bind NUMERIC correctly' do
         statement = connection.prepare('SELECT CAST(? AS NUMERIC(2,1))')
 
@@ -253,6 +319,15 @@ RSpec.describe SQLAnywhere2::Statement do
         expect(result.first[0]).to be_within(1e+38).of(real_test_val)
       end
 
+      it 'should bind values of different size on each execution' do
+        statement = connection.prepare('SELECT CAST(? AS LONG VARCHAR) S')
+
+        expect(statement.execute('a').first[0]).to eq('a')
+        expect(statement.execute('b' * 1000).first[0]).to eq('b' * 1000)
+        expect(statement.execute(nil).first[0]).to be_nil
+        expect(statement.execute('c').first[0]).to eq('c')
+      end
+
       it 'should bind NIL correctly' do
         val = nil
         statement = connection.prepare('SELECT ? S')
@@ -261,8 +336,43 @@ RSpec.describe SQLAnywhere2::Statement do
         expect(result.first[0]).to eq(val)
       end
 
+      it 'should bind Date natively' do
+        statement = connection.prepare('SELECT CAST(? AS DATE)')
+
+        expect(statement.execute(date_test_val).first[0]).to eq(date_test_val)
+      end
+
+      it 'should bind Time natively' do
+        statement = connection.prepare('SELECT CAST(? AS TIMESTAMP)')
+
+        expect(statement.execute(datetime_test_val).first[0]).to eq(datetime_test_val)
+        expect(statement.execute(datetime_test_val.to_datetime).first[0]).to eq(datetime_test_val)
+      end
+
+      it 'should bind BigDecimal without losing precision' do
+        val = BigDecimal('-12345678901234567890.0123456789')
+        statement = connection.prepare('SELECT CAST(? AS DECIMAL(30,10))')
+
+        expect(statement.execute(val).first[0]).to eq(val)
+      end
+
+      it 'should bind true, false and Symbol' do
+        statement = connection.prepare('SELECT CAST(? AS BIT), CAST(? AS BIT), CAST(? AS VARCHAR(10))')
+
+        expect(statement.execute(true, false, :abc).first).to eq([true, false, 'abc'])
+      end
+
+      it 'should bind values of different types on each execution' do
+        statement = connection.prepare('SELECT CAST(? AS VARCHAR(30)) S')
+
+        expect(statement.execute(1).first[0]).to eq('1')
+        expect(statement.execute(:b).first[0]).to eq('b')
+        expect(statement.execute(date_test_val).first[0]).to eq('1999-01-02')
+        expect(statement.execute(2**70).first[0]).to eq((2**70).to_s)
+      end
+
       it 'should raise error if type is not supported' do
-        val = Time.now
+        val = Object.new
         statement = connection.prepare('SELECT ? S')
 
         expect { statement.execute(val) }.to raise_error(TypeError)
@@ -270,6 +380,278 @@ RSpec.describe SQLAnywhere2::Statement do
     end
   end
 
+  context '#execute_update' do
+    it 'should return number of affected rows without a result' do
+      statement = connection.prepare('UPDATE sqlanywhere2_test SET "_bounded_string_" = ? WHERE id >= ?')
+
+      expect(statement.execute_update('updated', 0)).to eq(1)
+      expect(statement.execute_update('updated', 1)).to eq(0)
+      expect(statement.last_result).to be_nil
+      expect(statement.stats).to include(executions: 2)
+    end
+
+    it 'should raise TimeoutError after :timeout seconds' do
+      statement = connection.prepare("WAITFOR DELAY '00:00:05'")
+
+      expect { statement.execute_update(timeout: 0.5) }.to raise_error(SQLAnywhere2::TimeoutError)
+    end
+
+    it 'should leave statement usable after failed execution' do
+      statement = connection.prepare('INSERT INTO sqlanywhere2_test(id) VALUES(?)')
+
+      expect(statement.execute_update(1)).to eq(1)
+      expect { statement.execute_update(1) }.to raise_error(SQLAnywhere2::Error)
+      expect(statement.execute_update(2)).to eq(1)
+      expect(statement.stats).to include(executions: 3)
+    end
+  end
+
+  context '#execute_batch' do
+    it 'should insert all rows and return affected rows per batch' do
+      statement = connection.prepare('INSERT INTO sqlanywhere2_test(id, "_bounded_string_", "_double_") VALUES(?, ?, ?)')
+      rows = (1..5).map { |i| [i, i.even? ? "row #{i}" : nil, i * 1.5] }
+
+      expect(statement.execute_batch(rows, batch_size: 2)).to eq([2, 2, 1])
+
+      _, result = connection.execute_direct('SELECT id, "_bounded_string_", "_double_" FROM sqlanywhere2_test WHERE id > 0')
+      expect(result.rows).to eq(rows)
+    end
+
+    it 'should insert Date, Time, BigDecimal and boolean values' do
+      statement = connection.prepare(
+        'INSERT INTO sqlanywhere2_test(id, "_date_", "_timestamp_", "_decimal_", "_bit_") VALUES(?, ?, ?, ?, ?)'
+      )
+      rows = [
+        [1, date_test_val, datetime_test_val, BigDecimal('1.5'), true],
+        [2, nil, datetime_test_val.to_datetime, nil, false]
+      ]
+
+      statement.execute_batch(rows)
+
+      _, result = connection.execute_direct(
+        'SELECT id, "_date_", "_timestamp_", "_decimal_", "_bit_" FROM sqlanywhere2_test WHERE id > 0 ORDER BY id'
+      )
+      expect(result.rows).to eq(rows.map { |row| [row[0], row[1], datetime_test_val, row[3], row[4]] })
+    end
+
+    it 'should send a large value in a smaller batch' do
+      statement = connection.prepare('INSERT INTO sqlanywhere2_test(id, "_unbounded_string_") VALUES(?, ?)')
+      large = 'x' * 10_000_000
+      rows = (1..10).map { |i| [i, i == 5 ? large : "row #{i}"] }
+
+      expect(statement.execute_batch(rows, batch_size: 10)).to eq([4, 1, 5])
+
+      _, result = connection.execute_direct('SELECT LENGTH("_unbounded_string_") FROM sqlanywhere2_test WHERE id = 5')
+      expect(result.first[0]).to eq(large.size)
+    end
+
+    it 'should raise an error when row size is different from number of params' do
+      statement = connection.prepare('INSERT INTO sqlanywhere2_test(id) VALUES(?)')
+
+      expect { statement.execute_batch([[1, 2]]) }.to raise_error(SQLAnywhere2::Error)
+    end
+
+    it 'should allow single row execution afterwards' do
+      statement = connection.prepare('INSERT INTO sqlanywhere2_test(id) VALUES(?)')
+
+      statement.execute_batch([[1], [2], [3]])
+      statement.execute(4)
+
+      expect(statement.affected_rows).to eq(1)
+    end
+  end
+
+  context '#fetch_size' do
+    it 'should default to connection fetch_size' do
+      statement = new_connection(fetch_size: 10).prepare('SELECT 1')
+
+      expect(statement.fetch_size).to eq(10)
+    end
+
+    it 'should return the same rows as single row fetching' do
+      query = 'SELECT row_num, CAST(row_num AS VARCHAR(10)), IF MOD(row_num, 3) = 0 THEN NULL ENDIF FROM sa_rowgenerator(1, 25)'
+      statement = connection.prepare(query)
+      _, expected = connection.execute_direct(query)
+
+      statement.fetch_size = 10
+
+      expect(statement.execute.rows).to eq(expected.rows)
+      expect(statement.each_row.to_a).to eq(expected.rows)
+    end
+
+    it 'should raise an error when fetch_size is not positive' do
+      statement = connection.prepare('SELECT 1')
+
+      expect { statement.fetch_size = 0 }.to raise_error(ArgumentError)
+    end
+  end
+
+  context '#each_row' do
+    it 'should yield rows one at a time' do
+      statement = connection.prepare('SELECT row_num FROM sa_rowgenerator(1, 3)')
+      rows = []
+
+      statement.each_row { |row| rows.push(row) }
+
+      expect(rows).to eq([[1], [2], [3]])
+    end
+
+    it 'should bind params' do
+      statement = connection.prepare('SELECT row_num FROM sa_rowgenerator(1, ?)')
+
+      expect(statement.each_row(2).to_a).to eq([[1], [2]])
+    end
+
+    it 'should yield rows in requested shape' do
+      statement = connection.prepare('SELECT row_num FROM sa_rowgenerator(1, ?)')
+
+      expect(statement.each_row(2, as: :symbol_hash).to_a).to eq([{ row_num: 1 }, { row_num: 2 }])
+    end
+
+    it 'should allow to stop iteration early' do
+      statement = connection.prepare('SELECT row_num FROM sa_rowgenerator(1, 100)')
+
+      statement.each_row { |row| break if row[0] == 2 }
+
+      expect(statement.execute.count).to eq(100)
+    end
+
+    it 'should read rows from a streamed execution' do
+      statement = connection.prepare('SELECT row_num FROM sa_rowgenerator(1, 2)')
+
+      expect(statement.execute(stream: true)).to eq(statement)
+      expect(statement.last_result).to be_nil
+      expect(statement.each_row.to_a).to eq([[1], [2]])
+    end
+  end
+
+  context '#each_result_set' do
+    let(:sql) { "BEGIN SELECT row_num FROM sa_rowgenerator(1, 2); SELECT 'x' AS b, 3 AS c; END" }
+
+    it 'should yield every result set with its own columns' do
+      statement = connection.prepare(sql)
+      sets = []
+
+      statement.each_result_set do |current|
+        sets.push([current.columns.map(&:name), current.each_row.to_a])
+      end
+
+      expect(sets).to eq([[['row_num'], [[1], [2]]], [%w[b c], [['x', 3]]]])
+      expect(statement.streaming?).to be false
+    end
+
+    it 'should describe result sets with the same number of columns again' do
+      statement = connection.prepare("BEGIN SELECT 1 AS a; SELECT 'x' AS b; END")
+      sets = []
+
+      statement.each_result_set do |current|
+        sets.push([current.columns.map(&:name), current.each_row.to_a])
+      end
+
+      expect(sets).to eq([[['a'], [[1]]], [['b'], [['x']]]])
+    end
+
+    it 'should skip rest of a result set with next_result' do
+      statement = connection.prepare(sql)
+      rows = []
+
+      statement.each_result_set(as: :symbol_hash) do |current|
+        rows.push(current.each_row.first)
+        current.next_result
+      end
+
+      expect(rows).to eq([{ row_num: 1 }, { b: 'x', c: 3 }])
+    end
+
+    it 'should advance a streamed execution with next_result' do
+      statement = connection.prepare(sql)
+      statement.execute(stream: true)
+
+      expect(statement.next_result).to be true
+      expect(statement.each_row.to_a).to eq([['x', 3]])
+      expect(statement.next_result).to be false
+    end
+  end
+
+  context '#copy_out' do
+    let(:query) do
+      "SELECT row_num \"id\", IF row_num = 2 THEN NULL ELSE 'a,\"b\"' ENDIF \"name\", '' \"empty\" " \
+        'FROM sa_rowgenerator(1, ?)'
+    end
+
+    it 'should write rows as CSV and return row count' do
+      io = StringIO.new
+
+      expect(connection.prepare(query).copy_out(io, 2, headers: true)).to eq(2)
+      expect(io.string).to eq(%(id,name,empty\n1,"a,""b""",""\n2,,""\n))
+    end
+
+    it 'should write rows as TSV' do
+      io = StringIO.new
+
+      connection.prepare(query).copy_out(io, 2, format: :tsv)
+
+      expect(io.string).to eq(%(1\ta,"b"\t\n2\t\\N\t\n))
+    end
+
+    it 'should use given NULL representation' do
+      io = StringIO.new
+
+      connection.prepare(query).copy_out(io, 2, null: 'NULL')
+
+      expect(io.string.lines[1]).to eq(%(2,NULL,""\n))
+    end
+
+    it 'should raise error for unknown format' do
+      expect { connection.prepare(query).copy_out(StringIO.new, 1, format: :json) }.to raise_error(SQLAnywhere2::Error)
+    end
+  end
+
+  context '#copy_in' do
+    let(:statement) do
+      connection.prepare('INSERT INTO sqlanywhere2_test(id, "_bounded_string_", "_double_") VALUES(?, ?, ?)')
+    end
+
+    it 'should insert parsed rows in batches' do
+      io = StringIO.new(%(id,name,value\n1,"a,""b""",1.5\n2,,2\n3,c,-0.25\n))
+
+      expect(statement.copy_in(io, headers: true, batch_size: 2))
+        .to eq(rows: 3, batches: 2, skipped: 0, first_bad_line: nil)
+
+      _, result = connection.execute_direct('SELECT id, "_bounded_string_", "_double_" FROM sqlanywhere2_test WHERE id > 0')
+      expect(result.rows).to eq([[1, 'a,"b"', 1.5], [2, nil, 2.0], [3, 'c', -0.25]])
+    end
+
+    it 'should skip rows which cannot be converted and report the first bad line' do
+      io = StringIO.new("1\ta\t1\nx\tb\t2\n3\tc\n4\t\\N\t4\n")
+
+      expect(statement.copy_in(io, format: :tsv)).to eq(rows: 2, batches: 1, skipped: 2, first_bad_line: 2)
+    end
+
+    it 'should raise an error for statement without parameters' do
+      expect { connection.prepare('SELECT 1').copy_in(StringIO.new) }.to raise_error(SQLAnywhere2::Error)
+    end
+  end
+
+  context '#stats' do
+    it 'should include rows which are still streamed' do
+      statement = connection.prepare('SELECT row_num, CAST(row_num AS VARCHAR(10)) FROM sa_rowgenerator(1, 5)')
+      statement.execute(stream: true)
+
+      statement.each_row { break }
+
+      expect(statement.stats).to include(executions: 1, rows: 1)
+      expect(statement.stats[:fetched_bytes]).to be > 0
+    end
+
+    it 'should count bind bytes' do
+      statement = connection.prepare('SELECT ?, ?')
+      statement.execute('abc', 1)
+
+      expect(statement.stats[:bind_bytes]).to eq(11)
+    end
+  end
+
   context '#last_result' do
     it 'should return last stored result for a prepared statement' do
       statement = connection.prepare('SELECT 1')
@@ -321,5 +703,12 @@ RSpec.describe SQLAnywhere2::Statement do
       expect(columns.first).to be_an_instance_of(SQLAnywhere2::Column)
       expect(columns.first.name).to eq('1')
     end
+
+    it 'should reuse frozen columns between executions' do
+      statement = connection.prepare('SELECT 1')
+
+      expect(statement.execute.columns).to be_frozen
+      expect(statement.execute.columns).to equal(statement.columns)
+    end
   end
 end